@@ -0,0 +1,452 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Boot latency regression bench: the loader_host_stage1 and
+ * loader_host_stage2 builds boot a flash image one after the other, stage 1
+ * loading stage 2 and stage 2 the application, for every image size,
+ * plain, AES ciphered or with an HMAC digest and the MAC key fused, and
+ * state of the APP and BAK slots:
+ *
+ *   identical    both slots hold the same image
+ *   app_corrupt  a payload byte of APP is flipped, BAK restores it
+ *   bak_corrupt  a payload byte of BAK is flipped, APP is written over it
+ *   differ       APP holds a newer image than BAK, it is copied to BAK
+ *
+ * Each case must boot the expected payload, deciphered, with both slots
+ * left holding it. The simulated time of each boot phase main.c marks is
+ * printed as CSV and checked against the budget file, whose lines are
+ *
+ *   <stage>.<phase>|total <state>|* <base ms> <ms per 64K of image>
+ *
+ *   ./bench_boot_sim loader_host_stage1 loader_host_stage2 bench_boot.budget
+ *
+ * The exit status is 1 when a case fails or a budget is exceeded.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "aes.h"
+#include "sha256.h"
+#include "sim.h"
+
+/* Slots as main.c lays them out for each stage */
+#define STAGE2_APP_ADDR (64 * 1024)
+#define STAGE2_BAK_ADDR (2 * 64 * 1024)
+#define APP_ADDR (3 * 64 * 1024)
+#define BAK_ADDR ((3 * 64 + 320) * 1024)
+#define FLASH_SIZE (BAK_ADDR + 320 * 1024)
+/* what loader_host -r saves */
+#define RAM_DUMP_SIZE (320 * 1024)
+
+#define STAGE2_PAYLOAD (40 * 1024)
+/* flag, length and digest */
+#define IMAGE_OVERHEAD (1 + 4 + SHA256_HASH_SIZE)
+#define FLAG_AES 0x01
+#define FLAG_MAC 0x04
+
+#define MAX_BUDGETS 64
+
+enum slot_state { IDENTICAL, APP_CORRUPT, BAK_CORRUPT, DIFFER, STATE_COUNT };
+
+static const char *const state_names[STATE_COUNT] = {
+	"identical", "app_corrupt", "bak_corrupt", "differ"
+};
+
+/* Every image of a MAC case carries an HMAC, as the fused key requires */
+enum cipher { PLAIN, AES, MAC, CIPHER_COUNT };
+
+static const char *const cipher_names[CIPHER_COUNT] = { "plain", "aes", "mac" };
+
+static const uint32_t image_sizes[] = { 64, 128, 192, 256, 320 };
+
+/* Marked by boot_phase() in main.c, in this order */
+static const char *const phase_names[] = { "init", "bak_check", "app_check",
+					   "sync", "jump" };
+#define PHASES (sizeof(phase_names) / sizeof(phase_names[0]))
+
+struct budget {
+	char phase[32];
+	char state[32];
+	double base_ms;
+	double per_64k_ms;
+};
+
+static struct budget budgets[MAX_BUDGETS];
+static int budget_count;
+
+static const uint8_t aes_key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae,
+				     0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88,
+				     0x09, 0xcf, 0x4f, 0x3c };
+static const uint8_t mac_key[32] = "bench_boot image MAC key, 32 B.";
+
+static char tmp_dir[] = "/tmp/bench_boot.XXXXXX";
+static const char *const tmp_files[] = { "aes.key", "mac.key", "flash0.bin",
+					 "flash1.bin", "flash2.bin", "ram.bin" };
+
+static void fill_payload(uint8_t *buf, uint32_t len, uint32_t seed)
+{
+	uint32_t x = seed * 2654435761U + 1, i;
+
+	for (i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = (uint8_t)x;
+	}
+}
+
+/*
+ * flag | length | payload | SHA256, ciphered in place for AES, the digest
+ * an HMAC-SHA256 for MAC
+ */
+static uint32_t make_image(uint8_t *out, const uint8_t *payload,
+			   uint32_t len, enum cipher cipher)
+{
+	SHA256Context sha256_context;
+	HMACSHA256Context hmac_context;
+	uint8_t iv[16] = { 0 };
+
+	out[0] = cipher == AES ? FLAG_AES : cipher == MAC ? FLAG_MAC : 0;
+	memcpy(out + 1, &len, 4);
+	if (cipher == AES) {
+		aes_init((uint8_t *)aes_key, 16, iv, 16, NULL, AES_CBC,
+			 AES_ENCRPTION, 0, len);
+		aes_process((uint8_t *)payload, out + 5, len, AES_CBC);
+	} else {
+		memcpy(out + 5, payload, len);
+	}
+	if (cipher == MAC) {
+		hmac_sha256_init(&hmac_context, mac_key, sizeof(mac_key),
+				 len + 5);
+		hmac_sha256_update(&hmac_context, out, len + 5);
+		hmac_sha256_final(&hmac_context, out + 5 + len);
+	} else {
+		sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, len + 5,
+			    &sha256_context);
+		sha256_update(&sha256_context, out, len + 5);
+		sha256_final(&sha256_context, out + 5 + len);
+	}
+	return len + IMAGE_OVERHEAD;
+}
+
+static void write_file(const char *path, const void *buf, size_t len)
+{
+	FILE *f = fopen(path, "wb");
+
+	if (!f || fwrite(buf, 1, len, f) != len) {
+		perror(path);
+		exit(2);
+	}
+	fclose(f);
+}
+
+static void read_file(const char *path, void *buf, size_t len)
+{
+	FILE *f = fopen(path, "rb");
+
+	memset(buf, 0xff, len);
+	if (!f) {
+		perror(path);
+		return;
+	}
+	if (fread(buf, 1, len, f) != len)
+		fprintf(stderr, "%s: short read\n", path);
+	fclose(f);
+}
+
+static void tmp_path(char *path, size_t size, const char *name)
+{
+	snprintf(path, size, "%s/%s", tmp_dir, name);
+}
+
+/*
+ * Boot flash_in with one loader stage, phase times in ms go to ms[]. mac
+ * is the MAC key file to fuse or NULL, opt one more loader option or NULL.
+ * Returns the exit status of the loader.
+ */
+static int run_stage(const char *loader, const char *flash_in,
+		     const char *flash_out, const char *ram_out,
+		     const char *key, const char *mac, const char *opt,
+		     double ms[PHASES])
+{
+	char line[256], name[64];
+	const char *args[12];
+	double t;
+	FILE *f;
+	pid_t pid;
+	int fds[2], status, n = 0;
+	size_t i;
+
+	args[n++] = loader;
+	args[n++] = "-a";
+	args[n++] = key;
+	if (mac) {
+		args[n++] = "-m";
+		args[n++] = mac;
+	}
+	args[n++] = "-w";
+	args[n++] = flash_out;
+	args[n++] = "-r";
+	args[n++] = ram_out;
+	if (opt)
+		args[n++] = opt;
+	args[n++] = flash_in;
+	args[n] = NULL;
+
+	for (i = 0; i < PHASES; i++)
+		ms[i] = -1;
+	if (pipe(fds) != 0) {
+		perror("pipe");
+		exit(2);
+	}
+	pid = fork();
+	if (pid == 0) {
+		close(fds[0]);
+		dup2(fds[1], STDERR_FILENO);
+		if (!freopen("/dev/null", "w", stdout))
+			_exit(2);
+		execv(loader, (char *const *)args);
+		perror(loader);
+		_exit(2);
+	}
+	close(fds[1]);
+	f = fdopen(fds[0], "r");
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "sim: phase %63s %lf ms", name, &t) != 2)
+			continue;
+		for (i = 0; i < PHASES; i++) {
+			if (!strcmp(name, phase_names[i]))
+				ms[i] = t;
+		}
+	}
+	fclose(f);
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+		return -1;
+	return WEXITSTATUS(status);
+}
+
+static void load_budgets(const char *path)
+{
+	char line[256];
+	struct budget *b;
+	FILE *f = fopen(path, "r");
+
+	if (!f) {
+		perror(path);
+		exit(2);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		if (budget_count == MAX_BUDGETS) {
+			fprintf(stderr, "%s: too many budgets\n", path);
+			exit(2);
+		}
+		b = &budgets[budget_count];
+		if (sscanf(line, "%31s %31s %lf %lf", b->phase, b->state,
+			   &b->base_ms, &b->per_64k_ms) != 4) {
+			fprintf(stderr, "%s: bad line: %s", path, line);
+			exit(2);
+		}
+		budget_count++;
+	}
+	fclose(f);
+}
+
+/* Returns the number of budgets phase is over */
+static int check_budget(const char *phase, const char *state, uint32_t size,
+			double ms, const char *label)
+{
+	double limit;
+	int i, over = 0;
+
+	for (i = 0; i < budget_count; i++) {
+		struct budget *b = &budgets[i];
+
+		if (strcmp(b->phase, phase) ||
+		    (strcmp(b->state, "*") && strcmp(b->state, state)))
+			continue;
+		limit = b->base_ms + b->per_64k_ms * size / 64;
+		if (ms > limit) {
+			fprintf(stderr, "budget: %s %s %.3f ms > %.3f ms\n",
+				label, phase, ms, limit);
+			over++;
+		}
+	}
+	return over;
+}
+
+struct boot_case {
+	uint32_t size;
+	enum cipher cipher;
+	enum slot_state state;
+};
+
+/* Returns the number of failures of one case */
+static int run_case(const char *stage1, const char *stage2,
+		    const struct boot_case *c)
+{
+	static uint8_t flash[FLASH_SIZE], result[FLASH_SIZE];
+	static uint8_t old[RAM_DUMP_SIZE], new[RAM_DUMP_SIZE];
+	static uint8_t image[RAM_DUMP_SIZE], expect[RAM_DUMP_SIZE];
+	static uint8_t ram[RAM_DUMP_SIZE];
+	char key[256], mac[256], flash0[256], flash1[256], flash2[256];
+	char ram_file[256];
+	char label[64], phase[48];
+	double ms[2][PHASES], total = 0;
+	uint32_t len = c->size * 1024 - 64, image_len;
+	const char *state = state_names[c->state];
+	const char *cipher = cipher_names[c->cipher];
+	const char *mac_file = c->cipher == MAC ? mac : NULL;
+	int ret[2], failed = 0, s;
+	size_t i;
+
+	tmp_path(key, sizeof(key), "aes.key");
+	tmp_path(mac, sizeof(mac), "mac.key");
+	tmp_path(flash0, sizeof(flash0), "flash0.bin");
+	tmp_path(flash1, sizeof(flash1), "flash1.bin");
+	tmp_path(flash2, sizeof(flash2), "flash2.bin");
+	tmp_path(ram_file, sizeof(ram_file), "ram.bin");
+	snprintf(label, sizeof(label), "%uK %s %s", c->size, cipher, state);
+
+	memset(flash, 0xff, sizeof(flash));
+	/* stage 2 itself, both slots the same */
+	fill_payload(old, STAGE2_PAYLOAD, 2);
+	image_len = make_image(image, old, STAGE2_PAYLOAD,
+			       c->cipher == MAC ? MAC : PLAIN);
+	memcpy(flash + STAGE2_APP_ADDR, image, image_len);
+	memcpy(flash + STAGE2_BAK_ADDR, image, image_len);
+
+	/* the application, APP newer than BAK when they differ */
+	fill_payload(old, len, c->size);
+	fill_payload(new, len, c->size + 1);
+	image_len = make_image(image, old, len, c->cipher);
+	memcpy(flash + BAK_ADDR, image, image_len);
+	memcpy(expect, old, len);
+	if (c->state == DIFFER) {
+		image_len = make_image(image, new, len, c->cipher);
+		memcpy(expect, new, len);
+	}
+	memcpy(flash + APP_ADDR, image, image_len);
+	if (c->state == APP_CORRUPT)
+		flash[APP_ADDR + 5 + len / 2] ^= 0x01;
+	if (c->state == BAK_CORRUPT)
+		flash[BAK_ADDR + 5 + len / 2] ^= 0x01;
+	write_file(flash0, flash, sizeof(flash));
+
+	ret[0] = run_stage(stage1, flash0, flash1, ram_file, key, mac_file,
+			   NULL, ms[0]);
+	/* the application side of the service table is checked as well */
+	ret[1] = run_stage(stage2, flash1, flash2, ram_file, key, mac_file,
+			   "-v", ms[1]);
+
+	if (ret[0] != 0 || ret[1] != 0) {
+		fprintf(stderr, "fail: %s exit %d and %d\n", label, ret[0],
+			ret[1]);
+		failed++;
+	} else {
+		read_file(ram_file, ram, sizeof(ram));
+		if (memcmp(ram, expect, len)) {
+			fprintf(stderr, "fail: %s wrong payload booted\n",
+				label);
+			failed++;
+		}
+		read_file(flash2, result, sizeof(result));
+		if (memcmp(result + APP_ADDR, image, image_len) ||
+		    memcmp(result + BAK_ADDR, image, image_len)) {
+			fprintf(stderr, "fail: %s slots not in sync\n", label);
+			failed++;
+		}
+	}
+
+	printf("boot,%u,%s,%s", c->size, cipher, state);
+	for (s = 0; s < 2; s++) {
+		for (i = 0; i < PHASES; i++) {
+			printf(",%.3f", ms[s][i]);
+			total += ms[s][i] > 0 ? ms[s][i] : 0;
+			snprintf(phase, sizeof(phase), "s%d.%s", s + 1,
+				 phase_names[i]);
+			failed += check_budget(phase, state, c->size,
+					       ms[s][i], label);
+		}
+	}
+	failed += check_budget("total", state, c->size, total, label);
+	printf(",%.3f,%s\n", total, failed ? "FAIL" : "ok");
+	fflush(stdout);
+
+	return failed;
+}
+
+int main(int argc, char *argv[])
+{
+	struct boot_case c;
+	char key[256];
+	int failed = 0, cipher, s;
+	size_t i, p;
+
+	if (argc != 4) {
+		fprintf(stderr,
+			"%s <loader_host_stage1> <loader_host_stage2> <budget>\n",
+			argv[0]);
+		return 2;
+	}
+	load_budgets(argv[3]);
+	if (!mkdtemp(tmp_dir)) {
+		perror(tmp_dir);
+		return 2;
+	}
+	tmp_path(key, sizeof(key), "aes.key");
+	write_file(key, aes_key, sizeof(aes_key));
+	tmp_path(key, sizeof(key), "mac.key");
+	write_file(key, mac_key, sizeof(mac_key));
+
+	sim_sha256_attach();
+	sim_aes_attach();
+
+	printf("boot,size_k,cipher,state");
+	for (s = 1; s <= 2; s++) {
+		for (p = 0; p < PHASES; p++)
+			printf(",s%d.%s_ms", s, phase_names[p]);
+	}
+	printf(",total_ms,result\n");
+	/* or the loaders inherit what is buffered */
+	fflush(stdout);
+
+	for (i = 0; i < sizeof(image_sizes) / sizeof(image_sizes[0]); i++) {
+		for (cipher = 0; cipher < CIPHER_COUNT; cipher++) {
+			for (s = 0; s < STATE_COUNT; s++) {
+				c.size = image_sizes[i];
+				c.cipher = cipher;
+				c.state = s;
+				failed += run_case(argv[1], argv[2], &c) != 0;
+			}
+		}
+	}
+
+	for (i = 0; i < sizeof(tmp_files) / sizeof(tmp_files[0]); i++) {
+		tmp_path(key, sizeof(key), tmp_files[i]);
+		unlink(key);
+	}
+	rmdir(tmp_dir);
+
+	printf("%d case(s) failed\n", failed);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build of the "bench" command on top of the SHA256 and AES register
+ * models. Known answer tests make sure the drivers and models agree with
+ * FIPS 180-2, RFC 4231 and SP 800-38A, and the CRCs with their check values, before
+ * any number is printed.
+ *
+ *   ./bench_crypto [name] > bench.csv
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aes.h"
+#include "bench.h"
+#include "crc.h"
+#include "sha256.h"
+#include "sim.h"
+
+static int check(const char *name, const uint8_t *got, const uint8_t *expect,
+		 size_t len)
+{
+	int ok = memcmp(got, expect, len) == 0;
+
+	printf("check,%s,%s\n", name, ok ? "ok" : "FAIL");
+	return ok ? 0 : 1;
+}
+
+/* FIPS 180-2 B.1 */
+static int check_sha256(void)
+{
+	static const uint8_t expect[SHA256_HASH_SIZE] = {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+	};
+	SHA256Context sha256_context;
+	uint8_t hash[SHA256_HASH_SIZE];
+
+	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, 3, &sha256_context);
+	sha256_update(&sha256_context, "abc", 3);
+	sha256_final(&sha256_context, hash);
+	return check("sha256-kat", hash, expect, sizeof(expect));
+}
+
+/* RFC 4231 test case 2 */
+static int check_hmac_sha256(void)
+{
+	static const uint8_t expect[SHA256_HASH_SIZE] = {
+		0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e,
+		0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+		0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+		0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43
+	};
+	static const char data[] = "what do ya want for nothing?";
+	HMACSHA256Context hmac_context;
+	uint8_t mac[SHA256_HASH_SIZE];
+
+	hmac_sha256_init(&hmac_context, (const uint8_t *)"Jefe", 4,
+			 sizeof(data) - 1);
+	hmac_sha256_update(&hmac_context, data, 10);
+	hmac_sha256_update(&hmac_context, data + 10, sizeof(data) - 1 - 10);
+	hmac_sha256_final(&hmac_context, mac);
+	return check("hmac-sha256-kat", mac, expect, sizeof(expect));
+}
+
+/* SP 800-38A F.2.1 and F.2.2, first two blocks */
+static int check_aes(void)
+{
+	static const uint8_t key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae,
+					 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88,
+					 0x09, 0xcf, 0x4f, 0x3c };
+	static const uint8_t iv[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+					0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+					0x0c, 0x0d, 0x0e, 0x0f };
+	static const uint8_t plain[32] = {
+		0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e,
+		0x11, 0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03,
+		0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51
+	};
+	static const uint8_t cipher[32] = {
+		0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e,
+		0x9b, 0x12, 0xe9, 0x19, 0x7d, 0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72,
+		0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2
+	};
+	struct aes_session session;
+	uint8_t out[32];
+	int failed = 0;
+
+	aes_init((uint8_t *)key, 16, (uint8_t *)iv, 16, NULL, AES_CBC,
+		 AES_ENCRPTION, 0, sizeof(plain));
+	aes_process((uint8_t *)plain, out, sizeof(plain), AES_CBC);
+	failed += check("aes-cbc-enc-kat", out, cipher, sizeof(cipher));
+
+	/* 16 bytes per aes_process(), like flash_image_check() */
+	aes_init((uint8_t *)key, 16, (uint8_t *)iv, 16, NULL, AES_CBC,
+		 AES_DENCRPTION, 0, sizeof(cipher));
+	aes_process((uint8_t *)cipher, out, 16, AES_CBC);
+	aes_process((uint8_t *)cipher + 16, out + 16, 16, AES_CBC);
+	failed += check("aes-cbc-dec-kat", out, plain, sizeof(plain));
+
+	/* Session with the OTP key, in place, second block chained on the first */
+	sim_otp_set_aes_key(key);
+	memcpy(out, cipher, sizeof(cipher));
+	aes_session_open(&session, AES_SESSION_OTP_KEY);
+	aes_session_decrypt(&session, out, out, 16, iv);
+	aes_session_decrypt(&session, out + 16, out + 16, 16, NULL);
+	failed += check("aes-session-otp", out, plain, sizeof(plain));
+	aes_session_close(&session);
+	/* OTP key output must be off once the session is closed */
+	printf("check,aes-session-closed,%s\n",
+	       sim_otp_key_output(out) ? "FAIL" : "ok");
+	failed += sim_otp_key_output(out);
+
+	return failed;
+}
+
+/* Check values for "123456789", then sliced vs byte at a time on odd splits */
+static int check_crc(void)
+{
+	static const uint8_t digits[] = "123456789";
+	static const uint16_t crc16_check = 0xBB3D;
+	static const uint32_t crc32c_check = 0xE3069283;
+	uint8_t buf[1024];
+	uint16_t crc16, crc16_bytes;
+	uint32_t crc32c, crc32c_bytes;
+	int failed = 0;
+	size_t i;
+
+	crc16 = crc_16(digits, 9);
+	failed += check("crc16-kat", (uint8_t *)&crc16,
+			(const uint8_t *)&crc16_check, 2);
+	crc32c = crc32c_update(CRC_START_32C, digits, 9);
+	failed += check("crc32c-kat", (uint8_t *)&crc32c,
+			(const uint8_t *)&crc32c_check, 4);
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (uint8_t)(i * 131 + 7);
+	crc16 = crc16_update(CRC_START_16, buf + 3, 77);
+	crc16 = crc16_update(crc16, buf + 80, sizeof(buf) - 80);
+	crc32c = crc32c_update(CRC_START_32C, buf + 3, 77);
+	crc32c = crc32c_update(crc32c, buf + 80, sizeof(buf) - 80);
+	crc16_bytes = CRC_START_16;
+	crc32c_bytes = CRC_START_32C;
+	for (i = 3; i < sizeof(buf); i++) {
+		crc16_bytes = crc16_update(crc16_bytes, buf + i, 1);
+		crc32c_bytes = crc32c_update(crc32c_bytes, buf + i, 1);
+	}
+	failed += check("crc16-incremental", (uint8_t *)&crc16,
+			(uint8_t *)&crc16_bytes, 2);
+	failed += check("crc32c-incremental", (uint8_t *)&crc32c,
+			(uint8_t *)&crc32c_bytes, 4);
+
+	return failed;
+}
+
+int main(int argc, char *argv[])
+{
+	uint8_t *buf;
+	int failed = 0;
+
+	sim_sha256_attach();
+	sim_aes_attach();
+	sim_otp_attach();
+
+	failed += check_sha256();
+	failed += check_hmac_sha256();
+	failed += check_aes();
+	failed += check_crc();
+	if (failed)
+		return EXIT_FAILURE;
+
+	buf = malloc(BENCH_BUF_SIZE);
+	if (!buf)
+		return EXIT_FAILURE;
+	failed = bench_run(buf, argc > 1 ? argv[1] : NULL);
+	free(buf);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
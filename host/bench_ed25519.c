@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host benchmark and known answer test for ed25519_verify().
+ *
+ * Vectors 1-3 are from RFC 8032 section 7.1, the last one is an image
+ * digest signed by utils/ed25519.py the same way genimg.py does it.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ed25519.h"
+
+#define BENCH_ROUNDS 200
+
+struct ed25519_vector {
+	const char *public_key;
+	const char *message;
+	const char *signature;
+};
+
+static const struct ed25519_vector vectors[] = {
+	{ "d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a",
+	  "",
+	  "e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e06522490155"
+	  "5fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b" },
+	{ "3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c",
+	  "72",
+	  "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da"
+	  "085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00" },
+	{ "fc51cd8e6218a1a38da47ed00230f0580816ed13ba3303ac5deb911548908025",
+	  "af82",
+	  "6291d657deec24024827e69c3abe01a30ce548a284743a445e3680d7db5ac3ac"
+	  "18ff9b538d16f290ae67f760984dc6594a7c15e9716ed28dc027beceea1ec40a" },
+	{ "0a16a3795c63223381a33bf22b7d2164ed98608de7d937e50ed7e132fe713d72",
+	  "3e85c111e2394edf16db542993a653f63e06c3237cc50018139760d9fa3db17c",
+	  "91fc65a09c75e363e376e568d37a06fddd79b63a68d325dd1d74b6953b3c5447"
+	  "40c65d1ce670bddb547f558bf331146ce5d6c5a28e80169343dc358d6d03ad0d" },
+};
+
+static size_t unhex(uint8_t *out, const char *hex)
+{
+	size_t n = 0;
+	unsigned int v;
+
+	while (hex[0] && hex[1] && sscanf(hex, "%2x", &v) == 1) {
+		out[n++] = (uint8_t)v;
+		hex += 2;
+	}
+	return n;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int check(const char *name, int got, int expect)
+{
+	printf("%-40s %s\n", name, got == expect ? "ok" : "FAIL");
+	return got == expect ? 0 : 1;
+}
+
+int main(void)
+{
+	uint8_t pub[32], sig[64], msg[64], tmp[64];
+	size_t len;
+	uint64_t t0, t1;
+	int i, failed = 0;
+	char name[64];
+
+	for (i = 0; i < (int)(sizeof(vectors) / sizeof(vectors[0])); i++) {
+		unhex(pub, vectors[i].public_key);
+		unhex(sig, vectors[i].signature);
+		len = unhex(msg, vectors[i].message);
+
+		snprintf(name, sizeof(name), "vector %d valid", i + 1);
+		failed += check(name, ed25519_verify(sig, msg, len, pub), 0);
+
+		memcpy(tmp, sig, 64);
+		tmp[5] ^= 0x01;
+		snprintf(name, sizeof(name), "vector %d R modified", i + 1);
+		failed += check(name, ed25519_verify(tmp, msg, len, pub), -1);
+
+		memcpy(tmp, sig, 64);
+		tmp[40] ^= 0x10;
+		snprintf(name, sizeof(name), "vector %d S modified", i + 1);
+		failed += check(name, ed25519_verify(tmp, msg, len, pub), -1);
+
+		memcpy(tmp, sig, 64);
+		tmp[63] |= 0xe0;
+		snprintf(name, sizeof(name), "vector %d S not reduced", i + 1);
+		failed += check(name, ed25519_verify(tmp, msg, len, pub), -1);
+
+		if (len) {
+			msg[len - 1] ^= 0x80;
+			snprintf(name, sizeof(name), "vector %d message modified",
+				 i + 1);
+			failed += check(name,
+					ed25519_verify(sig, msg, len, pub), -1);
+			msg[len - 1] ^= 0x80;
+		}
+
+		memcpy(tmp, pub, 32);
+		tmp[0] ^= 0x02;
+		snprintf(name, sizeof(name), "vector %d key modified", i + 1);
+		failed += check(name, ed25519_verify(sig, msg, len, tmp), -1);
+	}
+
+	/* Time the image digest case, it is what the loader runs */
+	unhex(pub, vectors[3].public_key);
+	unhex(sig, vectors[3].signature);
+	len = unhex(msg, vectors[3].message);
+
+	t0 = now_ns();
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		failed += ed25519_verify(sig, msg, len, pub) != 0;
+	t1 = now_ns();
+
+	printf("ed25519_verify: %d rounds, %.1f us/verify\n", BENCH_ROUNDS,
+	       (double)(t1 - t0) / BENCH_ROUNDS / 1000.0);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1 @@
+/* Host build: newlib <machine/syscall.h> is only needed on the target */
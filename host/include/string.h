@@ -0,0 +1,11 @@
+/* Host build: glibc before 2.38 lacks the newlib strlcpy() cli.c uses */
+#include_next <string.h>
+
+#ifndef __HOST_STRING_H_
+#define __HOST_STRING_H_
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
+
+#endif /* __HOST_STRING_H_ */
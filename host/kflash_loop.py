@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Loopback check of kflash.py --loader on Linux: the host build of stage 1
+# boots on a pty while kflash sends the machine mode magic, as a board reset
+# during the catch window would. The caught loader programs a sparse image
+# at a negotiated rate and resets, the saved flash must hold the image. The
+# same image again must cost no sector, a new app only the app sectors, and
+# without a loader kflash must give up for the ROM ISP. A flash the loader
+# cannot read must fail with its error, not be programmed. A loader caught
+# and then left alone must go back to booting, and bytes other than the
+# whole magic must not stop the boot.
+#
+# Usage: kflash_loop.py <loader_host_stage1>
+
+import sys
+import os
+import io
+import re
+import types
+import contextlib
+import argparse
+import subprocess
+import tempfile
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', 'utils'))
+# kflash imports pyserial for the ROM ISP only, the loader path runs without
+for name in ('serial', 'serial.tools', 'serial.tools.list_ports'):
+    sys.modules.setdefault(name, types.ModuleType(name))
+import kflash
+import flashmap
+import loadx
+import rpc
+
+CATCH = 3.0
+# Time from the first magic to the simulated reset
+RESET_DELAY = 0.3
+BAUD = 3000000
+# CONFIG_CLI_IDLE_TIMEOUT of the host build, see CMakeLists.txt
+IDLE = 2.0
+SIM_FLASH_SIZE = 16 * 1024 * 1024
+# Flash byte the loader cannot read in the unreadable case
+BAD_READ = flashmap.partition('app')[0] + 0x1005
+
+# (partition, length)
+EXTENTS = [
+    ('stage2_app', 40 * 1024),
+    ('app', 300 * 1024),
+    ('feature', 600 * 1024),
+]
+
+
+def image(parts):
+    out = tempfile.NamedTemporaryFile(suffix='.simg', delete=False)
+    out.close()
+    flashmap.write_sparse(out.name, [
+        flashmap.extent(name, flashmap.partition(name)[0], data)
+        for name, data in parts])
+    return out.name
+
+
+def reset_later(exe, master, args, procs):
+    """Start the loader on the pty after RESET_DELAY, as a board reset"""
+    def reset():
+        time.sleep(RESET_DELAY)
+        procs.append(subprocess.Popen(
+            [exe] + args, stdin=master, stdout=master,
+            stderr=subprocess.DEVNULL))
+
+    threading.Thread(target=reset).start()
+
+
+def run(exe, name, flash, parts, catch, expect, bad=None):
+    """Flash parts over flash (None for no loader), expect sectors sent or,
+    with the flash unreadable at bad, the read error"""
+    simg = image(parts)
+    master, slave = os.openpty()
+    port = loadx.Port(os.ttyname(slave), 115200)
+    os.close(slave)
+    out = tempfile.NamedTemporaryFile(suffix='.bin', delete=False)
+    out.close()
+    procs = []
+    opts = ['-o', str(bad)] if bad is not None else []
+
+    if flash:
+        reset_later(exe, master, ['-w', out.name] + opts + [flash], procs)
+    args = argparse.Namespace(loader=catch, baudrate=BAUD, firmware=simg,
+                              key=None)
+    log = io.StringIO()
+    ok = False
+    error = None
+    spent = 0
+    start = time.time()
+    try:
+        with contextlib.redirect_stdout(log):
+            try:
+                done = kflash.flash_through_loader(
+                    args, port, kflash.ProgramFileFormat.FMT_SPARSE)
+            except rpc.RpcError as e:
+                done, error = False, str(e)
+        spent = time.time() - start
+        port.close()
+        if procs and error is None:
+            procs[0].wait(5)
+        programmed = [int(n) for n in re.findall(
+            r'(\d+) of \d+ sectors programmed in', log.getvalue())]
+        baud = re.findall(r'Baudrate changed to (\d+)', log.getvalue())
+        if bad is not None:
+            ok = not programmed and error is not None and \
+                error.endswith(rpc.ERRORS[5])
+        elif flash:
+            data = open(out.name, 'rb').read()
+            ok = done and procs[0].returncode == 0 and \
+                baud == [str(BAUD)] and len(data) == SIM_FLASH_SIZE and \
+                programmed == [expect] and \
+                all(data[off:off + len(d)] == d for off, d in
+                    ((flashmap.partition(n)[0], d) for n, d in parts))
+        else:
+            ok = not done and spent < catch + 1
+    finally:
+        for p in procs:
+            if p.poll() is None:
+                p.kill()
+        os.close(master)
+        os.unlink(simg)
+    print('%s,%s,%.2f s,%s sectors' % ('ok' if ok else 'FAIL', name, spent,
+                                       programmed[0] if programmed else '-'))
+    return ok, out.name
+
+
+def idle(exe, flash):
+    """Catch the loader and send nothing more, it must boot after IDLE"""
+    master, slave = os.openpty()
+    port = loadx.Port(os.ttyname(slave), 115200)
+    os.close(slave)
+    procs = []
+    reset_later(exe, master, [flash], procs)
+    ok = False
+    spent = 0
+    try:
+        rpc.Loader(port, catch=CATCH)
+        start = time.time()
+        out = b''
+        while time.time() - start < IDLE + 2 and procs[0].poll() is None:
+            out += port.read(0.1)
+        spent = time.time() - start
+        out += port.read(0.1)
+        ok = procs[0].poll() is not None and spent > IDLE and \
+            b'## CLI idle, booting' in out
+    except rpc.RpcError:
+        pass
+    finally:
+        for p in procs:
+            if p.poll() is None:
+                p.kill()
+        port.close()
+        os.close(master)
+    print('%s,idle,%.2f s,- sectors' % ('ok' if ok else 'FAIL', spent))
+    return ok
+
+
+def noise(exe, flash):
+    """Send the keys and the magic start that no longer stop the boot"""
+    master, slave = os.openpty()
+    port = loadx.Port(os.ttyname(slave), 115200)
+    os.close(slave)
+    procs = []
+    reset_later(exe, master, [flash], procs)
+    out = b''
+    start = time.time()
+    try:
+        while time.time() - start < RESET_DELAY + 2 and \
+                (not procs or procs[0].poll() is None):
+            port.write(b'kK\x16')
+            out += port.read(rpc.CATCH_INTERVAL)
+        spent = time.time() - start
+        out += port.read(0.1)
+        ok = procs and procs[0].poll() is not None and \
+            b'Entering CLI' not in out
+    finally:
+        for p in procs:
+            if p.poll() is None:
+                p.kill()
+        port.close()
+        os.close(master)
+    print('%s,noise,%.2f s,- sectors' % ('ok' if ok else 'FAIL', spent))
+    return ok
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(sys.argv[0] + ' <loader_host_stage1>')
+        sys.exit(2)
+    exe = sys.argv[1]
+    # no CLI readline() delay to wait for here
+    loadx.CMD_CHAR_DELAY = 0
+    parts = [(name, os.urandom(length)) for name, length in EXTENTS]
+    sectors = sum(len(d) // flashmap.SECTOR for _, d in parts)
+
+    blank = tempfile.NamedTemporaryFile(suffix='.bin', delete=False)
+    blank.write(b'\xff' * SIM_FLASH_SIZE)
+    blank.close()
+    files = [blank.name]
+    results = []
+    try:
+        ok, flash = run(exe, 'first', blank.name, parts, CATCH, sectors)
+        files.append(flash)
+        results.append(ok)
+        ok, again = run(exe, 'unchanged', flash, parts, CATCH, 0)
+        files.append(again)
+        results.append(ok)
+        app = bytearray(parts[1][1])
+        for off in (0, 100 * 1024, len(app) - 1):
+            app[off] ^= 0xff
+        changed = [parts[0], ('app', bytes(app)), parts[2]]
+        ok, new = run(exe, 'app', flash, changed, CATCH, 3)
+        files.append(new)
+        results.append(ok)
+        ok, none = run(exe, 'absent', None, parts, 0.5, 0)
+        files.append(none)
+        results.append(ok)
+        ok, bad = run(exe, 'unreadable', blank.name, parts, CATCH, 0,
+                      BAD_READ)
+        files.append(bad)
+        results.append(ok)
+        results.append(idle(exe, blank.name))
+        results.append(noise(exe, blank.name))
+    finally:
+        for f in files:
+            os.unlink(f)
+    sys.exit(0 if all(results) else 1)
+
+
+if __name__ == '__main__':
+    main()
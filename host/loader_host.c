@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build of the loader core: main.c, the CLI and the drivers run against
+ * the register models of the SPI3 flash, SHA256, AES, OTP and UARTHS blocks.
+ * The console is stdin/stdout, the flash starts from a file and the fuses
+ * from key files. SRAM is mapped at RAM_BASE_ADDR so the addresses the CLI
+ * takes and _boot are the target ones.
+ *
+ *   ./loader_host_stage2 [-a aes.key] [-m mac.key] [-p otp_hash.bin]
+ *                        [-w out.bin] [-r ram.bin] [-s spi_clk] [-t] [-v]
+ *                        [-l] [-k write] [-o floffset] [-c] <flash.bin>
+ *
+ * Without -c the boot path runs: the exit status is 0 once go_boot() is
+ * reached and the EXIT_REASON otherwise. -c starts the CLI instead, input from
+ * a pipe or a file is paced by its prompt, a tool on a terminal or pty waits
+ * for it itself and may switch to machine mode, the run ends once the input
+ * stays idle for CONFIG_CLI_IDLE_TIMEOUT. -w saves the flash as the run
+ * left it, -r what was loaded at _boot once the jump is reached. Each boot
+ * phase main.c ends is printed on stderr with the simulated time it took.
+ * Flash bus and busy times are simulated, -s sets the SPI3 input clock in Hz
+ * and -t reports them per opcode on stderr at exit. -v goes through the stage
+ * 2 service table at the jump as an application would, the exit status is 3
+ * when it does not hold. -l logs every flash program and erase on stderr, -k
+ * cuts power on the given one, counted from 1: it is left torn, the flash is
+ * saved and the exit status is 4. The writes a boot took are printed at the
+ * jump, after those of -v. -o overruns the SPI3 RX FIFO on every dual or
+ * quad read reaching floffset.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "cli.h"
+#include "encoding.h"
+#include "otp.h"
+#include "platform.h"
+#include "svc.h"
+#include "uarths.h"
+#include "sim.h"
+
+#define SIM_FLASH_SIZE (16 * 1024 * 1024)
+/* 6 MB SRAM and 2 MB AI SRAM */
+#define SIM_RAM_SIZE (8 * 1024 * 1024)
+/* What -r saves from _boot, see common.h: the largest next stage */
+#ifdef LOADER_STAGE1
+#define SIM_BOOT_ADDR 0x80500000UL
+#else
+#define SIM_BOOT_ADDR 0x80000000UL
+#endif
+#define SIM_BOOT_DUMP (320 * 1024)
+
+extern int loader_main(void);
+
+static uint8_t sim_flash[SIM_FLASH_SIZE];
+static const char *flash_out;
+static const char *ram_out;
+static int flash_report;
+static int svc_check;
+static int write_log;
+static uint64_t cut_write;
+static uint64_t start_cycle, phase_cycle;
+
+static size_t load_file(const char *path, uint8_t *buf, size_t size)
+{
+	FILE *f = fopen(path, "rb");
+	size_t n;
+
+	if (!f) {
+		perror(path);
+		exit(2);
+	}
+	n = fread(buf, 1, size, f);
+	fclose(f);
+	return n;
+}
+
+static void fuse_file(const char *path, uint32_t addr, uint32_t size)
+{
+	uint8_t buf[32];
+
+	if (load_file(path, buf, size) != size) {
+		fprintf(stderr, "%s: %u bytes expected\n", path, size);
+		exit(2);
+	}
+	sim_otp_fuse(addr, buf, size);
+}
+
+static void save_flash(void)
+{
+	FILE *f;
+
+	if (!flash_out)
+		return;
+	f = fopen(flash_out, "wb");
+	if (!f ||
+	    fwrite(sim_flash, 1, sizeof(sim_flash), f) != sizeof(sim_flash))
+		perror(flash_out);
+	if (f)
+		fclose(f);
+}
+
+static void report_flash(void)
+{
+	if (flash_report)
+		sim_spi_flash_report(stderr);
+}
+
+static void print_ms(const char *what, uint64_t cycles)
+{
+	fprintf(stderr, "sim: %s %lu.%03lu ms\n", what,
+		(unsigned long)(cycles / (SIM_CPU_FREQ / 1000)),
+		(unsigned long)(cycles / (SIM_CPU_FREQ / 1000000) % 1000));
+}
+
+void sim_boot_phase(const char *name)
+{
+	char what[64];
+	uint64_t now = read_cycle();
+
+	snprintf(what, sizeof(what), "phase %s", name);
+	print_ms(what, now - phase_cycle);
+	phase_cycle = now;
+}
+
+#ifndef LOADER_STAGE1
+/*
+ * What an application does with the service table: hash the image it was
+ * loaded from against the boot info, run the slot copy left pending, and
+ * erase, program and read back the last sector of the jpeg partition
+ * before restoring it.
+ */
+static int check_svc_table(void)
+{
+	const struct svc_table *svc = *(struct svc_table **)SVC_TABLE_PTR;
+	const struct svc_boot_info *info;
+	const struct flash_part *part;
+	static uint8_t buf[4096], save[4096];
+	uint8_t digest[SHA256_HASH_SIZE], key[16] = { 0 };
+	struct aes_session session;
+	SHA256Context ctx;
+	uint32_t addr, total, n, i;
+	uint64_t cycles;
+	int left;
+
+	if (!svc || svc->magic != SVC_MAGIC || svc->version < 2 ||
+	    svc->size < sizeof(*svc))
+		return -1;
+	info = svc->boot_info();
+	part = svc->partition(info->sync == SVC_SYNC_BAK_TO_APP ? "bak" :
+								    "app");
+	if (!part || part->offset != info->image_offset ||
+	    svc->partition("none"))
+		return -2;
+
+	if (!(info->image_flag & (1U << 2))) {
+		total = 5 + info->image_length;
+		svc->sha256_init(&ctx, total);
+		for (addr = info->image_offset; total; total -= n) {
+			n = total > sizeof(buf) ? sizeof(buf) : total;
+			if (svc->flash_read(addr, buf, n) != 0)
+				return -3;
+			svc->sha256_update(&ctx, buf, n);
+			addr += n;
+		}
+		svc->sha256_final(&ctx, digest);
+		if (memcmp(digest, info->image_digest, sizeof(digest)) != 0)
+			return -4;
+	}
+
+	/* a copy a power cut stopped may have a single sector left */
+	cycles = read_cycle();
+	n = svc->sync_step(0);
+	if ((info->sync != SVC_SYNC_NONE) != (n > 0))
+		return -10;
+	while ((left = svc->sync_step(1)) > 0)
+		;
+	if (left < 0)
+		return -10;
+	if (n)
+		print_ms("svc sync", read_cycle() - cycles);
+
+	part = svc->partition("jpeg");
+	addr = part->offset + part->length - sizeof(buf);
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 7;
+	if (svc->flash_read(addr, save, sizeof(save)) != 0 ||
+	    svc->flash_erase(addr, sizeof(buf)) != 0 ||
+	    svc->flash_program(addr, buf, sizeof(buf)) != 0 ||
+	    svc->flash_read(addr, buf, sizeof(buf)) != 0)
+		return -5;
+	for (i = 0; i < sizeof(buf); i++) {
+		if (buf[i] != (uint8_t)(i * 7))
+			return -6;
+	}
+	svc->flash_erase(addr, sizeof(save));
+	svc->flash_program(addr, save, sizeof(save));
+	if (svc->flash_read(0x1000000, buf, 1) == 0)
+		return -7;
+
+	if (svc->aes_open(&session, AES_SESSION_OTP_KEY) == 0)
+		return -8;
+	if (svc->aes_open(&session, key) != 0 ||
+	    svc->aes_decrypt(&session, buf, buf, 32, key) != 0)
+		return -9;
+	svc->aes_close(&session);
+
+	fprintf(stderr, "sim: svc v%u, image 0x%06X %u bytes, sync %u, %s\n",
+		svc->version, info->image_offset, info->image_length,
+		info->sync, info->build);
+	return 0;
+}
+#endif
+
+void sim_boot(void)
+{
+	uint64_t cycles;
+	FILE *f;
+
+	sim_boot_phase("jump");
+	cycles = read_cycle() - start_cycle;
+	if (ram_out) {
+		f = fopen(ram_out, "wb");
+		if (!f || fwrite((void *)SIM_BOOT_ADDR, 1, SIM_BOOT_DUMP, f) !=
+				  SIM_BOOT_DUMP)
+			perror(ram_out);
+		if (f)
+			fclose(f);
+	}
+	print_ms("boot after", cycles);
+#ifndef LOADER_STAGE1
+	if (svc_check && check_svc_table() != 0) {
+		fprintf(stderr, "sim: service table check failed\n");
+		exit(3);
+	}
+#endif
+	fprintf(stderr, "sim: flash writes %lu\n",
+		(unsigned long)sim_spi_flash_writes());
+	exit(0);
+}
+
+/* The flash is saved at exit as the torn write left it */
+static void power_cut(uint64_t write)
+{
+	fprintf(stderr, "sim: power cut at write %lu\n", (unsigned long)write);
+	exit(4);
+}
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if (size) {
+		size_t n = len < size - 1 ? len : size - 1;
+
+		memcpy(dst, src, n);
+		dst[n] = 0;
+	}
+	return len;
+}
+#endif
+
+/* RAM addresses given to the CLI and _boot are used as they are */
+static void map_ram(void)
+{
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE;
+	void *ram = mmap((void *)(uintptr_t)RAM_BASE_ADDR, SIM_RAM_SIZE,
+			 PROT_READ | PROT_WRITE, flags, -1, 0);
+
+	if (ram != (void *)(uintptr_t)RAM_BASE_ADDR) {
+		fprintf(stderr, "sim: cannot map RAM at 0x%08X\n",
+			RAM_BASE_ADDR);
+		exit(2);
+	}
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"%s [-a aes.key] [-m mac.key] [-p otp_hash.bin] [-w out.bin] [-r ram.bin] [-s spi_clk] [-t] [-v] [-l] [-k write] [-o floffset] [-c] <flash.bin>\n",
+		name);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint8_t aes_key[16];
+	uint32_t spi_clk = 0;
+	long bad_read = -1;
+	int opt, cli = 0;
+
+	while ((opt = getopt(argc, argv, "a:m:p:w:r:s:tvlk:o:c")) != -1) {
+		switch (opt) {
+		case 'a':
+			if (load_file(optarg, aes_key, sizeof(aes_key)) !=
+			    sizeof(aes_key))
+				usage(argv[0]);
+			sim_otp_set_aes_key(aes_key);
+			break;
+		case 'm':
+			fuse_file(optarg, OTP_IMAGE_MAC_KEY_ADDR,
+				  OTP_IMAGE_MAC_KEY_SIZE);
+			break;
+		case 'p':
+			fuse_file(optarg, OTP_BOOT_PUBKEY_HASH_ADDR, 32);
+			break;
+		case 'w':
+			flash_out = optarg;
+			break;
+		case 'r':
+			ram_out = optarg;
+			break;
+		case 's':
+			spi_clk = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			flash_report = 1;
+			break;
+		case 'v':
+			svc_check = 1;
+			break;
+		case 'l':
+			write_log = 1;
+			break;
+		case 'k':
+			cut_write = strtoull(optarg, NULL, 0);
+			break;
+		case 'o':
+			bad_read = strtol(optarg, NULL, 0);
+			break;
+		case 'c':
+			cli = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1)
+		usage(argv[0]);
+
+	map_ram();
+	memset(sim_flash, 0xff, sizeof(sim_flash));
+	load_file(argv[optind], sim_flash, sizeof(sim_flash));
+	atexit(save_flash);
+	atexit(report_flash);
+
+	sim_spi_flash_attach(sim_flash, sizeof(sim_flash));
+	if (spi_clk)
+		sim_spi_flash_timing()->spi_clk = spi_clk;
+	if (write_log)
+		sim_spi_flash_trace(stderr);
+	sim_spi_flash_power_cut(cut_write, power_cut);
+	if (bad_read >= 0)
+		sim_spi_flash_overrun(bad_read);
+	sim_sha256_attach();
+	sim_aes_attach();
+	sim_otp_attach();
+	sim_uarths_attach(STDIN_FILENO, STDOUT_FILENO);
+
+	/* what _init_bsp() does before main() */
+	uart_init();
+	start_cycle = read_cycle();
+	phase_cycle = start_cycle;
+	if (cli) {
+		if (!isatty(STDIN_FILENO))
+			sim_uarths_pace(CONFIG_SYS_PROMPT);
+		cli_simple_loop();
+		return 0;
+	}
+	return loader_main();
+}
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Loopback check of the loadx, fldumpb and baud protocols on Linux:
+# utils/loadx.py negotiates a rate with the host build of the commands
+# (loadx_pty) over a pty and sends a random image, on a clean line, above the
+# link limit and with corrupted bytes. The received file must match. Then
+# utils/fldumpb.py reads a range of a random flash image back the same way.
+#
+# Usage: loadx_loop.py <loadx_pty>
+
+import sys
+import os
+import subprocess
+import tempfile
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', 'utils'))
+import loadx
+import fldumpb
+
+SIZE = 320 * 1024
+RAMADDR = 0x80100000
+
+# (name, --fast rate, link limit, corrupt every N bytes, size, expected rate)
+CASES = [
+    ('clean', 3000000, 0, 0, SIZE, 3000000),
+    ('fallback', 4000000, 2000000, 0, SIZE, 2000000),
+    ('fault', 3000000, 0, 40000, SIZE, 3000000),
+    ('short', 0, 0, 0, 1000, 115200),
+]
+
+FLASH_SIZE = 1024 * 1024
+# (name, --fast rate, corrupt every N bytes, floffset, length, failing read)
+DUMP_CASES = [
+    ('dump', 3000000, 0, 0x30000, SIZE, -1),
+    ('dump-fault', 3000000, 40000, 0x30000, SIZE, -1),
+    ('dump-short', 0, 0, 0x12345, 1000, -1),
+    ('dump-error', 3000000, 0, 0x30000, SIZE, 0x52345),
+]
+
+
+def run(exe, name, fast, link, every, size, expect):
+    data = os.urandom(size)
+    out = tempfile.NamedTemporaryFile(suffix='.bin', delete=False)
+    out.close()
+    cmd = [exe, '-m', str(link), '-e', str(every), out.name]
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE)
+    try:
+        port = loadx.Port(proc.stdout.readline().decode().split()[1], 115200)
+        rx = loadx.FrameReader(port)
+        baud = loadx.negotiate(port, rx, fast) if fast else port.baud
+        loadx.type_command(port, 'loadx %x' % RAMADDR)
+        ok = rx.wait_text(loadx.READY, 3)
+        start = time.time()
+        resent = loadx.send(port, data, baud=baud)
+        spent = time.time() - start
+        port.close()
+        result = proc.stdout.read().decode().strip()
+        proc.wait()
+        ok = ok and baud == expect and proc.returncode == 0 and \
+            open(out.name, 'rb').read() == data
+    finally:
+        if proc.poll() is None:
+            proc.kill()
+        os.unlink(out.name)
+    line_rate = size * 10.0 / baud
+    print('%s,%s,%d baud,%d bytes,%.2f s,%.0f%% of line rate,%d resent,%s' %
+          ('ok' if ok else 'FAIL', name, baud, size, spent,
+           100 * line_rate / spent, resent, result))
+    return ok
+
+
+def dump(exe, name, fast, every, offset, size, bad):
+    """A failing read must end the dump with an error and no data"""
+    image = os.urandom(FLASH_SIZE)
+    flash = tempfile.NamedTemporaryFile(suffix='.bin', delete=False)
+    flash.write(image)
+    flash.close()
+    cmd = [exe, '-e', str(every), '-f', flash.name, '-r', str(bad),
+           os.devnull]
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE)
+    resent = 0
+    spent = 1
+    try:
+        port = loadx.Port(proc.stdout.readline().decode().split()[1], 115200)
+        rx = loadx.FrameReader(port)
+        baud = loadx.negotiate(port, rx, fast) if fast else port.baud
+        loadx.type_command(port, 'fldumpb %x %x' % (offset, size))
+        ok = rx.wait_text(fldumpb.READY, 3)
+        start = time.time()
+        try:
+            data, resent = fldumpb.receive(port, size)
+            error = None
+        except fldumpb.FldumpbError as e:
+            data, error = None, str(e)
+        spent = time.time() - start
+        port.close()
+        result = proc.stdout.read().decode().strip()
+        proc.wait()
+        if bad < 0:
+            ok = ok and proc.returncode == 0 and \
+                data == image[offset:offset + size]
+        else:
+            ok = ok and proc.returncode != 0 and \
+                error == 'loader could not read the flash at 0x%x' % (
+                    (bad - offset) // 4096 * 4096)
+    finally:
+        if proc.poll() is None:
+            proc.kill()
+        os.unlink(flash.name)
+    line_rate = size * 10.0 / baud
+    print('%s,%s,%d baud,%d bytes,%.2f s,%.0f%% of line rate,%d resent,%s' %
+          ('ok' if ok else 'FAIL', name, baud, size, spent,
+           100 * line_rate / spent, resent, result))
+    return ok
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(sys.argv[0] + ' <loadx_pty>')
+        sys.exit(2)
+    # no CLI readline() delay to wait for here
+    loadx.CMD_CHAR_DELAY = 0
+    failed = 0
+    for case in CASES:
+        if not run(sys.argv[1], *case):
+            failed += 1
+    for case in DUMP_CASES:
+        if not dump(sys.argv[1], *case):
+            failed += 1
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build of the loadx, fldumpb and baud commands. The UART is the master
+ * side of a pty and utils/loadx.py talks to the slave side, as it would to a
+ * USB serial port. The line rate of a real UART is emulated, so transfer
+ * times are what a board would see. Rates above a link limit garble every
+ * byte, like a cable that cannot carry them, and bytes can be corrupted on
+ * purpose during a transfer to exercise the retransmissions.
+ *
+ *   ./loadx_pty [-m maxbaud] [-e every] [-s maxlen] [-f flash.bin]
+ *               [-r floffset] <out.bin>
+ *
+ * The slave path is printed as "pty <path>", then "baud <rate>" lines are
+ * served until a "loadx <ramaddr>" or a "fldumpb <floffset> <length>" of the
+ * flash.bin content completes. -r fails every flash read covering floffset.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "cli.h"
+#include "flash.h"
+#include "loadx.h"
+#include "sha256.h"
+#include "sim.h"
+#include "sysctl.h"
+#include "uarths.h"
+
+static int pty_fd = -1;
+static uint8_t rx_buf[65536];
+static size_t rx_head, rx_tail;
+static uint64_t rx_next; /* when the line delivers rx_buf[rx_head] */
+static uint64_t tx_next; /* when the line is done with what was sent */
+static uint64_t byte_ns; /* 10 bits per byte */
+static uint32_t baudrate, link_max;
+static unsigned long fault_every;
+static unsigned long rx_count, tx_count, faults;
+static int faults_armed;
+static uint8_t *flash;
+static size_t flash_size;
+static long bad_read = -1;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint8_t line(uint8_t c, unsigned long *count)
+{
+	if (link_max && baudrate > link_max)
+		return c ^ 0xA5;
+	if (faults_armed && fault_every && ++*count % fault_every == 0) {
+		faults++;
+		return c ^ 0x55;
+	}
+	return c;
+}
+
+int uart_tstc(void)
+{
+	uint64_t now = now_ns();
+	ssize_t n;
+
+	if (rx_head == rx_tail) {
+		n = read(pty_fd, rx_buf, sizeof(rx_buf));
+		if (n <= 0)
+			return 0;
+		rx_head = 0;
+		rx_tail = n;
+		if (rx_next < now)
+			rx_next = now;
+	}
+	return now >= rx_next;
+}
+
+int uart_getc(void)
+{
+	while (!uart_tstc())
+		continue;
+	rx_next += byte_ns;
+	return line(rx_buf[rx_head++], &rx_count);
+}
+
+int uart_getc_timeout(uint32_t timeout_ms)
+{
+	uint64_t deadline = now_ns() + timeout_ms * 1000000ULL;
+
+	while (!uart_tstc()) {
+		if (now_ns() >= deadline)
+			return -1;
+	}
+	return uart_getc();
+}
+
+int uart_putchar(char c)
+{
+	uint8_t b = line(c, &tx_count);
+	uint64_t now = now_ns();
+
+	/* the byte leaves now, the wait is for room in the TX ring */
+	if (tx_next < now)
+		tx_next = now;
+	while (tx_next - now > UARTHS_TX_RING_SIZE * byte_ns)
+		now = now_ns();
+	tx_next += byte_ns;
+
+	while (write(pty_fd, &b, 1) != 1) {
+		if (errno != EAGAIN)
+			return -1;
+	}
+	return 0;
+}
+
+int uart_puts(const char *s)
+{
+	while (*s)
+		if (uart_putchar(*s++) != 0)
+			return -1;
+	return 0;
+}
+
+int uart_baudrate_valid(uint32_t baud)
+{
+	return baud >= 9600 && baud <= 5000000;
+}
+
+int uart_set_baudrate(uint32_t baud)
+{
+	if (!uart_baudrate_valid(baud))
+		return -1;
+	baudrate = baud;
+	byte_ns = 10 * 1000000000ULL / baud;
+	return 0;
+}
+
+uint32_t uart_get_baudrate(void)
+{
+	return baudrate;
+}
+
+int printk(const char *format, ...)
+{
+	char buf[256];
+	va_list ap;
+	int ret;
+
+	va_start(ap, format);
+	ret = vsnprintf(buf, sizeof(buf), format, ap);
+	va_end(ap);
+	uart_puts(buf);
+	return ret;
+}
+
+enum flash_status_t flash_init(uint8_t index)
+{
+	return FLASH_OK;
+}
+
+enum flash_status_t flash_enable_quad_mode(void)
+{
+	return FLASH_OK;
+}
+
+enum flash_status_t flash_read_bulk(uint32_t addr, uint8_t *data_buf,
+				    uint32_t length)
+{
+	size_t n = addr < flash_size ? flash_size - addr : 0;
+
+	if (bad_read >= (long)addr && bad_read < (long)addr + length)
+		return FLASH_ERROR;
+	n = n < length ? n : length;
+	memcpy(data_buf, flash + addr, n);
+	memset(data_buf + n, 0xff, length - n);
+	return FLASH_OK;
+}
+
+/* The SHA256 driver runs against the register model of the engine */
+int sysctl_clock_enable(sysctl_clock_t clock)
+{
+	return 0;
+}
+
+void sysctl_reset(sysctl_reset_t reset)
+{
+}
+
+static int flash_load(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	long len;
+
+	if (!f || fseek(f, 0, SEEK_END) || (len = ftell(f)) < 0)
+		return -1;
+	flash = malloc(len + 1);
+	rewind(f);
+	if (!flash || fread(flash, 1, len, f) != (size_t)len)
+		return -1;
+	fclose(f);
+	flash_size = len;
+	return 0;
+}
+
+/* What was sent is lost once the master closes, wait for the host to go */
+static void pty_linger(void)
+{
+	uint64_t deadline = now_ns() + 3000000000ULL;
+	uint8_t buf[256];
+
+	while (now_ns() < deadline) {
+		if (read(pty_fd, buf, sizeof(buf)) < 0 && errno == EIO)
+			break;
+		usleep(1000);
+	}
+}
+
+static int dump(const char *args)
+{
+	uint32_t offset, length;
+	uint8_t digest[SHA256_HASH_SIZE];
+	uint64_t start, spent;
+	char *end;
+
+	offset = strtoul(args, &end, 16);
+	length = strtoul(end, NULL, 16);
+	printk("## Ready for binary (fldumpb) upload of flash 0x%08X...\n",
+	       offset);
+	faults_armed = 1;
+	start = now_ns();
+	if (flash_serial_dump(offset, length, digest) != 0) {
+		printf("fldumpb,aborted,%u baud,faults=%lu\n", baudrate,
+		       faults);
+		fflush(stdout);
+		pty_linger();
+		return 1;
+	}
+	spent = now_ns() - start;
+	printf("fldumpb,%u bytes,%lu ms,%u baud,faults=%lu\n", length,
+	       (unsigned long)(spent / 1000000), baudrate, faults);
+	return 0;
+}
+
+static int pty_open(void)
+{
+	struct termios tio;
+	int slave;
+
+	pty_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (pty_fd < 0 || grantpt(pty_fd) || unlockpt(pty_fd))
+		return -1;
+
+	/* Keep the slave open so the master never reads EIO in between */
+	slave = open(ptsname(pty_fd), O_RDWR | O_NOCTTY);
+	if (slave < 0)
+		return -1;
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+
+	return fcntl(pty_fd, F_SETFL, O_NONBLOCK);
+}
+
+static void readline(char *buf, size_t len)
+{
+	size_t n = 0;
+	int c;
+
+	for (;;) {
+		c = uart_getc();
+		if (c == '\r' || c == '\n')
+			break;
+		if (n < len - 1)
+			buf[n++] = c;
+	}
+	buf[n] = '\0';
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long maxlen = 6 * 1024 * 1024, size;
+	uint64_t start, spent;
+	char cmd[64];
+	uint8_t *ram;
+	FILE *out;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:e:s:f:r:")) != -1) {
+		switch (opt) {
+		case 'm':
+			link_max = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			fault_every = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			maxlen = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			if (flash_load(optarg)) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+		case 'r':
+			bad_read = strtol(optarg, NULL, 0);
+			break;
+		default:
+			return 2;
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr,
+			"%s [-m maxbaud] [-e every] [-s maxlen] [-f flash.bin] [-r floffset] <out.bin>\n",
+			argv[0]);
+		return 2;
+	}
+
+	ram = malloc(maxlen);
+	if (!ram || pty_open()) {
+		perror("loadx_pty");
+		return 1;
+	}
+	sim_sha256_attach();
+	uart_set_baudrate(UARTHS_DEFAULT_BAUD);
+	printf("pty %s\n", ptsname(pty_fd));
+	fflush(stdout);
+
+	for (;;) {
+		readline(cmd, sizeof(cmd));
+		if (strncmp(cmd, "baud ", 5) == 0)
+			baud_switch(strtoul(cmd + 5, NULL, 10));
+		else if (strncmp(cmd, "loadx ", 6) == 0)
+			break;
+		else if (strncmp(cmd, "fldumpb ", 8) == 0)
+			return dump(cmd + 8);
+	}
+
+	printk("## Ready for binary (loadx) download to 0x%s...\n", cmd + 6);
+	faults_armed = 1;
+	start = now_ns();
+	size = load_serial_x((uintptr_t)ram, maxlen);
+	spent = now_ns() - start;
+	if (size == LOADX_ERROR) {
+		printf("loadx,aborted,%u baud,faults=%lu\n", baudrate, faults);
+		return 1;
+	}
+
+	out = fopen(argv[optind], "wb");
+	if (!out || fwrite(ram, 1, size, out) != size) {
+		perror(argv[optind]);
+		return 1;
+	}
+	fclose(out);
+
+	printf("loadx,%lu bytes,%lu ms,%u baud,faults=%lu\n", size,
+	       (unsigned long)(spent / 1000000), baudrate, faults);
+	return 0;
+}
@@ -0,0 +1,375 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Power cut injection on the slot copies of both loader stages: each case
+ * boots once logging the flash writes (loader_host -l), then cuts power on
+ * the k-th of them (loader_host -k leaves it torn) and boots again from
+ * what the cut left. k goes over every erase, every journal write and the
+ * first and last program of each run of them, where a sector copy starts
+ * and ends, plus every CUT_STRIDE-th write, up to the last journal write:
+ * what the application of -v writes once the copy is done is left alone.
+ * Cases are
+ *
+ *   s1 differ       stage 1 copies stage 2 APP, newer, over BAK
+ *   s1 app_corrupt  stage 1 restores stage 2 APP from BAK
+ *   s2 differ       the application copies APP over BAK through the
+ *                   service table (loader_host -v)
+ *   s2 app_corrupt  the same from BAK over APP, BAK is booted
+ *
+ * The second boot must load the expected payload and leave both slots
+ * holding the same image, and the writes of both boots together must be
+ * over those of the uncut one by at most a sector copied again: the copy
+ * goes on from the journal instead of starting over.
+ *
+ *   ./powercut_sim loader_host_stage1 loader_host_stage2
+ *
+ * The exit status is 1 when a case fails.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "flash_map.h"
+#include "sha256.h"
+#include "sim.h"
+
+/* Slots as main.c lays them out for each stage */
+#define STAGE2_APP_ADDR (64 * 1024)
+#define STAGE2_BAK_ADDR (2 * 64 * 1024)
+#define APP_ADDR (3 * 64 * 1024)
+#define BAK_ADDR ((3 * 64 + 320) * 1024)
+/* up to the journal partition */
+#define FLASH_SIZE (FLASH_JOURNAL_OFFSET + FLASH_JOURNAL_SIZE)
+/* what loader_host -r saves */
+#define RAM_DUMP_SIZE (320 * 1024)
+
+#define STAGE2_PAYLOAD (40 * 1024)
+#define APP_PAYLOAD (64 * 1024 - 64)
+/* flag, length and digest */
+#define IMAGE_OVERHEAD (1 + 4 + SHA256_HASH_SIZE)
+
+#define JOURNAL_ADDR FLASH_JOURNAL_OFFSET
+#define MAX_WRITES 8192
+#define CUT_STRIDE 61
+
+/*
+ * Writes a sector copied again takes: erase, programs of FLASH_PROGRAM_CHUNK
+ * (flash.h) bytes and the journal bit, and the journal entry erased and
+ * written anew
+ */
+#define REDO_WRITES (1 + 4096 / 32 + 1 + 2)
+
+struct flash_write {
+	int program;
+	uint32_t addr;
+};
+
+enum slot_state { APP_CORRUPT, DIFFER, STATE_COUNT };
+
+static const char *const state_names[STATE_COUNT] = { "app_corrupt",
+						      "differ" };
+
+static char tmp_dir[] = "/tmp/powercut.XXXXXX";
+static const char *const tmp_files[] = { "flash0.bin", "flash1.bin",
+					 "flash2.bin", "ram.bin" };
+
+static void fill_payload(uint8_t *buf, uint32_t len, uint32_t seed)
+{
+	uint32_t x = seed * 2654435761U + 1, i;
+
+	for (i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = (uint8_t)x;
+	}
+}
+
+/* flag | length | payload | SHA256 */
+static uint32_t make_image(uint8_t *out, const uint8_t *payload,
+			   uint32_t len)
+{
+	SHA256Context sha256_context;
+
+	out[0] = 0;
+	memcpy(out + 1, &len, 4);
+	memcpy(out + 5, payload, len);
+	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, len + 5,
+		    &sha256_context);
+	sha256_update(&sha256_context, out, len + 5);
+	sha256_final(&sha256_context, out + 5 + len);
+	return len + IMAGE_OVERHEAD;
+}
+
+static void write_file(const char *path, const void *buf, size_t len)
+{
+	FILE *f = fopen(path, "wb");
+
+	if (!f || fwrite(buf, 1, len, f) != len) {
+		perror(path);
+		exit(2);
+	}
+	fclose(f);
+}
+
+static void read_file(const char *path, void *buf, size_t len)
+{
+	FILE *f = fopen(path, "rb");
+
+	memset(buf, 0xff, len);
+	if (!f) {
+		perror(path);
+		return;
+	}
+	if (fread(buf, 1, len, f) != len)
+		fprintf(stderr, "%s: short read\n", path);
+	fclose(f);
+}
+
+static void tmp_path(char *path, size_t size, const char *name)
+{
+	snprintf(path, size, "%s/%s", tmp_dir, name);
+}
+
+/*
+ * Boot flash_in with a loader stage, power cut on write cut unless it is 0.
+ * The writes the boot took go to *writes, those up to the cut when there
+ * is one, and go to log[] when it is not NULL. Returns the exit status of
+ * the loader.
+ */
+static int run_stage(const char *loader, const char *flash_in,
+		     const char *flash_out, const char *ram_out, int svc,
+		     uint64_t cut, uint64_t *writes, struct flash_write *log)
+{
+	char line[256], cut_arg[32], op[32];
+	const char *argv[12];
+	unsigned long n;
+	unsigned int addr;
+	FILE *f;
+	pid_t pid;
+	int fds[2], status, argc = 0;
+
+	argv[argc++] = loader;
+	argv[argc++] = "-w";
+	argv[argc++] = flash_out;
+	argv[argc++] = "-r";
+	argv[argc++] = ram_out;
+	if (svc)
+		argv[argc++] = "-v";
+	if (log)
+		argv[argc++] = "-l";
+	if (cut) {
+		snprintf(cut_arg, sizeof(cut_arg), "%lu", (unsigned long)cut);
+		argv[argc++] = "-k";
+		argv[argc++] = cut_arg;
+	}
+	argv[argc++] = flash_in;
+	argv[argc] = NULL;
+
+	*writes = 0;
+	if (pipe(fds) != 0) {
+		perror("pipe");
+		exit(2);
+	}
+	pid = fork();
+	if (pid == 0) {
+		close(fds[0]);
+		dup2(fds[1], STDERR_FILENO);
+		if (!freopen("/dev/null", "w", stdout))
+			_exit(2);
+		execv(loader, (char *const *)argv);
+		perror(loader);
+		_exit(2);
+	}
+	close(fds[1]);
+	f = fdopen(fds[0], "r");
+	while (fgets(line, sizeof(line), f)) {
+		if (log && sscanf(line, "sim: write %lu %31s %x", &n, op,
+				  &addr) == 3 && n && n <= MAX_WRITES) {
+			log[n - 1].program = !!strstr(op, "program");
+			log[n - 1].addr = addr;
+		}
+		if (sscanf(line, "sim: flash writes %lu", &n) == 1 ||
+		    sscanf(line, "sim: power cut at write %lu", &n) == 1)
+			*writes = n;
+	}
+	fclose(f);
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+		return -1;
+	return WEXITSTATUS(status);
+}
+
+struct cut_case {
+	int stage;
+	enum slot_state state;
+};
+
+/* Last write of n to the journal, the end of the copy */
+static uint64_t last_journal_write(const struct flash_write *log, uint64_t n)
+{
+	while (n && log[n - 1].addr < JOURNAL_ADDR)
+		n--;
+	return n;
+}
+
+/* Is write k of n, counted from 1, one to cut power on */
+static int cut_point(const struct flash_write *log, uint64_t k, uint64_t n)
+{
+	const struct flash_write *w = &log[k - 1];
+
+	return !w->program || w->addr >= JOURNAL_ADDR || k == 1 || k == n ||
+	       !w[-1].program || !w[1].program || k % CUT_STRIDE == 0;
+}
+
+/* Returns the number of failures of one case */
+static int run_case(const char *loader, const struct cut_case *c)
+{
+	static uint8_t flash[FLASH_SIZE], result[FLASH_SIZE];
+	static uint8_t old[RAM_DUMP_SIZE], new[RAM_DUMP_SIZE];
+	static uint8_t image[RAM_DUMP_SIZE], ram[RAM_DUMP_SIZE];
+	static struct flash_write log[MAX_WRITES];
+	char flash0[256], flash1[256], flash2[256], ram_file[256];
+	char label[64];
+	uint32_t app = c->stage == 1 ? STAGE2_APP_ADDR : APP_ADDR;
+	uint32_t bak = c->stage == 1 ? STAGE2_BAK_ADDR : BAK_ADDR;
+	uint32_t len = c->stage == 1 ? STAGE2_PAYLOAD : APP_PAYLOAD;
+	uint32_t image_len;
+	uint64_t total, last, cut, before, after, cuts = 0, redo = 0;
+	int svc = c->stage == 2, ret, failed = 0;
+
+	tmp_path(flash0, sizeof(flash0), "flash0.bin");
+	tmp_path(flash1, sizeof(flash1), "flash1.bin");
+	tmp_path(flash2, sizeof(flash2), "flash2.bin");
+	tmp_path(ram_file, sizeof(ram_file), "ram.bin");
+	snprintf(label, sizeof(label), "s%d %s", c->stage,
+		 state_names[c->state]);
+
+	/* APP newer than BAK, or BAK holding what a flipped APP byte broke */
+	memset(flash, 0xff, sizeof(flash));
+	fill_payload(old, len, c->stage);
+	fill_payload(new, len, c->stage + 1);
+	image_len = make_image(image, old, len);
+	memcpy(flash + bak, image, image_len);
+	if (c->state == DIFFER)
+		image_len = make_image(image, new, len);
+	memcpy(flash + app, image, image_len);
+	if (c->state == APP_CORRUPT)
+		flash[app + 5 + len / 2] ^= 0x01;
+	write_file(flash0, flash, sizeof(flash));
+
+	memset(log, 0, sizeof(log));
+	ret = run_stage(loader, flash0, flash1, ram_file, svc, 0, &total, log);
+	if (ret != 0 || !total || total > MAX_WRITES) {
+		fprintf(stderr, "fail: %s uncut boot exit %d, %lu writes\n",
+			label, ret, (unsigned long)total);
+		return 1;
+	}
+
+	last = last_journal_write(log, total);
+	for (cut = 1; cut <= last; cut++) {
+		if (!cut_point(log, cut, total))
+			continue;
+		cuts++;
+		ret = run_stage(loader, flash0, flash1, ram_file, svc, cut,
+				&before, NULL);
+		if (ret != 4) {
+			fprintf(stderr, "fail: %s cut %lu exit %d\n", label,
+				(unsigned long)cut, ret);
+			failed++;
+			continue;
+		}
+		ret = run_stage(loader, flash1, flash2, ram_file, svc, 0,
+				&after, NULL);
+		if (ret != 0) {
+			fprintf(stderr, "fail: %s cut %lu then exit %d\n",
+				label, (unsigned long)cut, ret);
+			failed++;
+			continue;
+		}
+		read_file(ram_file, ram, sizeof(ram));
+		if (memcmp(ram, c->state == DIFFER ? new : old, len)) {
+			fprintf(stderr, "fail: %s cut %lu wrong payload\n",
+				label, (unsigned long)cut);
+			failed++;
+		}
+		read_file(flash2, result, sizeof(result));
+		if (memcmp(result + app, image, image_len) ||
+		    memcmp(result + bak, image, image_len)) {
+			fprintf(stderr, "fail: %s cut %lu slots not in sync\n",
+				label, (unsigned long)cut);
+			failed++;
+		}
+		if (before + after > total + redo)
+			redo = before + after - total;
+	}
+	if (redo > REDO_WRITES) {
+		fprintf(stderr, "fail: %s %lu writes done again\n", label,
+			(unsigned long)redo);
+		failed++;
+	}
+
+	printf("powercut,s%d,%s,%lu,%lu,%lu,%s\n", c->stage,
+	       state_names[c->state], (unsigned long)total,
+	       (unsigned long)cuts, (unsigned long)redo,
+	       failed ? "FAIL" : "ok");
+	fflush(stdout);
+
+	return failed;
+}
+
+int main(int argc, char *argv[])
+{
+	struct cut_case c;
+	char path[256];
+	int failed = 0, s;
+	size_t i;
+
+	if (argc != 3) {
+		fprintf(stderr, "%s <loader_host_stage1> <loader_host_stage2>\n",
+			argv[0]);
+		return 2;
+	}
+	if (!mkdtemp(tmp_dir)) {
+		perror(tmp_dir);
+		return 2;
+	}
+
+	sim_sha256_attach();
+
+	printf("powercut,stage,state,writes,cuts,max_redo,result\n");
+	/* or the loaders inherit what is buffered */
+	fflush(stdout);
+
+	for (c.stage = 1; c.stage <= 2; c.stage++) {
+		for (s = 0; s < STATE_COUNT; s++) {
+			c.state = s;
+			failed += run_case(argv[c.stage], &c) != 0;
+		}
+	}
+
+	for (i = 0; i < sizeof(tmp_files) / sizeof(tmp_files[0]); i++) {
+		tmp_path(path, sizeof(path), tmp_files[i]);
+		unlink(path);
+	}
+	rmdir(tmp_dir);
+
+	printf("%d case(s) failed\n", failed);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HOST_SIM_H_
+#define __HOST_SIM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Software register models for the host build. Drivers compiled with
+ * CONFIG_HOST_SIM access registers through readl()/writel(), which land in
+ * sim_mmio_read()/sim_mmio_write() and are dispatched by address to the
+ * model attached to that range.
+ */
+
+/* CPU clock reported by sysctl_clock_get_freq(), mcycle counts at it */
+#define SIM_CPU_FREQ 390000000UL
+
+/*
+ * Simulated time, what mcycle and mtime count: host time plus the time the
+ * models stalled the CPU for, bus transfers and busy polls that take far
+ * longer on the target than here.
+ */
+uint64_t sim_now_ns(void);
+void sim_stall(uint64_t ns);
+
+typedef uint64_t (*sim_read_fn)(void *ctx, uint32_t offset, int size);
+typedef void (*sim_write_fn)(void *ctx, uint32_t offset, uint64_t value,
+			     int size);
+
+void sim_mmio_register(uintptr_t base, uint32_t size, sim_read_fn read,
+		       sim_write_fn write, void *ctx);
+
+/* SHA256 engine at SHA256_BASE_ADDR */
+void sim_sha256_attach(void);
+/* AES engine at AES_BASE_ADDR, ECB and CBC with 128 bits key */
+void sim_aes_attach(void);
+
+/* OTP controller at OTP_BASE_ADDR, fuses can be read but not blown */
+void sim_otp_attach(void);
+void sim_otp_fuse(uint32_t addr, const uint8_t *data, uint32_t len);
+/* Fused OTP AES key, returns 1 and the key while key output is enabled */
+void sim_otp_set_aes_key(const uint8_t key[16]);
+int sim_otp_key_output(uint8_t key[16]);
+/* SPI NOR of size bytes at mem behind the SPI3 controller */
+void sim_spi_flash_attach(uint8_t *mem, uint32_t size);
+
+/* Timings of the SPI NOR model, typical GD25LQ128 values by default */
+struct sim_nor_timing {
+	/* SPI3 input clock, SCLK is this divided by baudr */
+	uint32_t spi_clk;
+	/* page program: fixed part and per byte */
+	uint32_t pp_base_ns;
+	uint32_t pp_byte_ns;
+	uint32_t wrsr_ns;
+	uint32_t se_4k_ns;
+	uint32_t be_32k_ns;
+	uint32_t be_64k_ns;
+	uint64_t ce_ns;
+	/* CPU time of one status poll loop turn while the part is busy */
+	uint32_t poll_ns;
+};
+
+/* Timings in use, may be changed between operations */
+struct sim_nor_timing *sim_spi_flash_timing(void);
+/* Programs and erases the part took since it was attached */
+uint64_t sim_spi_flash_writes(void);
+/* Print each of them on out: count, opcode, address and bytes, NULL stops */
+void sim_spi_flash_trace(FILE *out);
+/*
+ * Cut power on the write-th program or erase, counted as above, 0 for
+ * never: it is left torn and cut() runs once it is clocked in. The model
+ * goes on if cut() returns, it is meant to save the flash and exit.
+ */
+void sim_spi_flash_power_cut(uint64_t write, void (*cut)(uint64_t write));
+/* Overrun the RX FIFO on every dual or quad read reaching the byte at addr */
+void sim_spi_flash_overrun(uint32_t addr);
+/* Times the 4K sector holding addr was erased */
+uint32_t sim_spi_flash_erase_count(uint32_t addr);
+/* Per opcode counts and times, erase wear and protocol errors as CSV */
+void sim_spi_flash_report(FILE *out);
+void sim_spi_flash_reset_stats(void);
+/* UARTHS sending to out_fd and receiving from in_fd, either may be -1 */
+void sim_uarths_attach(int in_fd, int out_fd);
+/* Hold input after each line end until prompt has been sent, NULL to stop */
+void sim_uarths_pace(const char *prompt);
+
+#endif /* __HOST_SIM_H_ */
@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aes.h"
+#include "platform.h"
+#include "sim.h"
+
+#define REG(field) offsetof(struct aes_t, field)
+
+#define SIM_AES_FIFO_WORDS 64
+
+/*
+ * AES engine, ECB and CBC with a 128 bits key. Key and IV words are written
+ * last word first, text words hold bytes in memory order. The OTP key is
+ * used instead of the key registers while OTP key output is enabled. Setting bit 0 of
+ * gb_aes_en starts a new message, every 4 text words give 4 output words.
+ */
+struct sim_aes {
+	struct aes_t regs;
+	uint8_t round_key[176];
+	uint8_t chain[16];
+	uint8_t in[16];
+	uint32_t in_len;
+	uint32_t fifo[SIM_AES_FIFO_WORDS];
+	uint32_t fifo_head, fifo_count;
+};
+
+static struct sim_aes sim_aes;
+
+static const uint8_t sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b,
+	0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+	0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26,
+	0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2,
+	0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+	0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed,
+	0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f,
+	0x50, 0x3c, 0x9f, 0xa8, 0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+	0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec,
+	0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14,
+	0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+	0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79, 0xe7, 0xc8, 0x37, 0x6d,
+	0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f,
+	0x4b, 0xbd, 0x8b, 0x8a, 0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+	0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11,
+	0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f,
+	0xb0, 0x54, 0xbb, 0x16
+};
+
+static uint8_t inv_sbox[256];
+
+static uint8_t xtime(uint8_t x)
+{
+	return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1b : 0));
+}
+
+static uint8_t gmul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while (b) {
+		if (b & 1)
+			r ^= a;
+		a = xtime(a);
+		b >>= 1;
+	}
+	return r;
+}
+
+static void aes_expand_key(uint8_t *rk, const uint8_t *key)
+{
+	uint8_t rcon = 1, t[4];
+	int i, j;
+
+	memcpy(rk, key, 16);
+	for (i = 16; i < 176; i += 4) {
+		memcpy(t, &rk[i - 4], 4);
+		if (i % 16 == 0) {
+			uint8_t tmp = t[0];
+
+			t[0] = sbox[t[1]] ^ rcon;
+			t[1] = sbox[t[2]];
+			t[2] = sbox[t[3]];
+			t[3] = sbox[tmp];
+			rcon = xtime(rcon);
+		}
+		for (j = 0; j < 4; j++)
+			rk[i + j] = rk[i - 16 + j] ^ t[j];
+	}
+}
+
+static void aes_encrypt_block(const uint8_t *rk, uint8_t *s)
+{
+	uint8_t t[16];
+	int r, c, i;
+
+	for (i = 0; i < 16; i++)
+		s[i] ^= rk[i];
+	for (r = 1; r <= 10; r++) {
+		/* SubBytes and ShiftRows */
+		for (i = 0; i < 16; i++)
+			t[i] = sbox[s[(i + 4 * (i % 4)) % 16]];
+		/* MixColumns */
+		for (c = 0; c < 4 && r != 10; c++) {
+			uint8_t *col = &t[4 * c];
+			uint8_t a0 = col[0], a1 = col[1], a2 = col[2],
+				a3 = col[3];
+
+			col[0] = xtime(a0) ^ xtime(a1) ^ a1 ^ a2 ^ a3;
+			col[1] = a0 ^ xtime(a1) ^ xtime(a2) ^ a2 ^ a3;
+			col[2] = a0 ^ a1 ^ xtime(a2) ^ xtime(a3) ^ a3;
+			col[3] = xtime(a0) ^ a0 ^ a1 ^ a2 ^ xtime(a3);
+		}
+		for (i = 0; i < 16; i++)
+			s[i] = t[i] ^ rk[16 * r + i];
+	}
+}
+
+static void aes_decrypt_block(const uint8_t *rk, uint8_t *s)
+{
+	uint8_t t[16];
+	int r, c, i;
+
+	for (r = 10; r >= 1; r--) {
+		for (i = 0; i < 16; i++)
+			t[i] = s[i] ^ rk[16 * r + i];
+		/* InvMixColumns */
+		for (c = 0; c < 4 && r != 10; c++) {
+			uint8_t *col = &t[4 * c];
+			uint8_t a0 = col[0], a1 = col[1], a2 = col[2],
+				a3 = col[3];
+
+			col[0] = gmul(a0, 14) ^ gmul(a1, 11) ^ gmul(a2, 13) ^
+				 gmul(a3, 9);
+			col[1] = gmul(a0, 9) ^ gmul(a1, 14) ^ gmul(a2, 11) ^
+				 gmul(a3, 13);
+			col[2] = gmul(a0, 13) ^ gmul(a1, 9) ^ gmul(a2, 14) ^
+				 gmul(a3, 11);
+			col[3] = gmul(a0, 11) ^ gmul(a1, 13) ^ gmul(a2, 9) ^
+				 gmul(a3, 14);
+		}
+		/* InvShiftRows and InvSubBytes */
+		for (i = 0; i < 16; i++)
+			s[(i + 4 * (i % 4)) % 16] = inv_sbox[t[i]];
+	}
+	for (i = 0; i < 16; i++)
+		s[i] ^= rk[i];
+}
+
+/* Key and IV registers hold the last 4 bytes in word 0 */
+static void sim_aes_load_reversed(uint8_t *out, const uint32_t *words)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		memcpy(&out[12 - 4 * i], &words[i], 4);
+}
+
+static void sim_aes_start(struct sim_aes *s)
+{
+	uint8_t key[16];
+
+	if (s->regs.cipher_mode != AES_ECB && s->regs.cipher_mode != AES_CBC) {
+		fprintf(stderr, "sim: AES mode %u is not modeled\n",
+			s->regs.cipher_mode);
+		abort();
+	}
+	if (!sim_otp_key_output(key))
+		sim_aes_load_reversed(key, s->regs.aes_key);
+	sim_aes_load_reversed(s->chain, s->regs.aes_iv);
+	aes_expand_key(s->round_key, key);
+	s->in_len = 0;
+	s->fifo_head = 0;
+	s->fifo_count = 0;
+}
+
+static void sim_aes_block(struct sim_aes *s)
+{
+	uint8_t out[16];
+	int i;
+
+	memcpy(out, s->in, 16);
+	if (s->regs.encrpt_sel == AES_DENCRPTION) {
+		aes_decrypt_block(s->round_key, out);
+		if (s->regs.cipher_mode == AES_CBC) {
+			for (i = 0; i < 16; i++)
+				out[i] ^= s->chain[i];
+			memcpy(s->chain, s->in, 16);
+		}
+	} else {
+		if (s->regs.cipher_mode == AES_CBC) {
+			for (i = 0; i < 16; i++)
+				out[i] ^= s->chain[i];
+		}
+		aes_encrypt_block(s->round_key, out);
+		memcpy(s->chain, out, 16);
+	}
+
+	if (s->fifo_count + 4 > SIM_AES_FIFO_WORDS) {
+		fprintf(stderr, "sim: AES output FIFO overflow\n");
+		abort();
+	}
+	for (i = 0; i < 4; i++) {
+		memcpy(&s->fifo[(s->fifo_head + s->fifo_count) %
+				SIM_AES_FIFO_WORDS],
+		       &out[4 * i], 4);
+		s->fifo_count++;
+	}
+}
+
+static uint64_t sim_aes_read(void *ctx, uint32_t offset, int size)
+{
+	struct sim_aes *s = ctx;
+	uint32_t v;
+
+	switch (offset) {
+	case REG(data_in_flag):
+		return 1;
+	case REG(data_out_flag):
+		return s->fifo_count != 0;
+	case REG(aes_out_data):
+		if (s->fifo_count == 0)
+			return 0;
+		v = s->fifo[s->fifo_head];
+		s->fifo_head = (s->fifo_head + 1) % SIM_AES_FIFO_WORDS;
+		s->fifo_count--;
+		return v;
+	default:
+		if (offset < sizeof(s->regs))
+			return *(uint32_t *)((uint8_t *)&s->regs + offset);
+		return 0;
+	}
+}
+
+static void sim_aes_write(void *ctx, uint32_t offset, uint64_t value,
+			  int size)
+{
+	struct sim_aes *s = ctx;
+	uint32_t v = (uint32_t)value;
+
+	switch (offset) {
+	case REG(gb_aes_en):
+		s->regs.gb_aes_en = v;
+		if (v & 1)
+			sim_aes_start(s);
+		break;
+	case REG(aes_text_data):
+		memcpy(&s->in[s->in_len], &v, 4);
+		s->in_len += 4;
+		if (s->in_len == 16) {
+			sim_aes_block(s);
+			s->in_len = 0;
+		}
+		break;
+	default:
+		if (offset < sizeof(s->regs))
+			*(uint32_t *)((uint8_t *)&s->regs + offset) = v;
+		break;
+	}
+}
+
+void sim_aes_attach(void)
+{
+	int i;
+
+	for (i = 0; i < 256; i++)
+		inv_sbox[sbox[i]] = (uint8_t)i;
+	memset(&sim_aes, 0, sizeof(sim_aes));
+	sim_mmio_register(AES_BASE_ADDR, sizeof(struct aes_t), sim_aes_read,
+			  sim_aes_write, &sim_aes);
+}
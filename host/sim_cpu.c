@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include "clint.h"
+#include "encoding.h"
+#include "sim.h"
+
+/* Hart 0 of the host build, see encoding.h */
+static unsigned long sim_csrs[sim_csr_count];
+/* time the models kept the CPU waiting on top of what the host took */
+static uint64_t sim_stalled_ns;
+
+uint64_t sim_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec +
+	       sim_stalled_ns;
+}
+
+void sim_stall(uint64_t ns)
+{
+	sim_stalled_ns += ns;
+}
+
+unsigned long sim_csr_access(enum sim_csr csr, unsigned long set,
+			     unsigned long clear)
+{
+	unsigned long old;
+
+	switch (csr) {
+	case sim_csr_mcycle:
+	case sim_csr_minstret:
+		return sim_now_ns() * (SIM_CPU_FREQ / 1000000) / 1000;
+	case sim_csr_mtime:
+		return sim_now_ns() * (SIM_CPU_FREQ / 1000000) / 1000 /
+		       CLINT_CLOCK_DIV;
+	case sim_csr_mhartid:
+		return 0;
+	default:
+		old = sim_csrs[csr];
+		sim_csrs[csr] = (old & ~clear) | set;
+		return old;
+	}
+}
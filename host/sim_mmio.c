@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "io.h"
+#include "sim.h"
+
+#define SIM_MMIO_REGIONS 16
+
+struct sim_region {
+	uintptr_t base;
+	uint32_t size;
+	sim_read_fn read;
+	sim_write_fn write;
+	void *ctx;
+};
+
+static struct sim_region regions[SIM_MMIO_REGIONS];
+static int region_count;
+
+void sim_mmio_register(uintptr_t base, uint32_t size, sim_read_fn read,
+		       sim_write_fn write, void *ctx)
+{
+	if (region_count == SIM_MMIO_REGIONS) {
+		fprintf(stderr, "sim: too many register regions\n");
+		exit(1);
+	}
+	regions[region_count].base = base;
+	regions[region_count].size = size;
+	regions[region_count].read = read;
+	regions[region_count].write = write;
+	regions[region_count].ctx = ctx;
+	region_count++;
+}
+
+static struct sim_region *sim_mmio_find(uintptr_t addr)
+{
+	int i;
+
+	for (i = 0; i < region_count; i++) {
+		if (addr >= regions[i].base &&
+		    addr - regions[i].base < regions[i].size)
+			return &regions[i];
+	}
+	fprintf(stderr, "sim: access to unmodeled register 0x%08lx\n",
+		(unsigned long)addr);
+	abort();
+}
+
+uint64_t sim_mmio_read(uintptr_t addr, int size)
+{
+	struct sim_region *r = sim_mmio_find(addr);
+
+	return r->read(r->ctx, addr - r->base, size);
+}
+
+void sim_mmio_write(uintptr_t addr, uint64_t value, int size)
+{
+	struct sim_region *r = sim_mmio_find(addr);
+
+	r->write(r->ctx, addr - r->base, value, size);
+}
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "otp.h"
+#include "platform.h"
+#include "sim.h"
+
+#define REG(field) offsetof(struct otp_t, field)
+
+/* OTP_AES_KEY_ADDR + 16, addresses are in bytes */
+#define SIM_OTP_SIZE 0x4000
+
+/*
+ * OTP controller, read side only. otp_read_data() hands a bit address to
+ * otp_apb_adr once otp_adr_in_flag is set, the byte is in otp_data when
+ * otp_data_rdy is. Blank fuses read as 0. Programming is not modelled, the
+ * write handshakes never complete and otp_write_data() times out.
+ *
+ * With gb_otp_en set the AES engine takes its key from the fused OTP AES
+ * key instead of the key registers.
+ */
+struct sim_otp {
+	struct otp_t regs;
+	uint8_t fuses[SIM_OTP_SIZE];
+	uint8_t aes_key[16];
+};
+
+static struct sim_otp sim_otp;
+
+void sim_otp_set_aes_key(const uint8_t key[16])
+{
+	memcpy(sim_otp.aes_key, key, sizeof(sim_otp.aes_key));
+}
+
+int sim_otp_key_output(uint8_t key[16])
+{
+	int on = sim_otp.regs.gb_otp_en & 1;
+
+	if (on)
+		memcpy(key, sim_otp.aes_key, sizeof(sim_otp.aes_key));
+	return on;
+}
+
+void sim_otp_fuse(uint32_t addr, const uint8_t *data, uint32_t len)
+{
+	if (addr >= SIM_OTP_SIZE)
+		return;
+	if (len > SIM_OTP_SIZE - addr)
+		len = SIM_OTP_SIZE - addr;
+	memcpy(&sim_otp.fuses[addr], data, len);
+}
+
+static uint64_t sim_otp_read(void *ctx, uint32_t offset, int size)
+{
+	struct sim_otp *o = ctx;
+
+	switch (offset) {
+	case REG(otp_adr_in_flag):
+		return 1;
+	default:
+		if (offset < sizeof(o->regs))
+			return *(uint32_t *)((uint8_t *)&o->regs + offset);
+		return 0;
+	}
+}
+
+static void sim_otp_write(void *ctx, uint32_t offset, uint64_t value,
+			  int size)
+{
+	struct sim_otp *o = ctx;
+	uint32_t v = (uint32_t)value;
+
+	switch (offset) {
+	case REG(otp_apb_adr):
+		o->regs.otp_apb_adr = v;
+		v /= 8;
+		if (v < OTP_BISR_DATA_ADDR) {
+			o->regs.otp_data = o->fuses[v];
+			o->regs.otp_wrg_adr_flag = 0;
+		} else {
+			o->regs.otp_data = 0;
+			o->regs.otp_wrg_adr_flag = 1;
+		}
+		o->regs.otp_data_rdy = 1;
+		break;
+	case REG(otp_ceb):
+		o->regs.otp_ceb = v;
+		o->regs.otp_data_rdy = 0;
+		break;
+	default:
+		if (offset < sizeof(o->regs))
+			*(uint32_t *)((uint8_t *)&o->regs + offset) = v;
+		break;
+	}
+}
+
+void sim_otp_attach(void)
+{
+	memset(&sim_otp.regs, 0, sizeof(sim_otp.regs));
+	sim_mmio_register(OTP_BASE_ADDR, sizeof(struct otp_t), sim_otp_read,
+			  sim_otp_write, &sim_otp);
+}
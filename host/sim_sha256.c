@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "platform.h"
+#include "sha256.h"
+#include "sha256_soft.h"
+#include "sim.h"
+
+#define REG(field) offsetof(struct sha256_t, field)
+
+/*
+ * SHA256 engine: the driver pads the message itself and pushes 16 words per
+ * block into sha_data_in1. Setting bit 0 of sha_status starts a new hash of
+ * sha_data_num blocks, the bit reads back as 1 once they are all compressed.
+ * Words pushed after that are dropped, like a short sha_data_num would.
+ */
+struct sim_sha256 {
+	struct sha256_t regs;
+	uint32_t hash[8];
+	uint8_t block[64];
+	uint32_t block_len;
+	uint32_t blocks_left;
+	int busy;
+};
+
+static struct sim_sha256 sim_sha;
+
+static uint32_t bswap32(uint32_t v)
+{
+	return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) |
+	       (v << 24);
+}
+
+static void sim_sha256_done(struct sim_sha256 *s)
+{
+	SHA256SoftContext ctx;
+	uint8_t digest[32];
+	int i;
+
+	if (s->regs.double_sha & 1) {
+		/* Second pass over the digest of the first one */
+		for (i = 0; i < 8; i++) {
+			uint32_t be = bswap32(s->hash[i]);
+
+			memcpy(&digest[4 * i], &be, 4);
+		}
+		sha256_soft_init(&ctx);
+		sha256_soft_update(&ctx, digest, sizeof(digest));
+		sha256_soft_final(&ctx, digest);
+		memcpy(s->hash, ctx.hash, sizeof(s->hash));
+	}
+	/* Result words are in reverse order and big endian */
+	for (i = 0; i < 8; i++)
+		s->regs.sha_result[7 - i] = bswap32(s->hash[i]);
+	s->busy = 0;
+}
+
+static uint64_t sim_sha256_read(void *ctx, uint32_t offset, int size)
+{
+	struct sim_sha256 *s = ctx;
+
+	switch (offset) {
+	case REG(sha_status):
+		return (s->regs.sha_status & ~1U) | (s->busy ? 0 : 1);
+	case REG(sha_input_ctrl):
+		/* Bit 8 is FIFO full, never the case here */
+		return s->regs.sha_input_ctrl & ~(1U << 8);
+	default:
+		if (offset < sizeof(s->regs))
+			return *(uint32_t *)((uint8_t *)&s->regs + offset);
+		return 0;
+	}
+}
+
+static void sim_sha256_write(void *ctx, uint32_t offset, uint64_t value,
+			     int size)
+{
+	struct sim_sha256 *s = ctx;
+	uint32_t v = (uint32_t)value;
+	static const uint32_t iv[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+					0xa54ff53a, 0x510e527f, 0x9b05688c,
+					0x1f83d9ab, 0x5be0cd19 };
+
+	switch (offset) {
+	case REG(sha_status):
+		s->regs.sha_status = v;
+		if (v & 1) {
+			memcpy(s->hash, iv, sizeof(iv));
+			s->block_len = 0;
+			s->blocks_left = s->regs.sha_data_num;
+			s->busy = s->blocks_left != 0;
+		}
+		break;
+	case REG(sha_data_in1):
+		if (!s->busy)
+			break;
+		/* Words hold the message bytes in memory order */
+		memcpy(&s->block[s->block_len], &v, 4);
+		s->block_len += 4;
+		if (s->block_len == 64) {
+			sha256_soft_transform(s->hash, s->block);
+			s->block_len = 0;
+			if (--s->blocks_left == 0)
+				sim_sha256_done(s);
+		}
+		break;
+	default:
+		if (offset < sizeof(s->regs))
+			*(uint32_t *)((uint8_t *)&s->regs + offset) = v;
+		break;
+	}
+}
+
+void sim_sha256_attach(void)
+{
+	memset(&sim_sha, 0, sizeof(sim_sha));
+	sim_mmio_register(SHA256_BASE_ADDR, sizeof(struct sha256_t),
+			  sim_sha256_read, sim_sha256_write, &sim_sha);
+}
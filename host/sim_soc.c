@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "clint.h"
+#include "entry.h"
+#include "fpioa.h"
+#include "plic.h"
+#include "syscalls.h"
+#include "sysctl.h"
+#include "sim.h"
+
+/*
+ * SoC blocks without a register model. Clocks and resets always succeed,
+ * pins are not routed and there is no interrupt controller: interrupts
+ * are never delivered and MIE stays clear. Core 1 never starts.
+ */
+
+int sysctl_clock_enable(sysctl_clock_t clock)
+{
+	return 0;
+}
+
+int sysctl_clock_disable(sysctl_clock_t clock)
+{
+	return 0;
+}
+
+int sysctl_clock_set_threshold(sysctl_threshold_t which, int threshold)
+{
+	return 0;
+}
+
+uint32_t sysctl_clock_get_freq(sysctl_clock_t clock)
+{
+	return SIM_CPU_FREQ;
+}
+
+void sysctl_reset(sysctl_reset_t reset)
+{
+	/* the end of a scripted CLI session */
+	if (reset == SYSCTL_RESET_SOC) {
+		fflush(stdout);
+		exit(0);
+	}
+}
+
+void sysctl_enable_irq(void)
+{
+}
+
+void sysctl_disable_irq(void)
+{
+}
+
+int fpioa_set_function(int number, fpioa_function_t function)
+{
+	return 0;
+}
+
+void plic_init(void)
+{
+}
+
+int plic_irq_enable(plic_irq_t irq_number)
+{
+	return 0;
+}
+
+int plic_irq_disable(plic_irq_t irq_number)
+{
+	return 0;
+}
+
+int plic_set_priority(plic_irq_t irq_number, uint32_t priority)
+{
+	return 0;
+}
+
+void plic_irq_register(plic_irq_t irq, plic_irq_callback_t callback, void *ctx)
+{
+}
+
+void plic_irq_unregister(plic_irq_t irq)
+{
+}
+
+int clint_ipi_init(void)
+{
+	return 0;
+}
+
+int clint_ipi_enable(void)
+{
+	return 0;
+}
+
+int clint_ipi_disable(void)
+{
+	return 0;
+}
+
+int clint_ipi_send(size_t core_id)
+{
+	return 0;
+}
+
+int clint_ipi_clear(size_t core_id)
+{
+	return 0;
+}
+
+int clint_ipi_unregister(void)
+{
+	return 0;
+}
+
+int register_core1(core_function func, void *ctx)
+{
+	return func ? 0 : -1;
+}
+
+void __attribute__((noreturn)) sys_exit(int code)
+{
+	fflush(stdout);
+	fprintf(stderr, "sim: sys_exit(%d)\n", code);
+	exit(code);
+}
@@ -0,0 +1,726 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "platform.h"
+#include "spi.h"
+#include "sim.h"
+
+#define REG(field) offsetof(struct spi_t, field)
+
+/* SPI3 field positions in ctrlr0 and spi_ctrlr0 */
+#define CTRLR0_DFS(v) (((v) & 0x1f) + 1)
+#define CTRLR0_TMOD(v) (((v) >> 10) & 0x3)
+#define CTRLR0_FRF(v) (((v) >> 22) & 0x3)
+#define SPI_CTRLR0_TRANS_TYPE(v) ((v) & 0x3)
+#define SPI_CTRLR0_ADDR_L(v) (((v) >> 2) & 0xf)
+#define SPI_CTRLR0_INST_L(v) (((v) >> 8) & 0x3)
+#define SPI_CTRLR0_WAIT(v) (((v) >> 11) & 0x1f)
+
+#define TMOD_TX 1
+#define TMOD_RX 2
+#define TMOD_EEPROM 3
+
+#define SIM_SPI_FIFO 32
+#define SIM_SPI_RISR_RXOIR 0x08
+
+#define NOR_PAGE 256
+#define NOR_SECTOR 4096
+#define NOR_SR1_BUSY 0x01
+#define NOR_SR1_WEL 0x02
+/* GD25LQ128 as fitted to the MAIX modules */
+#define NOR_MANUF_ID 0xC8
+#define NOR_DEVICE_ID 0x17
+
+enum nor_phase { NOR_OP, NOR_ADDR, NOR_DUMMY, NOR_DATA, NOR_IGNORE };
+
+struct nor_op_stat {
+	uint64_t count;
+	uint64_t bytes;
+	uint64_t bus_ns;
+	uint64_t busy_ns;
+};
+
+/*
+ * DW SSI controller at SPI3_BASE_ADDR with a SPI NOR behind its first slave
+ * select. Frames pushed into dr while ser is clear wait in the TX FIFO, once
+ * a slave is selected they are clocked out at once. The RX FIFO is filled on
+ * demand: rxflr shows what is left of the ctrlr1 + 1 frames, up to a FIFO.
+ * Deselecting the slave or disabling the controller ends the command.
+ *
+ * Time is simulated, not waited for. When the slave is deselected the CPU
+ * is stalled for what the frames took on the wire at the SCLK of baudr.
+ * Programs, erases and status writes take effect at once but leave the part
+ * busy for the datasheet time: BUSY reads set in SR1 and every other command
+ * is ignored and counted as a violation until then. A status read finding
+ * the part busy costs a poll loop turn of simulated time.
+ *
+ * Power can be cut on a given program or erase: that one is left torn,
+ * none, half or all of its bytes changed as the write count goes, and the
+ * cut callback runs when the slave is deselected.
+ *
+ * A flash byte can be made unreadable: a dual or quad read covering it
+ * stops filling the RX FIFO there and flags an overrun, as a CPU too slow
+ * for the SCLK would see, until rxoicr is read.
+ */
+struct sim_spi_flash {
+	struct spi_t regs;
+	uint32_t tx[SIM_SPI_FIFO];
+	uint32_t tx_count;
+	uint32_t rx_left;
+	int selected;
+	/* frames clocked since the slave was selected */
+	uint32_t tx_frames;
+	uint32_t rx_frames;
+	/* command being clocked */
+	enum nor_phase phase;
+	uint8_t op;
+	uint32_t addr;
+	uint32_t addr_bytes;
+	uint32_t data_count;
+	uint32_t data_addr;
+	/* the part */
+	uint8_t *mem;
+	uint32_t size;
+	uint8_t sr1, sr2;
+	uint8_t wrsr[2];
+	uint64_t busy_until;
+	int busy;
+	struct sim_nor_timing timing;
+	/* write log and power cut */
+	uint64_t writes;
+	FILE *trace;
+	uint64_t cut_at;
+	void (*cut)(uint64_t write);
+	uint32_t undo_addr[NOR_PAGE];
+	uint8_t undo[NOR_PAGE];
+	/* RX FIFO overrun */
+	int overrun;
+	uint32_t overrun_addr;
+	int rxoir;
+	/* statistics */
+	struct nor_op_stat stat[256];
+	uint32_t *erase_count;
+	uint64_t conflicts;
+	uint64_t violations;
+};
+
+static struct sim_spi_flash sim_flash;
+
+static const struct sim_nor_timing nor_timing_default = {
+	/* PLL0 / 2 */
+	.spi_clk = 195000000,
+	/* tPP 0.5 ms for a page */
+	.pp_base_ns = 20000,
+	.pp_byte_ns = 1875,
+	.wrsr_ns = 5000000,
+	.se_4k_ns = 50000000,
+	.be_32k_ns = 160000000,
+	.be_64k_ns = 250000000,
+	.ce_ns = 60000000000ULL,
+	.poll_ns = 2000,
+};
+
+static const struct {
+	uint8_t op;
+	const char *name;
+} nor_ops[] = {
+	{ 0x01, "write_status" },	{ 0x02, "page_program" },
+	{ 0x03, "read" },		{ 0x04, "write_disable" },
+	{ 0x05, "read_status1" },	{ 0x06, "write_enable" },
+	{ 0x0B, "fast_read" },		{ 0x20, "erase_4k" },
+	{ 0x32, "quad_page_program" },	{ 0x35, "read_status2" },
+	{ 0x3B, "dual_output_read" },	{ 0x52, "erase_32k" },
+	{ 0x60, "chip_erase" },		{ 0x6B, "quad_output_read" },
+	{ 0x90, "read_id" },		{ 0xBB, "dual_io_read" },
+	{ 0xC7, "chip_erase" },		{ 0xD8, "erase_64k" },
+	{ 0xEB, "quad_io_read" },
+};
+
+static const char *nor_op_name(uint8_t op)
+{
+	uint32_t i;
+
+	for (i = 0; i < sizeof(nor_ops) / sizeof(nor_ops[0]); i++) {
+		if (nor_ops[i].op == op)
+			return nor_ops[i].name;
+	}
+	return NULL;
+}
+
+static int nor_addr_bytes(uint8_t op)
+{
+	switch (op) {
+	case 0x03: /* read */
+	case 0x0B: /* fast read */
+	case 0x02: /* page program */
+	case 0x20: /* 4K sector erase */
+	case 0x52: /* 32K block erase */
+	case 0xD8: /* 64K block erase */
+	case 0x90: /* manufacturer and device ID */
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+static int nor_writing(uint8_t op)
+{
+	return op == 0x01 || op == 0x02 || op == 0x32 || op == 0x20 ||
+	       op == 0x52 || op == 0xD8 || op == 0x60 || op == 0xC7;
+}
+
+/* Programs and erases, what a power cut can leave half done */
+static int nor_array_op(uint8_t op)
+{
+	return nor_writing(op) && op != 0x01;
+}
+
+static int nor_cutting(struct sim_spi_flash *f)
+{
+	return f->cut && f->writes == f->cut_at && nor_array_op(f->op);
+}
+
+/* Bytes of n a torn write gets done: none, half or all of them */
+static uint32_t nor_torn(struct sim_spi_flash *f, uint32_t n)
+{
+	return n * (f->cut_at % 3) / 2;
+}
+
+/* The internal operation is over once its time has passed */
+static int nor_busy(struct sim_spi_flash *f)
+{
+	if (f->busy && sim_now_ns() >= f->busy_until) {
+		f->busy = 0;
+		f->sr1 &= ~NOR_SR1_WEL;
+	}
+	return f->busy;
+}
+
+static void nor_busy_for(struct sim_spi_flash *f, uint64_t ns)
+{
+	f->busy = 1;
+	f->busy_until = sim_now_ns() + ns;
+	f->stat[f->op].busy_ns += ns;
+}
+
+static void nor_start(struct sim_spi_flash *f, uint8_t op)
+{
+	f->op = op;
+	f->addr = 0;
+	f->addr_bytes = 0;
+	f->data_count = 0;
+	if (op != 0x05 && op != 0x35 && nor_busy(f)) {
+		/* only the status can be read while busy */
+		f->violations++;
+		f->phase = NOR_IGNORE;
+		return;
+	}
+	if (nor_writing(op) && !(f->sr1 & NOR_SR1_WEL)) {
+		/* commands which change the array need a write enable */
+		f->phase = NOR_IGNORE;
+		return;
+	}
+	if (nor_array_op(op))
+		f->writes++;
+	f->phase = nor_addr_bytes(op) ? NOR_ADDR : NOR_DATA;
+}
+
+static void nor_program(struct sim_spi_flash *f, uint8_t b)
+{
+	uint32_t addr = f->addr % f->size;
+
+	if (nor_cutting(f) && f->data_count < NOR_PAGE) {
+		f->undo_addr[f->data_count] = addr;
+		f->undo[f->data_count] = f->mem[addr];
+	}
+	/* programming only clears bits, a 1 over a 0 stays 0 */
+	if (b & ~f->mem[addr])
+		f->conflicts++;
+	f->mem[addr] &= b;
+	/* the address wraps inside the page */
+	f->addr = (f->addr & ~(NOR_PAGE - 1)) |
+		  ((f->addr + 1) & (NOR_PAGE - 1));
+}
+
+/* A frame from the controller, after the opcode and the address */
+static void nor_data_in(struct sim_spi_flash *f, uint8_t b)
+{
+	if (!f->data_count)
+		f->data_addr = f->addr;
+	switch (f->op) {
+	case 0x02:
+	case 0x32:
+		nor_program(f, b);
+		break;
+	case 0x01:
+		if (f->data_count < sizeof(f->wrsr))
+			f->wrsr[f->data_count] = b;
+		break;
+	default:
+		break;
+	}
+	f->data_count++;
+}
+
+/* One byte on a single data line: opcode, address, dummy, then data */
+static void nor_byte_in(struct sim_spi_flash *f, uint8_t b)
+{
+	switch (f->phase) {
+	case NOR_OP:
+		nor_start(f, b);
+		break;
+	case NOR_ADDR:
+		f->addr = (f->addr << 8) | b;
+		if (++f->addr_bytes == 3)
+			f->phase = f->op == 0x0B ? NOR_DUMMY : NOR_DATA;
+		break;
+	case NOR_DUMMY:
+		f->phase = NOR_DATA;
+		break;
+	case NOR_DATA:
+		nor_data_in(f, b);
+		break;
+	case NOR_IGNORE:
+		break;
+	}
+}
+
+/*
+ * Enhanced SPI frames: the instruction, then the address with the width set
+ * in spi_ctrlr0, 32 bits being the 24 bits address and the mode byte.
+ */
+static void nor_frame_in(struct sim_spi_flash *f, uint32_t v)
+{
+	uint32_t addr_l = SPI_CTRLR0_ADDR_L(f->regs.spi_ctrlr0);
+
+	switch (f->phase) {
+	case NOR_OP:
+		nor_start(f, v);
+		if (f->phase == NOR_DATA && addr_l)
+			f->phase = NOR_ADDR;
+		break;
+	case NOR_ADDR:
+		f->addr = addr_l == 8 ? v >> 8 : v & 0xffffff;
+		f->phase = NOR_DATA;
+		break;
+	case NOR_DATA:
+		nor_data_in(f, v);
+		break;
+	default:
+		break;
+	}
+}
+
+static uint8_t nor_status1(struct sim_spi_flash *f)
+{
+	uint64_t now, wait;
+
+	if (!nor_busy(f))
+		return f->sr1;
+	/* the CPU goes round its poll loop once before asking again */
+	now = sim_now_ns();
+	wait = f->busy_until - now;
+	sim_stall(wait < f->timing.poll_ns ? wait : f->timing.poll_ns);
+	return f->sr1 | NOR_SR1_BUSY;
+}
+
+static uint8_t nor_byte_out(struct sim_spi_flash *f)
+{
+	uint8_t b;
+
+	if (f->phase == NOR_IGNORE)
+		return 0xff;
+	switch (f->op) {
+	case 0x03:
+	case 0x0B:
+	case 0x3B:
+	case 0x6B:
+	case 0xBB:
+	case 0xEB:
+		b = f->mem[f->addr % f->size];
+		f->addr++;
+		f->data_count++;
+		return b;
+	case 0x05:
+		return nor_status1(f);
+	case 0x35:
+		return f->sr2;
+	case 0x90:
+		b = (f->addr++ & 1) ? NOR_DEVICE_ID : NOR_MANUF_ID;
+		return b;
+	default:
+		return 0xff;
+	}
+}
+
+/* Of the n bytes the RX FIFO holds, those before the unreadable one */
+static uint32_t nor_readable(struct sim_spi_flash *f, uint32_t n)
+{
+	uint32_t ahead;
+
+	if (!f->overrun || f->phase != NOR_DATA)
+		return n;
+	switch (f->op) {
+	case 0x3B:
+	case 0x6B:
+	case 0xBB:
+	case 0xEB:
+		break;
+	default:
+		return n;
+	}
+	ahead = (f->overrun_addr + f->size - f->addr % f->size) % f->size;
+	if (ahead >= n)
+		return n;
+	if (!ahead)
+		f->rxoir = 1;
+	return ahead;
+}
+
+static void nor_erase(struct sim_spi_flash *f, uint32_t size, uint64_t ns)
+{
+	uint32_t addr = (f->addr % f->size) & ~(size - 1);
+	uint32_t i;
+
+	if (nor_cutting(f))
+		memset(f->mem + addr, 0xff, nor_torn(f, size / 16) * 16);
+	else
+		memset(f->mem + addr, 0xff, size);
+	for (i = 0; i < size / NOR_SECTOR; i++)
+		f->erase_count[addr / NOR_SECTOR + i]++;
+	nor_busy_for(f, ns);
+}
+
+/* The torn write is over, bytes past what it got done are put back */
+static void nor_power_cut(struct sim_spi_flash *f)
+{
+	uint32_t i, n = f->data_count < NOR_PAGE ? f->data_count : NOR_PAGE;
+
+	if (f->op == 0x02 || f->op == 0x32) {
+		for (i = n; i-- > nor_torn(f, n);)
+			f->mem[f->undo_addr[i]] = f->undo[i];
+	}
+	f->cut(f->writes);
+}
+
+/* Chip select goes high: the internal operation starts now */
+static void nor_end(struct sim_spi_flash *f)
+{
+	const struct sim_nor_timing *t = &f->timing;
+
+	if (f->phase == NOR_OP || f->phase == NOR_IGNORE) {
+		f->phase = NOR_OP;
+		return;
+	}
+	switch (f->op) {
+	case 0x06:
+		f->sr1 |= NOR_SR1_WEL;
+		break;
+	case 0x04:
+		f->sr1 &= ~NOR_SR1_WEL;
+		break;
+	case 0x01:
+		if (f->data_count >= 1)
+			f->sr1 = (f->wrsr[0] & ~NOR_SR1_BUSY) | NOR_SR1_WEL;
+		if (f->data_count >= 2)
+			f->sr2 = f->wrsr[1];
+		nor_busy_for(f, t->wrsr_ns);
+		break;
+	case 0x02:
+	case 0x32:
+		if (f->data_count)
+			nor_busy_for(f, t->pp_base_ns + (uint64_t)t->pp_byte_ns *
+								f->data_count);
+		break;
+	case 0x20:
+		nor_erase(f, 4 * 1024, t->se_4k_ns);
+		break;
+	case 0x52:
+		nor_erase(f, 32 * 1024, t->be_32k_ns);
+		break;
+	case 0xD8:
+		nor_erase(f, 64 * 1024, t->be_64k_ns);
+		break;
+	case 0x60:
+	case 0xC7:
+		f->addr = 0;
+		nor_erase(f, f->size, t->ce_ns);
+		break;
+	default:
+		break;
+	}
+	/* WEL drops when the operation completes, see nor_busy() */
+	if (nor_writing(f->op) && !f->busy)
+		f->sr1 &= ~NOR_SR1_WEL;
+	f->phase = NOR_OP;
+	if (f->trace && nor_array_op(f->op))
+		fprintf(f->trace, "sim: write %lu %s 0x%06x %u\n",
+			(unsigned long)f->writes, nor_op_name(f->op),
+			f->data_count ? f->data_addr : f->addr, f->data_count);
+	if (nor_cutting(f))
+		nor_power_cut(f);
+}
+
+/*
+ * SCLK cycles of the transfer just ended: everything on one line in the
+ * standard format, in the enhanced ones the instruction and the address go
+ * on one line or on all of them depending on trans_type, then the wait
+ * cycles and the data on all lines.
+ */
+static uint64_t sim_spi_cycles(struct sim_spi_flash *f)
+{
+	static const uint32_t inst_l_bits[4] = { 0, 4, 8, 16 };
+	uint32_t ctrlr0 = f->regs.ctrlr0, spi_ctrlr0 = f->regs.spi_ctrlr0;
+	uint32_t lanes = 1 << CTRLR0_FRF(ctrlr0);
+	uint32_t dfs = CTRLR0_DFS(ctrlr0);
+	uint32_t trans = SPI_CTRLR0_TRANS_TYPE(spi_ctrlr0);
+	uint32_t inst_bits, addr_bits, frames;
+	uint64_t cycles;
+
+	if (lanes == 1)
+		return (uint64_t)dfs * (f->tx_frames + f->rx_frames);
+
+	inst_bits = inst_l_bits[SPI_CTRLR0_INST_L(spi_ctrlr0)];
+	addr_bits = SPI_CTRLR0_ADDR_L(spi_ctrlr0) * 4;
+	frames = f->tx_frames + f->rx_frames;
+	frames -= (inst_bits ? 1 : 0) + (addr_bits ? 1 : 0);
+	cycles = trans == 2 ? inst_bits / lanes : inst_bits;
+	cycles += trans == 0 ? addr_bits : addr_bits / lanes;
+	cycles += SPI_CTRLR0_WAIT(spi_ctrlr0);
+	cycles += (uint64_t)frames * dfs / lanes;
+	return cycles;
+}
+
+static void sim_spi_frame_out(struct sim_spi_flash *f, uint32_t v)
+{
+	f->tx_frames++;
+	if (CTRLR0_FRF(f->regs.ctrlr0))
+		nor_frame_in(f, v);
+	else
+		nor_byte_in(f, v);
+}
+
+/* Slave selected: everything queued goes out, reads start clocking in */
+static void sim_spi_select(struct sim_spi_flash *f)
+{
+	uint32_t i;
+
+	f->selected = 1;
+	f->tx_frames = 0;
+	f->rx_frames = 0;
+	for (i = 0; i < f->tx_count; i++)
+		sim_spi_frame_out(f, f->tx[i]);
+	f->tx_count = 0;
+
+	switch (CTRLR0_TMOD(f->regs.ctrlr0)) {
+	case TMOD_RX:
+	case TMOD_EEPROM:
+		f->rx_left = f->regs.ctrlr1 + 1;
+		f->rx_frames = f->rx_left;
+		break;
+	default:
+		f->rx_left = 0;
+		break;
+	}
+}
+
+static void sim_spi_deselect(struct sim_spi_flash *f)
+{
+	struct nor_op_stat *s = &f->stat[f->op];
+	uint32_t baudr = f->regs.baudr & 0xfffe;
+	uint64_t ns;
+
+	if (f->selected && f->phase != NOR_OP) {
+		ns = sim_spi_cycles(f) * 1000000000ULL * (baudr ? baudr : 2) /
+		     f->timing.spi_clk;
+		s->count++;
+		s->bytes += f->data_count;
+		s->bus_ns += ns;
+		sim_stall(ns);
+	}
+	if (f->selected)
+		nor_end(f);
+	f->selected = 0;
+	f->tx_count = 0;
+	f->rx_left = 0;
+}
+
+static uint64_t sim_spi_read(void *ctx, uint32_t offset, int size)
+{
+	struct sim_spi_flash *f = ctx;
+
+	switch (offset) {
+	case REG(txflr):
+		return f->tx_count;
+	case REG(rxflr):
+		return nor_readable(f, f->rx_left < SIM_SPI_FIFO ?
+					       f->rx_left : SIM_SPI_FIFO);
+	case REG(sr):
+		/* never busy, TX FIFO empty and not full, RX FIFO not empty */
+		return 0x06 | (f->rx_left ? 0x08 : 0);
+	case REG(risr):
+		return f->rxoir ? SIM_SPI_RISR_RXOIR : 0;
+	case REG(rxoicr):
+		f->rxoir = 0;
+		return 0;
+	case REG(isr):
+	case REG(txoicr):
+		return 0;
+	default:
+		if (offset >= REG(dr) && offset < REG(rx_sample_delay)) {
+			if (!f->rx_left)
+				return 0;
+			f->rx_left--;
+			return nor_byte_out(f);
+		}
+		if (offset < sizeof(f->regs))
+			return *(uint32_t *)((uint8_t *)&f->regs + offset);
+		return 0;
+	}
+}
+
+static void sim_spi_write(void *ctx, uint32_t offset, uint64_t value,
+			  int size)
+{
+	struct sim_spi_flash *f = ctx;
+	uint32_t v = (uint32_t)value;
+
+	switch (offset) {
+	case REG(ssienr):
+		f->regs.ssienr = v & 1;
+		if (!f->regs.ssienr)
+			sim_spi_deselect(f);
+		break;
+	case REG(ser):
+		f->regs.ser = v;
+		if (v && f->regs.ssienr && !f->selected)
+			sim_spi_select(f);
+		else if (!v)
+			sim_spi_deselect(f);
+		break;
+	default:
+		if (offset >= REG(dr) && offset < REG(rx_sample_delay)) {
+			if (!f->regs.ssienr)
+				break;
+			if (f->selected)
+				sim_spi_frame_out(f, v);
+			else if (f->tx_count < SIM_SPI_FIFO)
+				f->tx[f->tx_count++] = v;
+			break;
+		}
+		if (offset < sizeof(f->regs))
+			*(uint32_t *)((uint8_t *)&f->regs + offset) = v;
+		break;
+	}
+}
+
+struct sim_nor_timing *sim_spi_flash_timing(void)
+{
+	return &sim_flash.timing;
+}
+
+uint64_t sim_spi_flash_writes(void)
+{
+	return sim_flash.writes;
+}
+
+void sim_spi_flash_trace(FILE *out)
+{
+	sim_flash.trace = out;
+}
+
+void sim_spi_flash_power_cut(uint64_t write, void (*cut)(uint64_t write))
+{
+	sim_flash.cut_at = write;
+	sim_flash.cut = write ? cut : NULL;
+}
+
+void sim_spi_flash_overrun(uint32_t addr)
+{
+	sim_flash.overrun = 1;
+	sim_flash.overrun_addr = addr % sim_flash.size;
+}
+
+uint32_t sim_spi_flash_erase_count(uint32_t addr)
+{
+	return sim_flash.erase_count[(addr % sim_flash.size) / NOR_SECTOR];
+}
+
+void sim_spi_flash_reset_stats(void)
+{
+	struct sim_spi_flash *f = &sim_flash;
+
+	memset(f->stat, 0, sizeof(f->stat));
+	memset(f->erase_count, 0,
+	       f->size / NOR_SECTOR * sizeof(*f->erase_count));
+	f->conflicts = 0;
+	f->violations = 0;
+}
+
+void sim_spi_flash_report(FILE *out)
+{
+	struct sim_spi_flash *f = &sim_flash;
+	uint32_t i, sectors = 0, max = 0;
+	uint64_t erases = 0;
+
+	fprintf(out, "flash,op,count,bytes,bus_us,busy_us\n");
+	for (i = 0; i < 256; i++) {
+		struct nor_op_stat *s = &f->stat[i];
+
+		if (!s->count)
+			continue;
+		if (nor_op_name(i))
+			fprintf(out, "flash,%s", nor_op_name(i));
+		else
+			fprintf(out, "flash,0x%02X", i);
+		fprintf(out, ",%lu,%lu,%lu.%03lu,%lu.%03lu\n",
+			(unsigned long)s->count, (unsigned long)s->bytes,
+			(unsigned long)(s->bus_ns / 1000),
+			(unsigned long)(s->bus_ns % 1000),
+			(unsigned long)(s->busy_ns / 1000),
+			(unsigned long)(s->busy_ns % 1000));
+	}
+	for (i = 0; i < f->size / NOR_SECTOR; i++) {
+		if (!f->erase_count[i])
+			continue;
+		sectors++;
+		erases += f->erase_count[i];
+		if (f->erase_count[i] > max)
+			max = f->erase_count[i];
+	}
+	fprintf(out, "flash_erase,sectors,%u,erases,%lu,max,%u\n", sectors,
+		(unsigned long)erases, max);
+	fprintf(out, "flash_errors,conflicts,%lu,busy_violations,%lu\n",
+		(unsigned long)f->conflicts, (unsigned long)f->violations);
+}
+
+void sim_spi_flash_attach(uint8_t *mem, uint32_t size)
+{
+	free(sim_flash.erase_count);
+	memset(&sim_flash, 0, sizeof(sim_flash));
+	sim_flash.mem = mem;
+	sim_flash.size = size;
+	sim_flash.timing = nor_timing_default;
+	sim_flash.erase_count = calloc(size / NOR_SECTOR,
+				       sizeof(*sim_flash.erase_count));
+	sim_mmio_register(SPI3_BASE_ADDR, sizeof(struct spi_t), sim_spi_read,
+			  sim_spi_write, &sim_flash);
+}
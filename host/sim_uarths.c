@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "platform.h"
+#include "uarths.h"
+#include "sim.h"
+
+#define REG(field) offsetof(struct uarths_t, field)
+
+#define SIM_UARTHS_FIFO 8
+
+/*
+ * UARTHS on two file descriptors. Transmitted bytes are written out at once,
+ * so the TX FIFO never fills and txwm is always pending. The RX FIFO is
+ * topped up from in_fd, without blocking, whenever rxdata or ip is read.
+ * No line rate is emulated and no interrupt is raised: the host hart runs
+ * with MIE clear and the driver takes its polled paths.
+ *
+ * Scripted input arrives all at once, and what a command polls for ^C would
+ * be lost. With a prompt set, input after a line end is held back until the
+ * prompt has been sent.
+ */
+struct sim_uarths {
+	uint32_t txctrl, rxctrl, ie, div;
+	uint8_t rx[SIM_UARTHS_FIFO];
+	uint32_t rx_count;
+	int in_fd, out_fd;
+	/* line pacing, see sim_uarths_pace() */
+	const char *prompt;
+	size_t matched;
+	int held;
+};
+
+static struct sim_uarths sim_uart;
+
+static void sim_uarths_fill(struct sim_uarths *u)
+{
+	uint8_t c;
+
+	while (u->in_fd >= 0 && !u->held && u->rx_count < SIM_UARTHS_FIFO) {
+		if (read(u->in_fd, &c, 1) != 1)
+			break;
+		u->rx[u->rx_count++] = c;
+		if (u->prompt && c == '\n')
+			u->held = 1;
+	}
+}
+
+/* Watch the output for the prompt which releases the next line */
+static void sim_uarths_sent(struct sim_uarths *u, uint8_t c)
+{
+	if (!u->prompt)
+		return;
+	if (c != u->prompt[u->matched])
+		u->matched = 0;
+	if (c == u->prompt[u->matched] && !u->prompt[++u->matched]) {
+		u->matched = 0;
+		u->held = 0;
+	}
+}
+
+static uint64_t sim_uarths_read(void *ctx, uint32_t offset, int size)
+{
+	struct sim_uarths *u = ctx;
+	uint32_t v;
+
+	switch (offset) {
+	case REG(txdata):
+		return 0;
+	case REG(rxdata):
+		sim_uarths_fill(u);
+		if (!u->rx_count)
+			return UARTHS_RXFIFO_EMPTY;
+		v = u->rx[0];
+		memmove(u->rx, u->rx + 1, --u->rx_count);
+		return v;
+	case REG(txctrl):
+		return u->txctrl;
+	case REG(rxctrl):
+		return u->rxctrl;
+	case REG(ie):
+		return u->ie;
+	case REG(ip):
+		/* rxwm once more than rxcnt bytes wait */
+		sim_uarths_fill(u);
+		v = UARTHS_IP_TXWM;
+		if (u->rx_count > ((u->rxctrl >> 16) & 0x7))
+			v |= UARTHS_IP_RXWM;
+		return v;
+	case REG(div):
+		return u->div;
+	default:
+		return 0;
+	}
+}
+
+static void sim_uarths_write(void *ctx, uint32_t offset, uint64_t value,
+			     int size)
+{
+	struct sim_uarths *u = ctx;
+	uint8_t c = value & UARTHS_FIFO_DATA;
+
+	switch (offset) {
+	case REG(txdata):
+		if (u->out_fd < 0 || !(u->txctrl & UARTHS_TXEN))
+			break;
+		while (write(u->out_fd, &c, 1) != 1 && errno == EAGAIN)
+			continue;
+		sim_uarths_sent(u, c);
+		break;
+	case REG(txctrl):
+		u->txctrl = value;
+		break;
+	case REG(rxctrl):
+		u->rxctrl = value;
+		break;
+	case REG(ie):
+		u->ie = value;
+		break;
+	case REG(div):
+		u->div = value;
+		break;
+	default:
+		break;
+	}
+}
+
+void sim_uarths_attach(int in_fd, int out_fd)
+{
+	memset(&sim_uart, 0, sizeof(sim_uart));
+	sim_uart.in_fd = in_fd;
+	sim_uart.out_fd = out_fd;
+	/* the driver polls, a read must not wait for a byte */
+	if (in_fd >= 0)
+		fcntl(in_fd, F_SETFL, fcntl(in_fd, F_GETFL) | O_NONBLOCK);
+	sim_mmio_register(UARTHS_BASE_ADDR, sizeof(struct uarths_t),
+			  sim_uarths_read, sim_uarths_write, &sim_uart);
+}
+
+void sim_uarths_pace(const char *prompt)
+{
+	sim_uart.prompt = prompt;
+	sim_uart.matched = 0;
+	sim_uart.held = 0;
+}
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "flash_map.h"
+
+const struct flash_part flash_map[] = {
+	{ "stage1", 0x000000, 64 * 1024 },
+	{ "stage2_app", 0x010000, 64 * 1024 },
+	{ "stage2_bak", 0x020000, 64 * 1024 },
+	{ "app", 0x030000, 320 * 1024 },
+	{ "bak", 0x080000, 320 * 1024 },
+	{ "algorithm", 0x0D0000, 1024 * 1024 },
+	{ "keypoint", 0x1D0000, 192 * 1024 },
+	{ "detect", 0x200000, 320 * 1024 },
+	{ "feature", 0x250000, 1024 * 1024 },
+	{ "alive", 0x350000, 1024 * 1024 },
+	{ "jpeg", 0x450000, 1728 * 1024 },
+	{ "journal", FLASH_JOURNAL_OFFSET, FLASH_JOURNAL_SIZE },
+};
+
+const uint32_t flash_map_parts = sizeof(flash_map) / sizeof(flash_map[0]);
+
+const struct flash_part *flash_map_find(const char *name)
+{
+	const struct flash_part *p;
+
+	for (p = flash_map; p < flash_map + flash_map_parts; p++) {
+		if (strcmp(name, p->name) == 0)
+			return p;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "crc.h"
+#include "flash.h"
+#include "journal.h"
+
+/* Block protect bits of status register 1 */
+#define JOURNAL_SR1_PROTECT 0xfc
+/* Header, sector bitmap and boot count, the rest of the sector is unused */
+#define JOURNAL_USED (JOURNAL_BOOTS_OFFSET + 1)
+
+static uint8_t journal_buf[JOURNAL_SECTOR];
+
+static uint32_t journal_crc(const struct journal_entry *e)
+{
+	return crc32c_update(CRC_START_32C, e,
+			     offsetof(struct journal_entry, crc));
+}
+
+static int journal_read(uint32_t journal, struct journal_entry *e)
+{
+	flash_read_data(journal, (uint8_t *)e, sizeof(*e), FLASH_QUAD_SINGLE);
+
+	return e->magic == JOURNAL_MAGIC && e->op == JOURNAL_OP_COPY &&
+	       e->crc == journal_crc(e) && e->length != 0 &&
+	       e->length <= JOURNAL_MAX_SECTORS * JOURNAL_SECTOR;
+}
+
+/* Status register writes wear the part, only done when protection is on */
+static void journal_unprotect(void)
+{
+	uint8_t reg1;
+
+	flash_read_status_reg1(&reg1);
+	if (reg1 & JOURNAL_SR1_PROTECT)
+		flash_disable_protect();
+}
+
+static void journal_erase(uint32_t journal)
+{
+	journal_unprotect();
+	flash_sector_erase(journal);
+}
+
+/* First bit still set from i on, n when there is none */
+static uint32_t journal_next(const uint8_t *bits, uint32_t i, uint32_t n)
+{
+	while (i < n && !(bits[i / 8] & (1U << (i % 8))))
+		i++;
+	return i;
+}
+
+static uint32_t journal_left(const uint8_t *bits, uint32_t n)
+{
+	uint32_t i, left = 0;
+
+	for (i = 0; i < n; i++)
+		left += !!(bits[i / 8] & (1U << (i % 8)));
+	return left;
+}
+
+static void journal_clear_bit(uint32_t addr, uint8_t *bits, uint32_t i)
+{
+	bits[i / 8] &= ~(1U << (i % 8));
+	flash_write_data(addr + i / 8, &bits[i / 8], 1);
+}
+
+static uint32_t journal_sectors(const struct journal_entry *e)
+{
+	return (e->length + JOURNAL_SECTOR - 1) / JOURNAL_SECTOR;
+}
+
+static int journal_verify(uint32_t addr, const uint8_t *data, uint32_t len)
+{
+	uint8_t buf[256];
+	uint32_t n;
+
+	for (; len; addr += n, data += n, len -= n) {
+		n = len > sizeof(buf) ? sizeof(buf) : len;
+		if (flash_read_data(addr, buf, n, FLASH_QUAD_SINGLE) !=
+			    FLASH_OK ||
+		    memcmp(buf, data, n) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+int journal_begin(uint32_t journal, uint32_t src, uint32_t dst,
+		  uint32_t length, uint32_t hash_offset)
+{
+	uint8_t bits[JOURNAL_MAX_SECTORS / 8];
+	struct journal_entry e, old;
+	uint32_t i;
+
+	if (length == 0 || length > JOURNAL_MAX_SECTORS * JOURNAL_SECTOR)
+		return -1;
+
+	memset(&e, 0, sizeof(e));
+	e.magic = JOURNAL_MAGIC;
+	e.op = JOURNAL_OP_COPY;
+	e.src = src;
+	e.dst = dst;
+	e.length = length;
+	e.hash_offset = hash_offset;
+	flash_read_data(src + hash_offset, e.digest, sizeof(e.digest),
+			FLASH_QUAD_SINGLE);
+	e.crc = journal_crc(&e);
+
+	/* the same copy left by a previous boot goes on where it stopped */
+	if (journal_read(journal, &old) && memcmp(&old, &e, sizeof(e)) == 0) {
+		flash_read_data(journal + JOURNAL_BITMAP_OFFSET, bits,
+				sizeof(bits), FLASH_QUAD_SINGLE);
+		if (journal_left(bits, journal_sectors(&e)))
+			return 0;
+	}
+
+	flash_read_data(journal, journal_buf, JOURNAL_USED, FLASH_QUAD_SINGLE);
+	for (i = 0; i < JOURNAL_USED && journal_buf[i] == 0xff; i++)
+		;
+	if (i < JOURNAL_USED)
+		journal_erase(journal);
+	else
+		journal_unprotect();
+	flash_write_data(journal, (uint8_t *)&e, sizeof(e));
+
+	return 0;
+}
+
+int journal_boot(uint32_t journal)
+{
+	struct journal_entry e;
+	uint8_t boots;
+	int counted = 0;
+
+	if (!journal_read(journal, &e))
+		return 0;
+
+	flash_read_data(journal + JOURNAL_BOOTS_OFFSET, &boots, 1,
+			FLASH_QUAD_SINGLE);
+	while (counted < 8 && !(boots & (1U << counted)))
+		counted++;
+	if (counted < 8)
+		journal_clear_bit(journal + JOURNAL_BOOTS_OFFSET, &boots,
+				  counted++);
+
+	return counted;
+}
+
+int journal_step(uint32_t journal, uint32_t sectors)
+{
+	uint8_t bits[JOURNAL_MAX_SECTORS / 8];
+	uint8_t digest[SHA256_HASH_SIZE];
+	struct journal_entry e;
+	uint32_t i, n, off, len;
+
+	if (!journal_read(journal, &e))
+		return 0;
+	n = journal_sectors(&e);
+	flash_read_data(journal + JOURNAL_BITMAP_OFFSET, bits, sizeof(bits),
+			FLASH_QUAD_SINGLE);
+	i = journal_next(bits, 0, n);
+
+	if (i < n && sectors) {
+		flash_read_data(e.src + e.hash_offset, digest, sizeof(digest),
+				FLASH_QUAD_SINGLE);
+		if (memcmp(digest, e.digest, sizeof(digest)) != 0) {
+			journal_erase(journal);
+			return -1;
+		}
+		journal_unprotect();
+	}
+
+	for (; i < n && sectors; sectors--) {
+		off = i * JOURNAL_SECTOR;
+		len = e.length - off > JOURNAL_SECTOR ? JOURNAL_SECTOR :
+							 e.length - off;
+		/* A failed read erases nothing, the sector stays pending */
+		if (flash_read_bulk(e.src + off, journal_buf, len) != FLASH_OK)
+			return -1;
+		flash_sector_erase(e.dst + off);
+		flash_write_data(e.dst + off, journal_buf, len);
+		if (journal_verify(e.dst + off, journal_buf, len) != 0)
+			return -1;
+		journal_clear_bit(journal + JOURNAL_BITMAP_OFFSET, bits, i);
+		i = journal_next(bits, i + 1, n);
+	}
+
+	if (i == n) {
+		journal_erase(journal);
+		return 0;
+	}
+	return journal_left(bits, n);
+}
+
+void journal_cancel(uint32_t journal)
+{
+	struct journal_entry e;
+
+	if (journal_read(journal, &e))
+		journal_erase(journal);
+}
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Service table of stage 2 for the application, see svc.h. On the target
+ * every entry goes through a crt.S trampoline which loads the loader gp,
+ * the host build calls the functions directly.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "encoding.h"
+#include "flash.h"
+#include "journal.h"
+#include "svc.h"
+
+#ifndef BUILD_VERSION
+#define BUILD_VERSION "unstable dev"
+#endif
+
+#define SVC_SECTOR (4 * 1024)
+#define SVC_BLOCK (64 * 1024)
+
+#ifdef CONFIG_HOST_SIM
+#define SVC_ENTRY(name) svc_##name
+#else
+#define SVC_ENTRY(name) svc_entry_##name
+#endif
+
+static struct svc_boot_info svc_info;
+static int svc_unprotected;
+
+static int svc_flash_range(uint32_t addr, uint32_t len)
+{
+	return addr <= FLASH_CHIP_SIZE && len <= FLASH_CHIP_SIZE - addr;
+}
+
+/* Status register protection is cleared once, on the first write */
+static void svc_flash_unprotect(void)
+{
+	if (svc_unprotected)
+		return;
+	flash_disable_protect();
+	svc_unprotected = 1;
+}
+
+int svc_flash_read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+	if (!svc_flash_range(addr, len))
+		return -1;
+	if (flash_read_bulk(addr, buf, len) != FLASH_OK)
+		return -1;
+	return 0;
+}
+
+int svc_flash_erase(uint32_t addr, uint32_t len)
+{
+	uint32_t end = addr + len;
+
+	if (!svc_flash_range(addr, len))
+		return -1;
+	/* An empty range holds no sector */
+	if (len == 0)
+		return 0;
+	svc_flash_unprotect();
+	addr &= ~(SVC_SECTOR - 1);
+	while (addr < end) {
+		if (addr % SVC_BLOCK == 0 && end - addr >= SVC_BLOCK) {
+			flash_64k_block_erase(addr);
+			addr += SVC_BLOCK;
+		} else {
+			flash_sector_erase(addr);
+			addr += SVC_SECTOR;
+		}
+	}
+	return 0;
+}
+
+int svc_flash_program(uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+	if (!svc_flash_range(addr, len))
+		return -1;
+	svc_flash_unprotect();
+	flash_write_data(addr, (uint8_t *)buf, len);
+	return 0;
+}
+
+int svc_sha256_init(SHA256Context *ctx, uint32_t total)
+{
+	return sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, total, ctx);
+}
+
+void svc_sha256_update(SHA256Context *ctx, const void *data, uint32_t len)
+{
+	sha256_update(ctx, data, len);
+}
+
+void svc_sha256_final(SHA256Context *ctx, uint8_t digest[SHA256_HASH_SIZE])
+{
+	sha256_final(ctx, digest);
+}
+
+int svc_aes_open(struct aes_session *session, const uint8_t *key)
+{
+	if (key == AES_SESSION_OTP_KEY) {
+		memset(session, 0, sizeof(*session));
+		return -1;
+	}
+	aes_session_open(session, key);
+	return 0;
+}
+
+int svc_aes_decrypt(struct aes_session *session, uint8_t *in, uint8_t *out,
+		    uint32_t len, const uint8_t *iv)
+{
+	return aes_session_decrypt(session, in, out, len, iv);
+}
+
+void svc_aes_close(struct aes_session *session)
+{
+	aes_session_close(session);
+}
+
+const struct flash_part *svc_partition(const char *name)
+{
+	return flash_map_find(name);
+}
+
+const struct svc_boot_info *svc_boot_info(void)
+{
+	return &svc_info;
+}
+
+int svc_sync_step(uint32_t sectors)
+{
+	return journal_step(JOURNAL_ADDR(2), sectors);
+}
+
+#ifndef CONFIG_HOST_SIM
+extern int svc_entry_flash_read(uint32_t, uint8_t *, uint32_t);
+extern int svc_entry_flash_erase(uint32_t, uint32_t);
+extern int svc_entry_flash_program(uint32_t, const uint8_t *, uint32_t);
+extern int svc_entry_sha256_init(SHA256Context *, uint32_t);
+extern void svc_entry_sha256_update(SHA256Context *, const void *, uint32_t);
+extern void svc_entry_sha256_final(SHA256Context *, uint8_t *);
+extern int svc_entry_aes_open(struct aes_session *, const uint8_t *);
+extern int svc_entry_aes_decrypt(struct aes_session *, uint8_t *, uint8_t *,
+				 uint32_t, const uint8_t *);
+extern void svc_entry_aes_close(struct aes_session *);
+extern const struct flash_part *svc_entry_partition(const char *);
+extern const struct svc_boot_info *svc_entry_boot_info(void);
+extern int svc_entry_sync_step(uint32_t);
+#endif
+
+static const struct svc_table svc_table = {
+	.magic = SVC_MAGIC,
+	.version = SVC_VERSION,
+	.size = sizeof(struct svc_table),
+	.flash_read = SVC_ENTRY(flash_read),
+	.flash_erase = SVC_ENTRY(flash_erase),
+	.flash_program = SVC_ENTRY(flash_program),
+	.sha256_init = SVC_ENTRY(sha256_init),
+	.sha256_update = SVC_ENTRY(sha256_update),
+	.sha256_final = SVC_ENTRY(sha256_final),
+	.aes_open = SVC_ENTRY(aes_open),
+	.aes_decrypt = SVC_ENTRY(aes_decrypt),
+	.aes_close = SVC_ENTRY(aes_close),
+	.partition = SVC_ENTRY(partition),
+	.boot_info = SVC_ENTRY(boot_info),
+	.sync_step = SVC_ENTRY(sync_step),
+};
+
+void svc_publish(uint32_t image_offset, int app_check, int bak_check,
+		 int sync)
+{
+	struct svc_boot_info *info = &svc_info;
+
+	memset(info, 0, sizeof(*info));
+	info->stage = 2;
+	info->image_offset = image_offset;
+	flash_read_data(image_offset, &info->image_flag, 1, FLASH_QUAD_SINGLE);
+	flash_read_data(image_offset + 1, (uint8_t *)&info->image_length, 4,
+			FLASH_QUAD_SINGLE);
+	flash_read_data(image_offset + 5 + info->image_length,
+			info->image_digest, SHA256_HASH_SIZE,
+			FLASH_QUAD_SINGLE);
+	info->sync = sync;
+	info->app_check = app_check;
+	info->bak_check = bak_check;
+	strncpy(info->build, BUILD_VERSION, sizeof(info->build) - 1);
+	info->boot_cycles = read_cycle();
+
+	*(const struct svc_table *volatile *)SVC_TABLE_PTR = &svc_table;
+}
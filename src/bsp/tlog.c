@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include "crc.h"
+#include "encoding.h"
+#include "printf.h"
+#include "tlog.h"
+#include "uarths.h"
+
+/*
+ * One ring per core, so each has a single producer. Indexes only ever grow,
+ * records may wrap around the end of buf.
+ */
+struct tlog_ring {
+	uint64_t buf[TLOG_RING_WORDS];
+	uint32_t head;
+};
+
+static struct tlog_ring tlog_rings[2];
+
+void tlog_write(uint32_t id, unsigned int nargs, ...)
+{
+	struct tlog_ring *ring = &tlog_rings[current_coreid() & 1];
+	uint64_t mie;
+	uint32_t head;
+	va_list ap;
+
+	if (nargs > TLOG_MAX_ARGS)
+		nargs = TLOG_MAX_ARGS;
+
+	/* An interrupt logging in between would tear the record */
+	mie = read_csr(mstatus) & MSTATUS_MIE;
+	clear_csr(mstatus, MSTATUS_MIE);
+
+	head = ring->head;
+	ring->buf[head++ % TLOG_RING_WORDS] =
+		TLOG_MAGIC << 48 | (uint64_t)nargs << 32 | id;
+	ring->buf[head++ % TLOG_RING_WORDS] = read_cycle();
+	va_start(ap, nargs);
+	while (nargs--)
+		ring->buf[head++ % TLOG_RING_WORDS] = va_arg(ap, uint64_t);
+	va_end(ap);
+	ring->head = head;
+
+	set_csr(mstatus, mie);
+}
+
+static void tlog_send(const void *data, uint32_t len)
+{
+	const uint8_t *p = data;
+
+	while (len--)
+		uart_putchar(*p++);
+}
+
+void tlog_dump(void)
+{
+	uint32_t core, head, count, first, n;
+	uint32_t crc;
+	uint8_t crcbuf[4];
+	struct tlog_ring *ring;
+
+	for (core = 0; core < 2; core++) {
+		ring = &tlog_rings[core];
+		head = ring->head;
+		count = head < TLOG_RING_WORDS ? head : TLOG_RING_WORDS;
+		first = (head - count) % TLOG_RING_WORDS;
+
+		printk("## Token log core %u: %u of %u words\n", core, count,
+		       head);
+
+		/* oldest part up to the end of buf, then the wrapped part */
+		n = count < TLOG_RING_WORDS - first ? count :
+						      TLOG_RING_WORDS - first;
+		crc = crc32c_update(CRC_START_32C, &ring->buf[first], n * 8);
+		crc = crc32c_update(crc, ring->buf, (count - n) * 8);
+		tlog_send(&ring->buf[first], n * 8);
+		tlog_send(ring->buf, (count - n) * 8);
+
+		crcbuf[0] = crc;
+		crcbuf[1] = crc >> 8;
+		crcbuf[2] = crc >> 16;
+		crcbuf[3] = crc >> 24;
+		tlog_send(crcbuf, sizeof(crcbuf));
+		printk("\n");
+	}
+}
+
+void tlog_clear(void)
+{
+	memset(tlog_rings, 0, sizeof(tlog_rings));
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include "cli.h"
+#include "printf.h"
+#include "uarths.h"
+
+/* Quiet time allowed before the host probes and before it confirms, in ms */
+#define BAUD_PROBE_TIMEOUT 1000
+#define BAUD_CONFIRM_TIMEOUT 300
+
+/*
+ * Sent by the host at the new rate and echoed back inverted, so both
+ * directions are checked. Runs of ones and zeros, every single bit set and
+ * alternating patterns catch a wrong divider and marginal sampling points.
+ * Keep in sync with utils/loadx.py.
+ */
+static const uint8_t baud_probe[] = { 0x55, 0xAA, 0x00, 0xFF, 0x0F, 0xF0,
+				      0x33, 0xCC, 0x01, 0x02, 0x04, 0x08,
+				      0x10, 0x20, 0x40, 0x80 };
+/* Host got our answer and stays at the new rate */
+static const uint8_t baud_confirm[] = { 'B', 'D', 'O', 'K' };
+
+static int baud_expect(const uint8_t *pattern, int len, uint32_t timeout_ms)
+{
+	int i = 0, c;
+
+	while (i < len) {
+		c = uart_getc_timeout(timeout_ms);
+		if (c < 0)
+			return -1;
+		if (c == pattern[i])
+			i++;
+		else
+			i = c == pattern[0];
+	}
+	return 0;
+}
+
+int baud_switch(uint32_t baud)
+{
+	uint32_t old = uart_get_baudrate();
+	int i;
+
+	if (!uart_baudrate_valid(baud)) {
+		printk("## Baud rate %u not reachable\n", baud);
+		return -1;
+	}
+
+	/* Host switches when it sees this line, it is drained before we do */
+	printk("## Switch to %u baud\n", baud);
+	uart_set_baudrate(baud);
+
+	if (baud_expect(baud_probe, sizeof(baud_probe), BAUD_PROBE_TIMEOUT) ==
+	    0) {
+		for (i = 0; i < sizeof(baud_probe); i++)
+			uart_putchar(~baud_probe[i]);
+		if (baud_expect(baud_confirm, sizeof(baud_confirm),
+				BAUD_CONFIRM_TIMEOUT) == 0) {
+			printk("## Baud rate %u\n", baud);
+			return 0;
+		}
+	}
+
+	uart_set_baudrate(old);
+	printk("## Baud switch failed, back to %u\n", old);
+	return -1;
+}
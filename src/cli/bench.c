@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "aes.h"
+#include "bench.h"
+#include "cli.h"
+#include "common.h"
+#include "crc.h"
+#include "flash.h"
+#include "printf.h"
+#include "sha256.h"
+#include "sha256_soft.h"
+#include "sysctl.h"
+
+#ifdef CONFIG_HOST_SIM
+#include <time.h>
+#endif
+
+/* Stop a measurement after 1/BENCH_TIME_DIV second or BENCH_MAX_CALLS */
+#define BENCH_TIME_DIV 50
+#define BENCH_MAX_CALLS 10000
+
+/* Images are read from the APP slot by flash_image_check() */
+#define BENCH_FLASH_ADDR 0x30000
+
+/* Case may run on unaligned buffers */
+#define BENCH_UNALIGNED (1U << 0)
+
+typedef void (*bench_fn)(uint8_t *dst, const uint8_t *src, uint32_t size);
+
+struct bench_case {
+	const char *name;
+	bench_fn fn;
+	uint32_t flags;
+};
+
+static const uint32_t bench_sizes[] = { 16, 64, 512, 4096, BENCH_MAX_SIZE };
+static const uint32_t bench_aligns[] = { 0, 1, 3 };
+
+#ifdef CONFIG_HOST_SIM
+static uint64_t bench_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t bench_clock_hz(void)
+{
+	return 1000000000ULL;
+}
+#else
+static uint64_t bench_clock(void)
+{
+	return read_cycle();
+}
+
+static uint64_t bench_clock_hz(void)
+{
+	return sysctl_clock_get_freq(SYSCTL_CLOCK_CPU);
+}
+#endif
+
+static void bench_sha256(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	SHA256Context sha256_context;
+
+	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, size, &sha256_context);
+	sha256_update(&sha256_context, src, size);
+	sha256_final(&sha256_context, dst);
+}
+
+static void bench_sha256_soft(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	SHA256SoftContext sha256_context;
+
+	sha256_soft_init(&sha256_context);
+	sha256_soft_update(&sha256_context, src, size);
+	sha256_soft_final(&sha256_context, dst);
+}
+
+/* AES-128-CBC decipher 16 bytes per call, as flash_image_check() does */
+static void bench_aes_block(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	uint8_t aes_key[16] = { 0 };
+	uint8_t aes_iv[16] = { 0 };
+	uint32_t i;
+
+	sysctl_clock_enable(SYSCTL_CLOCK_AES);
+	sysctl_reset(SYSCTL_RESET_AES);
+	aes_init(aes_key, 16, aes_iv, 16, NULL, AES_CBC, AES_DENCRPTION, 0,
+		 size);
+	for (i = 0; i < size; i += 16)
+		aes_process((uint8_t *)src + i, dst + i, 16, AES_CBC);
+}
+
+/* AES-128-CBC decipher the whole buffer with one aes_process() */
+static void bench_aes(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	uint8_t aes_key[16] = { 0 };
+	uint8_t aes_iv[16] = { 0 };
+
+	sysctl_clock_enable(SYSCTL_CLOCK_AES);
+	sysctl_reset(SYSCTL_RESET_AES);
+	aes_init(aes_key, 16, aes_iv, 16, NULL, AES_CBC, AES_DENCRPTION, 0,
+		 size);
+	aes_process((uint8_t *)src, dst, size, AES_CBC);
+}
+
+static void bench_crc16(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	*(volatile uint16_t *)dst = crc_16(src, size);
+}
+
+static void bench_crc32c(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	*(volatile uint32_t *)dst = crc32c_update(CRC_START_32C, src, size);
+}
+
+static void bench_memcpy(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	memcpy(dst, src, size);
+}
+
+#ifndef CONFIG_HOST_SIM
+static void bench_flread(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	flash_read_data(BENCH_FLASH_ADDR, dst, size, FLASH_QUAD_SINGLE);
+}
+#endif
+
+static const struct bench_case bench_cases[] = {
+	{ "sha256", bench_sha256, BENCH_UNALIGNED },
+	{ "sha256sw", bench_sha256_soft, BENCH_UNALIGNED },
+	{ "aes16", bench_aes_block, 0 },
+	{ "aes", bench_aes, 0 },
+	{ "crc16", bench_crc16, BENCH_UNALIGNED },
+	{ "crc32c", bench_crc32c, BENCH_UNALIGNED },
+	{ "memcpy", bench_memcpy, BENCH_UNALIGNED },
+#ifndef CONFIG_HOST_SIM
+	{ "flread", bench_flread, BENCH_UNALIGNED },
+#endif
+};
+
+#define BENCH_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+static void bench_one(const struct bench_case *bc, uint8_t *buf, uint32_t size,
+		      uint32_t align)
+{
+	uint8_t *src = buf + align;
+	uint8_t *dst = buf + BENCH_MAX_SIZE + 64 + align;
+	uint64_t budget = bench_clock_hz() / BENCH_TIME_DIV;
+	uint64_t start, cycles;
+	uint64_t kbps = 0;
+	uint32_t calls = 0;
+
+	/* First call warms the caches, it is not timed */
+	bc->fn(dst, src, size);
+
+	start = bench_clock();
+	do {
+		bc->fn(dst, src, size);
+		calls++;
+		cycles = bench_clock() - start;
+	} while (cycles < budget && calls < BENCH_MAX_CALLS);
+
+	if (cycles)
+		kbps = (uint64_t)size * calls * bench_clock_hz() / cycles /
+		       1024;
+
+	printk("bench,%s,%u,%u,%u,%lu,%lu,%lu\n", bc->name, size, align,
+	       calls, (unsigned long)cycles, (unsigned long)(cycles / calls),
+	       (unsigned long)kbps);
+}
+
+/* The engine must agree with software before its numbers mean anything */
+static int bench_check(uint8_t *buf)
+{
+	uint8_t hash_hw[SHA256_HASH_SIZE], hash_sw[SHA256_SOFT_HASH_SIZE];
+	uint32_t i;
+	int ret = 0;
+
+	for (i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+		bench_sha256(hash_hw, buf + 1, bench_sizes[i] - 1);
+		bench_sha256_soft(hash_sw, buf + 1, bench_sizes[i] - 1);
+		if (memcmp(hash_hw, hash_sw, SHA256_HASH_SIZE) != 0) {
+			printk("check,sha256,%u,FAIL\n", bench_sizes[i] - 1);
+			ret = 1;
+		}
+	}
+	if (ret == 0)
+		printk("check,sha256,ok\n");
+
+	return ret;
+}
+
+int bench_run(uint8_t *buf, const char *name)
+{
+	const struct bench_case *bc;
+	uint32_t seed = 0x12345678;
+	uint32_t i, s, a;
+	int found = 0;
+
+	/* xorshift, so buffers do not compress or hit zero fast paths */
+	for (i = 0; i < BENCH_BUF_SIZE; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		buf[i] = (uint8_t)seed;
+	}
+
+#ifndef CONFIG_HOST_SIM
+	// 1 for internal (SPI3) 0 for external (SPI0)
+	flash_init(1);
+	flash_enable_quad_mode();
+#endif
+
+	printk("# clock,%lu\n", (unsigned long)bench_clock_hz());
+	printk("# bench,name,size,align,calls,cycles,cycles_per_call,kbps\n");
+
+	if (bench_check(buf) != 0)
+		return 1;
+
+	for (bc = bench_cases; bc < bench_cases + BENCH_CASES; bc++) {
+		if (name && strcmp(name, bc->name) != 0)
+			continue;
+		found = 1;
+		for (s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]);
+		     s++) {
+			for (a = 0;
+			     a < sizeof(bench_aligns) / sizeof(bench_aligns[0]);
+			     a++) {
+				if (bench_aligns[a] &&
+				    !(bc->flags & BENCH_UNALIGNED))
+					continue;
+				bench_one(bc, buf, bench_sizes[s],
+					  bench_aligns[a]);
+			}
+		}
+	}
+
+	if (!found) {
+		printk("Unknown benchmark: %s\n", name);
+		return 1;
+	}
+
+	return 0;
+}
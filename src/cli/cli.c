@@ -24,6 +24,7 @@
 #include "common.h"
 #include "ctype.h"
 #include "printf.h"
+#include "rpc.h"
 #include "sleep.h"
 #include "uarths.h"
 
@@ -78,6 +79,7 @@ int cli_readline_into_buffer(const char *const prompt, char *buffer,
 	int plen = 0; /* prompt length */
 	int col; /* output column cnt */
 	int c;
+	uint32_t last = 0; /* last bytes received, to spot RPC_MAGIC */
 
 	/* print prompt */
 	if (prompt) {
@@ -87,9 +89,17 @@ int cli_readline_into_buffer(const char *const prompt, char *buffer,
 	col = plen;
 
 	for (;;) {
-		msleep(100);
+		c = timeout ? uart_getc_timeout(timeout) : uart_getc();
+		if (c < 0) {
+			p_buf[0] = '\0'; /* discard input */
+			return -3;
+		}
 
-		c = uart_getc();
+		last = last << 8 | (c & 0xff);
+		if (last == RPC_MAGIC_WORD) {
+			p_buf[0] = '\0'; /* discard input */
+			return -2;
+		}
 
 		/*
 		 * Special character handling
@@ -171,7 +181,8 @@ int cli_readline(const char *const prompt)
 	 */
 	console_buffer[0] = '\0';
 
-	return cli_readline_into_buffer(prompt, console_buffer, 0);
+	return cli_readline_into_buffer(prompt, console_buffer,
+					CONFIG_CLI_IDLE_TIMEOUT);
 }
 
 int cli_simple_parse_line(char *line, char *argv[])
@@ -300,6 +311,8 @@ void cli_simple_loop(void)
 
 	debug_parser("Entering CLI now...\n");
 	cmd_init();
+	/* Keep receiving while commands erase, program or hash */
+	uart_rx_irq_enable();
 
 	for (;;) {
 		len = cli_readline(CONFIG_SYS_PROMPT);
@@ -308,7 +321,9 @@ void cli_simple_loop(void)
 			strlcpy(lastcommand, console_buffer,
 				CONFIG_SYS_CBSIZE + 1);
 
-		if (len == -1)
+		if (len == -3 || (len == -2 && rpc_serve() < 0))
+			return;
+		else if (len == -1)
 			printk("<INTERRUPT>\n");
 		else if (len > 0)
 			cli_simple_run_command(lastcommand);
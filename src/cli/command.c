@@ -21,14 +21,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include "bench.h"
 #include "cli.h"
 #include "common.h"
 #include "ctype.h"
 #include "flash.h"
+#include "loadx.h"
+#include "platform.h"
 #include "printf.h"
+#include "sha256.h"
 #include "sleep.h"
 #include "spi.h"
 #include "sysctl.h"
+#include "tlog.h"
 #include "uarths.h"
 
 #define CONFIG_SYS_HELP_CMD_WIDTH 8
@@ -411,6 +416,138 @@ int do_loadb(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
 	return rcode;
 }
 
+/* loadx <ramaddr> */
+int do_loadx(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
+{
+	uintptr_t ramaddr = argc > 1 ? simple_strtoul(argv[1], NULL, 16) : 0;
+	unsigned long size;
+
+	if (argc < 2 || ramaddr < RAM_BASE_ADDR ||
+	    ramaddr >= RAM_BASE_ADDR + RAM_SIZE)
+		return CMD_RET_USAGE;
+
+	printk("## Ready for binary (loadx) download to 0x%08lX...\n",
+	       ramaddr);
+
+	size = load_serial_x(ramaddr, RAM_BASE_ADDR + RAM_SIZE - ramaddr);
+
+	if (size == LOADX_ERROR) {
+		printk("## Binary (loadx) download aborted\n");
+		return 1;
+	}
+
+	printk("## Start Addr      = 0x%08lX\n", ramaddr);
+	printk("## Total Size      = 0x%08lX = %lu Bytes\n", size, size);
+	printk("## CRC32C          = 0x%08X\n",
+	       crc32c_update(CRC_START_32C, (uint8_t *)ramaddr, size));
+	return 0;
+}
+
+/* flashrx <floffset> */
+int do_flashrx(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
+{
+	uint32_t offset;
+	unsigned long size;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	offset = simple_strtoul(argv[1], NULL, 16);
+	if (offset % FLASH_SECTOR_SIZE != 0) {
+		printk("\n## ERROR: floffset must be aligned with 0x1000!\n\n");
+		return 1;
+	}
+
+	printk("## Ready for binary (flashrx) download to flash 0x%08X...\n",
+	       offset);
+
+	size = flash_serial_x(offset);
+
+	if (size == LOADX_ERROR) {
+		printk("## Binary (flashrx) download aborted\n");
+		return 1;
+	}
+
+	printk("## Flash Offset    = 0x%08X\n", offset);
+	printk("## Total Size      = 0x%08lX = %lu Bytes\n", size, size);
+	printk("## Flash content matches the CRC32C sent\n");
+	return 0;
+}
+
+/* fldumpb <floffset> <length> */
+int do_fldumpb(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
+{
+	uint32_t offset, length;
+	uint8_t digest[SHA256_HASH_SIZE];
+	int i;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+
+	offset = simple_strtoul(argv[1], NULL, 16);
+	length = simple_strtoul(argv[2], NULL, 16);
+	if (length == 0 || offset >= FLASH_CHIP_SIZE ||
+	    length > FLASH_CHIP_SIZE - offset)
+		return CMD_RET_USAGE;
+
+	printk("## Ready for binary (fldumpb) upload of flash 0x%08X...\n",
+	       offset);
+
+	if (flash_serial_dump(offset, length, digest) != 0) {
+		printk("## Binary (fldumpb) upload aborted\n");
+		return 1;
+	}
+
+	printk("## Flash Offset    = 0x%08X\n", offset);
+	printk("## Total Size      = 0x%08X = %u Bytes\n", length, length);
+	printk("## SHA256          = ");
+	for (i = 0; i < SHA256_HASH_SIZE; i++)
+		printk("%02x", digest[i]);
+	printk("\n");
+	return 0;
+}
+
+/* flsha <floffset> <length> | flsha all|<partition> */
+int do_flsha(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
+{
+	uint32_t offset, length;
+	int ret;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	flash_init(1);
+	flash_enable_quad_mode();
+
+	if (argc == 2) {
+		ret = flash_sha256_map(argv[1]);
+		if (ret < 0) {
+			printk("## Unknown partition %s\n", argv[1]);
+			return 1;
+		}
+		return ret;
+	}
+
+	offset = simple_strtoul(argv[1], NULL, 16);
+	length = simple_strtoul(argv[2], NULL, 16);
+	if (length == 0 || offset >= FLASH_CHIP_SIZE ||
+	    length > FLASH_CHIP_SIZE - offset)
+		return CMD_RET_USAGE;
+
+	return flash_sha256_print("range", offset, length) != 0;
+}
+
+/* baud [rate] */
+int do_baud(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
+{
+	if (argc < 2) {
+		printk("## Baud rate %u\n", uart_get_baudrate());
+		return 0;
+	}
+
+	return baud_switch(simple_strtoul(argv[1], NULL, 10)) ? 1 : 0;
+}
+
 /* md <ramaddr> <length> */
 int do_md(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
 {
@@ -423,6 +560,39 @@ int do_md(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
 	return 0;
 }
 
+#ifdef CONFIG_CMD_BENCH
+/* bench <ramaddr> [name] */
+int do_bench(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
+{
+	uint8_t *buf;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	buf = (uint8_t *)simple_strtoul(argv[1], NULL, 16);
+	printk("## Benchmark with 0x%X bytes scratch at 0x%08lX\n",
+	       BENCH_BUF_SIZE, (uintptr_t)buf);
+
+	return bench_run(buf, argc > 2 ? argv[2] : NULL);
+}
+#endif
+
+#ifdef CONFIG_TLOG
+/* tlog [clear] */
+int do_tlog(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
+{
+	if (argc > 1) {
+		if (strcmp(argv[1], "clear") != 0)
+			return CMD_RET_USAGE;
+		tlog_clear();
+		return 0;
+	}
+
+	tlog_dump();
+	return 0;
+}
+#endif
+
 int do_reset(struct cmd_tbl_s *cmdtp, int argc, char *const argv[])
 {
 	sysctl_reset(SYSCTL_RESET_SOC);
@@ -437,6 +607,12 @@ struct cmd_tbl_s cmd_tbl_fldump = { .name = "fldump",
 				    .maxargs = 3,
 				    .cmd = &do_fldump,
 				    .usage = "fldump <floffset> <length>" };
+struct cmd_tbl_s cmd_tbl_fldumpb = {
+	.name = "fldumpb",
+	.maxargs = 3,
+	.cmd = &do_fldumpb,
+	.usage = "fldumpb <floffset> <length> (utils/fldumpb.py)"
+};
 struct cmd_tbl_s cmd_tbl_flread = {
 	.name = "flread",
 	.maxargs = 4,
@@ -461,10 +637,44 @@ struct cmd_tbl_s cmd_tbl_loadb = { .name = "loadb",
 				   .maxargs = 2,
 				   .cmd = &do_loadb,
 				   .usage = "loadb <ramaddr> (kermit mode)" };
+struct cmd_tbl_s cmd_tbl_loadx = { .name = "loadx",
+				   .maxargs = 2,
+				   .cmd = &do_loadx,
+				   .usage = "loadx <ramaddr> (utils/loadx.py)" };
+struct cmd_tbl_s cmd_tbl_flashrx = {
+	.name = "flashrx",
+	.maxargs = 2,
+	.cmd = &do_flashrx,
+	.usage = "flashrx <floffset> (utils/loadx.py --flash)"
+};
+struct cmd_tbl_s cmd_tbl_flsha = {
+	.name = "flsha",
+	.maxargs = 3,
+	.cmd = &do_flsha,
+	.usage = "flsha <floffset> <length> | flsha all|<partition>"
+};
+struct cmd_tbl_s cmd_tbl_baud = { .name = "baud",
+				  .maxargs = 2,
+				  .cmd = &do_baud,
+				  .usage = "baud [rate] (decimal)" };
 struct cmd_tbl_s cmd_tbl_md = { .name = "md",
 				.maxargs = 3,
 				.cmd = &do_md,
 				.usage = "md <ramaddr> <length>" };
+#ifdef CONFIG_CMD_BENCH
+struct cmd_tbl_s cmd_tbl_bench = {
+	.name = "bench",
+	.maxargs = 3,
+	.cmd = &do_bench,
+	.usage = "bench <ramaddr> [sha256|sha256sw|aes16|aes|crc16|crc32c|memcpy|flread]"
+};
+#endif
+#ifdef CONFIG_TLOG
+struct cmd_tbl_s cmd_tbl_tlog = { .name = "tlog",
+				  .maxargs = 2,
+				  .cmd = &do_tlog,
+				  .usage = "tlog [clear] (utils/tlog.py)" };
+#endif
 struct cmd_tbl_s cmd_tbl_reset = { .name = "reset",
 				   .maxargs = 1,
 				   .cmd = &do_reset,
@@ -476,12 +686,23 @@ void cmd_init(void)
 	memset(&cmd_array, 0, sizeof(cmd_array));
 	cmd_array[i++] = &cmd_tbl_help;
 	cmd_array[i++] = &cmd_tbl_fldump;
+	cmd_array[i++] = &cmd_tbl_fldumpb;
 	cmd_array[i++] = &cmd_tbl_flread;
 	cmd_array[i++] = &cmd_tbl_flwrite;
 	cmd_array[i++] = &cmd_tbl_flerase;
 	cmd_array[i++] = &cmd_tbl_crc16;
 	cmd_array[i++] = &cmd_tbl_loadb;
+	cmd_array[i++] = &cmd_tbl_loadx;
+	cmd_array[i++] = &cmd_tbl_flashrx;
+	cmd_array[i++] = &cmd_tbl_flsha;
+	cmd_array[i++] = &cmd_tbl_baud;
 	cmd_array[i++] = &cmd_tbl_md;
+#ifdef CONFIG_CMD_BENCH
+	cmd_array[i++] = &cmd_tbl_bench;
+#endif
+#ifdef CONFIG_TLOG
+	cmd_array[i++] = &cmd_tbl_tlog;
+#endif
 	cmd_array[i++] = &cmd_tbl_reset;
 	cmd_items = i;
 }
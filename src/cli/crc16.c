@@ -47,50 +47,59 @@
  * CRC16 cyclic redundancy check values for an incomming byte string.
  */
 
-#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
-
-#define CRC_POLY_16 0xA001
-#define CRC_START_16 0x0000
-
-static bool crc_tab16_init = false;
-static uint16_t crc_tab16[256];
+#include "crc.h"
+#include "crc16_table.h"
 
 /*
- * static void init_crc16_tab( void );
+ * uint16_t crc16_update( uint16_t crc, const void *data, size_t num_bytes );
  *
- * For optimal performance uses the CRC16 routine a lookup table with values
- * that can be used directly in the XOR arithmetic in the algorithm. This
- * lookup table is calculated by the init_crc16_tab() routine, the first time
- * the CRC function is called.
+ * The function crc16_update() continues the CRC16 crc with the next
+ * num_bytes of a byte string, so it can be computed while data streams in.
+ * Start with CRC_START_16. With CONFIG_CRC_SLICE_BY_8, eight bytes are
+ * folded per iteration with the slicing-by-8 tables from
+ * utils/gen_crc_tables.py and only the unaligned head and the tail go one
+ * byte at a time.
  */
-static void init_crc16_tab(void)
+uint16_t crc16_update(uint16_t crc, const void *data, size_t num_bytes)
 {
-	uint16_t i;
-	uint16_t j;
-	uint16_t crc;
-	uint16_t c;
-
-	for (i = 0; i < 256; i++) {
-		crc = 0;
-		c = i;
-
-		for (j = 0; j < 8; j++) {
-			if ((crc ^ c) & 0x0001)
-				crc = (crc >> 1) ^ CRC_POLY_16;
-			else
-				crc = crc >> 1;
-
-			c = c >> 1;
-		}
+	const unsigned char *ptr = data;
+#ifdef CONFIG_CRC_SLICE_BY_8
+	uint64_t word;
+#endif
+
+	if (ptr == NULL)
+		return crc;
+
+#ifdef CONFIG_CRC_SLICE_BY_8
+	while (num_bytes && ((uintptr_t)ptr & 7)) {
+		crc = (crc >> 8) ^ crc16_table[0][(crc ^ *ptr++) & 0x00FF];
+		num_bytes--;
+	}
 
-		crc_tab16[i] = crc;
+	while (num_bytes >= 8) {
+		word = *(const uint64_t *)ptr ^ crc;
+		crc = crc16_table[7][word & 0xFF] ^
+		      crc16_table[6][(word >> 8) & 0xFF] ^
+		      crc16_table[5][(word >> 16) & 0xFF] ^
+		      crc16_table[4][(word >> 24) & 0xFF] ^
+		      crc16_table[3][(word >> 32) & 0xFF] ^
+		      crc16_table[2][(word >> 40) & 0xFF] ^
+		      crc16_table[1][(word >> 48) & 0xFF] ^
+		      crc16_table[0][word >> 56];
+		ptr += 8;
+		num_bytes -= 8;
 	}
+#endif
 
-	crc_tab16_init = true;
+	while (num_bytes--)
+		crc = (crc >> 8) ^ crc16_table[0][(crc ^ *ptr++) & 0x00FF];
 
-} /* init_crc16_tab */
+	return crc;
+
+} /* crc16_update */
 
 /*
  * uint16_t crc_16( const unsigned char *input_str, size_t num_bytes );
@@ -102,22 +111,6 @@ static void init_crc16_tab(void)
  */
 uint16_t crc_16(const unsigned char *input_str, size_t num_bytes)
 {
-	uint16_t crc;
-	const unsigned char *ptr;
-	size_t a;
-
-	if (!crc_tab16_init)
-		init_crc16_tab();
-
-	crc = CRC_START_16;
-	ptr = input_str;
-
-	if (ptr != NULL)
-		for (a = 0; a < num_bytes; a++) {
-			crc = (crc >> 8) ^
-			      crc_tab16[(crc ^ (uint16_t)*ptr++) & 0x00FF];
-		}
-
-	return crc;
+	return crc16_update(CRC_START_16, input_str, num_bytes);
 
 } /* crc_16 */
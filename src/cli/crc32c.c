@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "crc.h"
+#include "crc32c_table.h"
+
+/*
+ * CRC-32C (Castagnoli), the CRC of the newer transfer and image formats.
+ * Same table scheme as crc16_update(), with the usual pre and post
+ * inversion done here so results chain across calls.
+ */
+uint32_t crc32c_update(uint32_t crc, const void *data, size_t len)
+{
+	const uint8_t *ptr = data;
+#ifdef CONFIG_CRC_SLICE_BY_8
+	uint64_t word;
+#endif
+
+	crc = ~crc;
+
+#ifdef CONFIG_CRC_SLICE_BY_8
+	while (len && ((uintptr_t)ptr & 7)) {
+		crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *ptr++) & 0xFF];
+		len--;
+	}
+
+	while (len >= 8) {
+		word = *(const uint64_t *)ptr ^ crc;
+		crc = crc32c_table[7][word & 0xFF] ^
+		      crc32c_table[6][(word >> 8) & 0xFF] ^
+		      crc32c_table[5][(word >> 16) & 0xFF] ^
+		      crc32c_table[4][(word >> 24) & 0xFF] ^
+		      crc32c_table[3][(word >> 32) & 0xFF] ^
+		      crc32c_table[2][(word >> 40) & 0xFF] ^
+		      crc32c_table[1][(word >> 48) & 0xFF] ^
+		      crc32c_table[0][word >> 56];
+		ptr += 8;
+		len -= 8;
+	}
+#endif
+
+	while (len--)
+		crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *ptr++) & 0xFF];
+
+	return ~crc;
+}
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "crc.h"
+#include "flash.h"
+#include "loadx.h"
+#include "uarths.h"
+
+/* clang-format off */
+#define FLASHRX_SECTOR		(4 * 1024)
+#define FLASHRX_BLOCK		(64 * 1024)
+
+/* Two of these: one is filled from the UART while the other is programmed */
+#define FLASHRX_BUF_SIZE	(32 * 1024)
+/* Frames are whole pages, except the last one of the image */
+#define FLASHRX_UNIT		256
+#define FLASHRX_UNITS		(FLASHRX_BUF_SIZE / FLASHRX_UNIT)
+#define FLASHRX_FRAME		4096
+/* While both buffers are busy the frames in flight wait in the RX ring */
+#define FLASHRX_WINDOW		\
+	(UARTHS_RX_RING_SIZE / (FLASHRX_FRAME + LOADX_HDR_LEN + LOADX_CRC_LEN))
+/* clang-format on */
+
+enum flashrx_state {
+	FLASHRX_FREE,
+	FLASHRX_FILLING,
+	FLASHRX_PROGRAM,
+};
+
+struct flashrx_buf {
+	enum flashrx_state state;
+	uint32_t region; /* image offset / FLASHRX_BUF_SIZE */
+	uint32_t len; /* image bytes in this region */
+	uint32_t got; /* units received */
+	uint32_t pos; /* next byte to program */
+	uint32_t units[FLASHRX_UNITS / 32];
+	uint8_t data[FLASHRX_BUF_SIZE];
+};
+
+struct flashrx {
+	uint32_t base; /* flash offset of the image */
+	uint32_t total;
+	uint32_t done; /* regions in flash, programmed in order */
+	uint32_t erase_next; /* flash offsets below are erased */
+	uint32_t erase_end;
+	int busy; /* an erase or program runs in the flash */
+	struct flashrx_buf buf[2];
+};
+
+static struct flashrx flashrx;
+
+static int flashrx_blank(const uint8_t *p, uint32_t len)
+{
+	while (len--)
+		if (*p++ != 0xff)
+			return 0;
+	return 1;
+}
+
+static int flashrx_idle(struct flashrx *fx)
+{
+	if (fx->busy && flash_is_busy() == FLASH_BUSY)
+		return 0;
+	fx->busy = 0;
+	return 1;
+}
+
+static int flashrx_start(void *ctx, uint32_t total)
+{
+	struct flashrx *fx = ctx;
+
+	if (total == 0 || total > FLASH_CHIP_SIZE - fx->base)
+		return -1;
+
+	while (!flashrx_idle(fx))
+		continue;
+	fx->total = total;
+	fx->done = 0;
+	fx->erase_next = fx->base;
+	fx->erase_end = (fx->base + total + FLASHRX_SECTOR - 1) &
+			~(FLASHRX_SECTOR - 1);
+	fx->buf[0].state = FLASHRX_FREE;
+	fx->buf[1].state = FLASHRX_FREE;
+	return 0;
+}
+
+static int flashrx_write(void *ctx, uint32_t offset, const uint8_t *data,
+			 uint32_t len)
+{
+	struct flashrx *fx = ctx;
+	uint32_t region = offset / FLASHRX_BUF_SIZE;
+	uint32_t pos = offset % FLASHRX_BUF_SIZE;
+	struct flashrx_buf *b = &fx->buf[region % 2];
+	uint32_t u;
+
+	if (pos + len > FLASHRX_BUF_SIZE || pos % FLASHRX_UNIT ||
+	    (len % FLASHRX_UNIT && offset + len != fx->total))
+		return -1;
+	/* A resent frame whose first copy is already in flash */
+	if (region < fx->done)
+		return 0;
+
+	if (b->state == FLASHRX_FREE && region < fx->done + 2) {
+		b->state = FLASHRX_FILLING;
+		b->region = region;
+		b->len = fx->total - region * FLASHRX_BUF_SIZE;
+		if (b->len > FLASHRX_BUF_SIZE)
+			b->len = FLASHRX_BUF_SIZE;
+		b->got = 0;
+		b->pos = 0;
+		memset(b->units, 0, sizeof(b->units));
+	}
+	if (b->state != FLASHRX_FILLING || b->region != region)
+		return 1;
+
+	memcpy(b->data + pos, data, len);
+	for (u = pos / FLASHRX_UNIT; u * FLASHRX_UNIT < pos + len; u++) {
+		if (b->units[u / 32] & (1U << (u % 32)))
+			continue;
+		b->units[u / 32] |= 1U << (u % 32);
+		b->got++;
+	}
+	if (b->got * FLASHRX_UNIT >= b->len)
+		b->state = FLASHRX_PROGRAM;
+	return 0;
+}
+
+/*
+ * One flash command per call, so the UART is served in between. The oldest
+ * region is programmed as soon as it is complete and its sectors are
+ * erased, otherwise the erase planner works further into the image.
+ */
+static void flashrx_work(void *ctx)
+{
+	struct flashrx *fx = ctx;
+	struct flashrx_buf *b = &fx->buf[fx->done % 2];
+	uint32_t addr, n;
+
+	if (!flashrx_idle(fx))
+		return;
+
+	if (b->state == FLASHRX_PROGRAM) {
+		while (b->pos < b->len) {
+			addr = fx->base + b->region * FLASHRX_BUF_SIZE + b->pos;
+			n = b->len - b->pos;
+			if (n > FLASH_PROGRAM_CHUNK)
+				n = FLASH_PROGRAM_CHUNK;
+			if (addr + n > fx->erase_next)
+				break;
+			b->pos += n;
+			if (!flashrx_blank(b->data + b->pos - n, n)) {
+				flash_program_start(addr, b->data + b->pos - n,
+						    n);
+				fx->busy = 1;
+				return;
+			}
+		}
+		if (b->pos >= b->len) {
+			b->state = FLASHRX_FREE;
+			fx->done++;
+			return;
+		}
+	}
+
+	if (fx->erase_next < fx->erase_end) {
+		if (fx->erase_next % FLASHRX_BLOCK == 0 &&
+		    fx->erase_end - fx->erase_next >= FLASHRX_BLOCK) {
+			flash_64k_block_erase_start(fx->erase_next);
+			fx->erase_next += FLASHRX_BLOCK;
+		} else {
+			flash_sector_erase_start(fx->erase_next);
+			fx->erase_next += FLASHRX_SECTOR;
+		}
+		fx->busy = 1;
+	}
+}
+
+/* Program what is left, then hash the flash content itself */
+static uint32_t flashrx_finish(void *ctx, uint32_t total)
+{
+	struct flashrx *fx = ctx;
+	uint32_t regions = (total + FLASHRX_BUF_SIZE - 1) / FLASHRX_BUF_SIZE;
+	uint32_t crc = CRC_START_32C, pos, n;
+	uint8_t *scratch = fx->buf[0].data;
+
+	/* A region still filling cannot happen, every frame was ACKed */
+	while (fx->done < regions &&
+	       fx->buf[fx->done % 2].state == FLASHRX_PROGRAM)
+		flashrx_work(fx);
+	while (!flashrx_idle(fx))
+		continue;
+
+	for (pos = 0; pos < total; pos += n) {
+		n = total - pos;
+		if (n > FLASHRX_BUF_SIZE)
+			n = FLASHRX_BUF_SIZE;
+		flash_read_data(fx->base + pos, scratch, n, FLASH_QUAD_SINGLE);
+		crc = crc32c_update(crc, scratch, n);
+	}
+	return crc;
+}
+
+static const struct loadx_sink flashrx_sink = {
+	.frame_max = FLASHRX_FRAME,
+	.window = FLASHRX_WINDOW,
+	.start = flashrx_start,
+	.write = flashrx_write,
+	.work = flashrx_work,
+	.finish = flashrx_finish,
+};
+
+unsigned long flash_serial_x(uint32_t floffset)
+{
+	if (floffset % FLASHRX_SECTOR || floffset >= FLASH_CHIP_SIZE)
+		return LOADX_ERROR;
+
+	flash_init(1);
+	flash_enable_quad_mode();
+	flash_disable_protect();
+	/* Frames keep arriving while a command runs in the flash */
+	uart_rx_irq_enable();
+
+	memset(&flashrx, 0, offsetof(struct flashrx, buf));
+	flashrx.base = floffset;
+	return loadx_receive(&flashrx_sink, &flashrx);
+}
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * fldumpb: a flash range goes to the host in loadx frames (utils/fldumpb.py).
+ *
+ *   host START                 -> ACK, offset = length
+ *   DATA offset, up to 4 KB    <- streamed without waiting for ACKs
+ *   END  offset = length       <- payload = SHA256 of the range
+ *   host DATA offset           -> that part again, END again when = length
+ *   host END                   -> ACK, done
+ *   CANCEL offset              <- the flash could not be read there, over
+ *
+ * Frames are read into the TX ring while the previous ones are on the wire,
+ * so the line stays busy. A frame the host dropped leaves a gap it asks for
+ * by offset once the stream is over.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "flash.h"
+#include "loadx.h"
+#include "sha256.h"
+
+/* clang-format off */
+#define FLDUMPB_FRAME		4096
+/* Milliseconds, START after the command and any frame after the stream */
+#define FLDUMPB_START_TIMEOUT	30000
+#define FLDUMPB_IDLE_TIMEOUT	5000
+/* clang-format on */
+
+struct fldumpb {
+	uint32_t base;
+	uint32_t length;
+	int done; /* the whole range and END were sent */
+	uint8_t digest[SHA256_HASH_SIZE];
+};
+
+static uint8_t fldumpb_buf[FLDUMPB_FRAME];
+
+/* -1 after a CANCEL when the flash could not be read */
+static int fldumpb_send(struct fldumpb *fd, uint32_t offset)
+{
+	uint32_t n = fd->length - offset;
+
+	if (n > FLDUMPB_FRAME)
+		n = FLDUMPB_FRAME;
+	if (flash_read_bulk(fd->base + offset, fldumpb_buf, n) != FLASH_OK) {
+		loadx_frame_send(LOADX_CANCEL, 0, offset, NULL, 0);
+		return -1;
+	}
+	loadx_frame_send(LOADX_DATA, 0, offset, fldumpb_buf, n);
+	return 0;
+}
+
+/* 1 when the host confirmed, -1 on cancel, 0 to go on */
+static int fldumpb_request(struct fldumpb *fd, const struct loadx_frame *f)
+{
+	switch (f->type) {
+	case LOADX_START:
+		/* our ACK got lost */
+		loadx_frame_send(LOADX_ACK, 0, fd->length, NULL, 0);
+		break;
+	case LOADX_DATA:
+		if (f->offset < fd->length)
+			return fldumpb_send(fd, f->offset);
+		else if (f->offset == fd->length && fd->done)
+			loadx_frame_send(LOADX_END, 0, fd->length, fd->digest,
+					 SHA256_HASH_SIZE);
+		break;
+	case LOADX_END:
+		if (!fd->done)
+			break;
+		loadx_frame_send(LOADX_ACK, 0, fd->length, NULL, 0);
+		return 1;
+	case LOADX_CANCEL:
+		loadx_frame_send(LOADX_ACK, 0, f->offset, NULL, 0);
+		return -1;
+	default:
+		break;
+	}
+	return 0;
+}
+
+int flash_serial_dump(uint32_t floffset, uint32_t length, uint8_t *digest)
+{
+	uint64_t ms = loadx_ticks_per_ms();
+	uint64_t deadline = loadx_clock() + FLDUMPB_START_TIMEOUT * ms;
+	struct fldumpb fd = { .base = floffset, .length = length };
+	struct loadx_rx rx = { 0 };
+	struct loadx_frame f;
+	SHA256Context ctx;
+	uint32_t pos;
+	int ret;
+
+	flash_init(1);
+	flash_enable_quad_mode();
+
+	/* START tells the host listens, at whatever rate it negotiated */
+	for (;;) {
+		ret = loadx_poll(&rx, &f, 1);
+		if (ret == LOADX_ABORTED || loadx_clock() >= deadline)
+			return -1;
+		if (ret == 1 && f.type == LOADX_CANCEL)
+			return -1;
+		if (ret == 1 && f.type == LOADX_START)
+			break;
+	}
+	loadx_frame_send(LOADX_ACK, 0, length, NULL, 0);
+
+	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, length, &ctx);
+	for (pos = 0; pos < length; pos += FLDUMPB_FRAME) {
+		if (fldumpb_send(&fd, pos) != 0)
+			return -1;
+		sha256_update(&ctx, fldumpb_buf,
+			      length - pos > FLDUMPB_FRAME ? FLDUMPB_FRAME :
+							     length - pos);
+		/* a repeated START, a cancel or an early resend request */
+		if (loadx_poll(&rx, &f, 0) == 1 &&
+		    fldumpb_request(&fd, &f) < 0)
+			return -1;
+	}
+	sha256_final(&ctx, fd.digest);
+	fd.done = 1;
+	loadx_frame_send(LOADX_END, 0, length, fd.digest, SHA256_HASH_SIZE);
+
+	deadline = loadx_clock() + FLDUMPB_IDLE_TIMEOUT * ms;
+	for (;;) {
+		ret = loadx_poll(&rx, &f, 0);
+		if (ret != 1) {
+			if (loadx_clock() >= deadline)
+				return -1;
+			continue;
+		}
+		deadline = loadx_clock() + FLDUMPB_IDLE_TIMEOUT * ms;
+		ret = fldumpb_request(&fd, &f);
+		if (ret < 0)
+			return -1;
+		if (ret > 0)
+			break;
+	}
+	loadx_linger(&rx, length);
+
+	memcpy(digest, fd.digest, SHA256_HASH_SIZE);
+	return 0;
+}
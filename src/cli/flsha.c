@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "cli.h"
+#include "encoding.h"
+#include "flash.h"
+#include "flash_map.h"
+#include "sha256.h"
+#include "sysctl.h"
+
+/* Flash is read this much at a time between SHA256 engine updates */
+#define FLSHA_CHUNK (4 * 1024)
+
+static uint8_t flsha_buf[FLSHA_CHUNK];
+
+int flash_sha256(uint32_t floffset, uint32_t length, uint8_t *digest)
+{
+	SHA256Context ctx;
+	uint32_t n;
+
+	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, length, &ctx);
+	while (length) {
+		n = length > FLSHA_CHUNK ? FLSHA_CHUNK : length;
+		if (flash_read_bulk(floffset, flsha_buf, n) != FLASH_OK)
+			return -1;
+		sha256_update(&ctx, flsha_buf, n);
+		floffset += n;
+		length -= n;
+	}
+	sha256_final(&ctx, digest);
+
+	return 0;
+}
+
+int flash_sha256_print(const char *name, uint32_t floffset, uint32_t length)
+{
+	uint8_t digest[SHA256_HASH_SIZE];
+	uint64_t cycles = read_cycle();
+	int i;
+
+	if (flash_sha256(floffset, length, digest) != 0) {
+		printk("## Flash read failed in %s\n", name);
+		return -1;
+	}
+	cycles = read_cycle() - cycles;
+
+	printk("flsha,%s,0x%08X,0x%08X,", name, floffset, length);
+	for (i = 0; i < SHA256_HASH_SIZE; i++)
+		printk("%02x", digest[i]);
+	printk(",%u ms\n",
+	       (uint32_t)(cycles /
+			  (sysctl_clock_get_freq(SYSCTL_CLOCK_CPU) / 1000)));
+
+	return 0;
+}
+
+int flash_sha256_map(const char *name)
+{
+	const struct flash_part *p;
+	int found = 0, failed = 0;
+
+	/* "flsha all" goes through the map in flash order */
+	for (p = flash_map; p < flash_map + flash_map_parts; p++) {
+		if (strcmp(name, "all") != 0 && strcmp(name, p->name) != 0)
+			continue;
+		if (flash_sha256_print(p->name, p->offset, p->length) != 0)
+			failed = 1;
+		found = 1;
+	}
+
+	return found ? failed : -1;
+}
@@ -0,0 +1,300 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "crc.h"
+#include "encoding.h"
+#include "loadx.h"
+#include "sysctl.h"
+#include "uarths.h"
+
+#ifdef CONFIG_HOST_SIM
+#include <time.h>
+#endif
+
+/* Timeouts in milliseconds */
+#define LOADX_START_TIMEOUT 30000 /* first frame after the command */
+#define LOADX_IDLE_TIMEOUT 5000 /* host went away mid transfer */
+#define LOADX_BYTE_TIMEOUT 50 /* gap inside a frame, resync */
+#define LOADX_LINGER 200 /* answer a repeated END after the last ACK */
+
+#define LOADX_CTRLC 0x03
+
+/* Frames land here first so a bad one never touches the image */
+static uint8_t loadx_buf[LOADX_HDR_LEN + LOADX_FRAME_MAX + LOADX_CRC_LEN];
+
+#ifdef CONFIG_HOST_SIM
+uint64_t loadx_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t loadx_ticks_per_ms(void)
+{
+	return 1000000ULL;
+}
+#else
+uint64_t loadx_clock(void)
+{
+	return read_cycle();
+}
+
+uint64_t loadx_ticks_per_ms(void)
+{
+	return sysctl_clock_get_freq(SYSCTL_CLOCK_CPU) / 1000;
+}
+#endif
+
+static inline uint32_t loadx_get_le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void loadx_put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+void loadx_frame_send(uint8_t type, uint8_t flags, uint32_t offset,
+		      const uint8_t *payload, uint16_t len)
+{
+	uint8_t hdr[LOADX_HDR_LEN];
+	uint8_t tail[LOADX_CRC_LEN];
+	uint32_t crc;
+	int i;
+
+	hdr[0] = LOADX_SYNC0;
+	hdr[1] = LOADX_SYNC1;
+	hdr[2] = type;
+	hdr[3] = flags;
+	loadx_put_le32(hdr + 4, offset);
+	hdr[8] = len;
+	hdr[9] = len >> 8;
+	crc = crc32c_update(CRC_START_32C, hdr + 2, LOADX_HDR_LEN - 2);
+	crc = crc32c_update(crc, payload, len);
+	loadx_put_le32(tail, crc);
+
+	for (i = 0; i < LOADX_HDR_LEN; i++)
+		uart_putchar(hdr[i]);
+	for (i = 0; i < len; i++)
+		uart_putchar(payload[i]);
+	for (i = 0; i < LOADX_CRC_LEN; i++)
+		uart_putchar(tail[i]);
+}
+
+static void loadx_send(uint8_t type, uint32_t offset, const uint8_t *payload,
+		       uint16_t len)
+{
+	loadx_frame_send(type, 0, offset, payload, len);
+}
+
+int loadx_poll(struct loadx_rx *rx, struct loadx_frame *f, int ctrlc)
+{
+	uint8_t *p = loadx_buf;
+	uint32_t end, crc;
+	int c;
+
+	while (uart_tstc()) {
+		c = uart_getc();
+		rx->last = loadx_clock();
+
+		if (rx->have < 2) {
+			if (ctrlc && rx->have == 0 && c == LOADX_CTRLC)
+				return LOADX_ABORTED;
+			if (rx->have == 1 && c == LOADX_SYNC1)
+				rx->have = 2;
+			else
+				rx->have = c == LOADX_SYNC0;
+			continue;
+		}
+
+		p[rx->have++] = c;
+		if (rx->have < LOADX_HDR_LEN)
+			continue;
+
+		f->len = p[8] | (p[9] << 8);
+		if (f->len > LOADX_FRAME_MAX) {
+			rx->have = 0;
+			return LOADX_DROPPED;
+		}
+		end = LOADX_HDR_LEN + f->len + LOADX_CRC_LEN;
+		if (rx->have < end)
+			continue;
+
+		rx->have = 0;
+		crc = crc32c_update(CRC_START_32C, p + 2, end - LOADX_CRC_LEN - 2);
+		if (crc != loadx_get_le32(p + end - LOADX_CRC_LEN))
+			return LOADX_DROPPED;
+		f->type = p[2];
+		f->flags = p[3];
+		f->offset = loadx_get_le32(p + 4);
+		f->payload = p + LOADX_HDR_LEN;
+		return 1;
+	}
+
+	/* A stall inside a frame means bytes were lost, look for the next */
+	if (rx->have &&
+	    loadx_clock() - rx->last > LOADX_BYTE_TIMEOUT * loadx_ticks_per_ms()) {
+		rx->have = 0;
+		return LOADX_DROPPED;
+	}
+	return 0;
+}
+
+void loadx_linger(struct loadx_rx *rx, uint32_t total)
+{
+	uint64_t deadline = loadx_clock() + LOADX_LINGER * loadx_ticks_per_ms();
+	struct loadx_frame f;
+
+	while (loadx_clock() < deadline) {
+		if (loadx_poll(rx, &f, 0) == 1 && f.type == LOADX_END)
+			loadx_send(LOADX_ACK, total, NULL, 0);
+	}
+}
+
+unsigned long loadx_receive(const struct loadx_sink *sink, void *ctx)
+{
+	uint64_t ms = loadx_ticks_per_ms();
+	uint64_t deadline = loadx_clock() + LOADX_START_TIMEOUT * ms;
+	struct loadx_rx rx = { 0 };
+	struct loadx_frame f;
+	uint32_t total = 0;
+	int started = 0, pending = 0;
+	uint8_t caps[4];
+	int ret;
+
+	caps[0] = sink->frame_max & 0xff;
+	caps[1] = sink->frame_max >> 8;
+	caps[2] = sink->window & 0xff;
+	caps[3] = sink->window >> 8;
+
+	for (;;) {
+		if (sink->work)
+			sink->work(ctx);
+
+		/* A frame the sink could not take yet stays in loadx_buf */
+		if (!pending) {
+			ret = loadx_poll(&rx, &f, !started);
+			if (ret == LOADX_ABORTED)
+				return LOADX_ERROR;
+			if (ret != 1) {
+				if (loadx_clock() >= deadline)
+					return LOADX_ERROR;
+				continue;
+			}
+		}
+		pending = 0;
+		deadline = loadx_clock() + LOADX_IDLE_TIMEOUT * ms;
+
+		switch (f.type) {
+		case LOADX_START:
+			/* A repeat when our first ACK got lost, or a restart */
+			if (!started || f.offset != total) {
+				if (sink->start(ctx, f.offset) != 0) {
+					loadx_send(LOADX_NAK, f.offset, NULL, 0);
+					break;
+				}
+				total = f.offset;
+				started = 1;
+			}
+			loadx_send(LOADX_ACK, total, caps, sizeof(caps));
+			break;
+		case LOADX_DATA:
+			ret = -1;
+			if (started && f.offset <= total &&
+			    f.len <= total - f.offset)
+				ret = sink->write(ctx, f.offset, f.payload,
+						  f.len);
+			if (ret > 0) {
+				pending = 1;
+				break;
+			}
+			loadx_send(ret == 0 ? LOADX_ACK : LOADX_NAK, f.offset,
+				   NULL, 0);
+			break;
+		case LOADX_END:
+			if (!started || f.offset != total || f.len != 4) {
+				loadx_send(LOADX_NAK, f.offset, NULL, 0);
+				break;
+			}
+			if (sink->finish(ctx, total) !=
+			    loadx_get_le32(f.payload)) {
+				loadx_send(LOADX_NAK, total, NULL, 0);
+				return LOADX_ERROR;
+			}
+			loadx_send(LOADX_ACK, total, NULL, 0);
+			loadx_linger(&rx, total);
+			return total;
+		case LOADX_CANCEL:
+			loadx_send(LOADX_ACK, f.offset, NULL, 0);
+			return LOADX_ERROR;
+		default:
+			break;
+		}
+	}
+}
+
+struct loadx_ram {
+	uint8_t *base;
+	unsigned long maxlen;
+};
+
+static int loadx_ram_start(void *ctx, uint32_t total)
+{
+	struct loadx_ram *ram = ctx;
+
+	return total > ram->maxlen ? -1 : 0;
+}
+
+static int loadx_ram_write(void *ctx, uint32_t offset, const uint8_t *data,
+			   uint32_t len)
+{
+	struct loadx_ram *ram = ctx;
+
+	/* Resent frames are simply written again */
+	memcpy(ram->base + offset, data, len);
+	return 0;
+}
+
+static uint32_t loadx_ram_finish(void *ctx, uint32_t total)
+{
+	struct loadx_ram *ram = ctx;
+
+	return crc32c_update(CRC_START_32C, ram->base, total);
+}
+
+static const struct loadx_sink loadx_ram_sink = {
+	.frame_max = LOADX_FRAME_MAX,
+	.window = LOADX_WINDOW,
+	.start = loadx_ram_start,
+	.write = loadx_ram_write,
+	.finish = loadx_ram_finish,
+};
+
+unsigned long load_serial_x(unsigned long addr, unsigned long maxlen)
+{
+	struct loadx_ram ram = { (uint8_t *)addr, maxlen };
+
+	return loadx_receive(&loadx_ram_sink, &ram);
+}
@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "cli.h"
+#include "common.h"
+#include "flash.h"
+#include "loadx.h"
+#include "platform.h"
+#include "rpc.h"
+#include "sha256.h"
+#include "sysctl.h"
+#include "uarths.h"
+
+/* clang-format off */
+#define RPC_BLOCK		(64 * 1024)
+/* Let the RESET answer leave before the SoC goes down */
+#define RPC_RESET_FLUSH		100
+/* Stage 2 load window at _boot, the rest of the RAM is the running loader */
+#define RPC_MEM_SIZE		(64 * 1024)
+/* clang-format on */
+
+static uint8_t rpc_buf[RPC_DATA_MAX];
+
+static inline void rpc_put_le16(uint8_t *p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static inline void rpc_put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static void rpc_ack(const struct loadx_frame *f, const uint8_t *data,
+		    uint16_t len)
+{
+	loadx_frame_send(LOADX_ACK, f->type, f->offset, data, len);
+}
+
+static void rpc_nak(const struct loadx_frame *f, uint32_t err)
+{
+	uint8_t code[4];
+
+	rpc_put_le32(code, err);
+	loadx_frame_send(LOADX_NAK, f->type, f->offset, code, sizeof(code));
+}
+
+/* Requests carrying a length, 0 when the payload is not one */
+static uint32_t rpc_length(const struct loadx_frame *f)
+{
+	const uint8_t *p = f->payload;
+
+	if (f->len != 4)
+		return 0;
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int rpc_flash_range(uint32_t offset, uint32_t len)
+{
+	return offset <= FLASH_CHIP_SIZE && len <= FLASH_CHIP_SIZE - offset;
+}
+
+static int rpc_mem_range(uint32_t addr, uint32_t len)
+{
+	uintptr_t base = (uintptr_t)_boot;
+
+	return addr >= base && addr - base <= RPC_MEM_SIZE &&
+	       len <= base + RPC_MEM_SIZE - addr;
+}
+
+static void rpc_info(const struct loadx_frame *f)
+{
+	uint8_t info[8];
+
+	rpc_put_le16(info, RPC_VERSION);
+	rpc_put_le16(info + 2, RPC_DATA_MAX);
+	rpc_put_le32(info + 4, uart_get_baudrate());
+	rpc_ack(f, info, sizeof(info));
+}
+
+/* 64 KB blocks where aligned, 4 KB sectors around them */
+static void rpc_erase(uint32_t offset, uint32_t len)
+{
+	uint32_t end = offset + len;
+
+	while (offset < end) {
+		if (offset % RPC_BLOCK == 0 && end - offset >= RPC_BLOCK) {
+			flash_64k_block_erase(offset);
+			offset += RPC_BLOCK;
+		} else {
+			flash_sector_erase(offset);
+			offset += RPC_SECTOR;
+		}
+	}
+}
+
+/* Sector hashes go straight into the answer buffer, -1 on a read error */
+static int rpc_hashes(uint32_t offset, uint32_t len)
+{
+	uint8_t digest[SHA256_HASH_SIZE];
+	uint8_t *p = rpc_buf;
+
+	for (; len; offset += RPC_SECTOR, len -= RPC_SECTOR) {
+		if (flash_sha256(offset, RPC_SECTOR, digest) != 0)
+			return -1;
+		memcpy(p, digest, RPC_SECTOR_HASH_LEN);
+		p += RPC_SECTOR_HASH_LEN;
+	}
+	return 0;
+}
+
+/* 0 or the RPC_ERR_* code */
+static uint32_t rpc_update(uint32_t offset, const uint8_t *data)
+{
+	flash_sector_erase(offset);
+	flash_write_data(offset, (uint8_t *)data, RPC_SECTOR);
+	if (flash_read_bulk(offset, rpc_buf, RPC_SECTOR) != FLASH_OK)
+		return RPC_ERR_READ;
+	return memcmp(rpc_buf, data, RPC_SECTOR) == 0 ? 0 : RPC_ERR_VERIFY;
+}
+
+static void rpc_request(const struct loadx_frame *f)
+{
+	uint32_t len = rpc_length(f), err;
+	uint8_t digest[SHA256_HASH_SIZE];
+
+	switch (f->type) {
+	case RPC_INFO:
+		rpc_info(f);
+		break;
+	case RPC_FLASH_READ:
+		if (len == 0 || len > RPC_DATA_MAX)
+			rpc_nak(f, RPC_ERR_ARGS);
+		else if (!rpc_flash_range(f->offset, len))
+			rpc_nak(f, RPC_ERR_RANGE);
+		else if (flash_read_data(f->offset, rpc_buf, len,
+					 FLASH_QUAD_SINGLE) != FLASH_OK)
+			rpc_nak(f, RPC_ERR_READ);
+		else
+			rpc_ack(f, rpc_buf, len);
+		break;
+	case RPC_FLASH_WRITE:
+		if (f->len == 0)
+			rpc_nak(f, RPC_ERR_ARGS);
+		else if (!rpc_flash_range(f->offset, f->len))
+			rpc_nak(f, RPC_ERR_RANGE);
+		else {
+			/* the frame buffer is not touched until the next poll */
+			flash_write_data(f->offset, (uint8_t *)f->payload,
+					 f->len);
+			rpc_ack(f, NULL, 0);
+		}
+		break;
+	case RPC_FLASH_ERASE:
+		if (len == 0 || len % RPC_SECTOR || f->offset % RPC_SECTOR)
+			rpc_nak(f, RPC_ERR_ARGS);
+		else if (!rpc_flash_range(f->offset, len))
+			rpc_nak(f, RPC_ERR_RANGE);
+		else {
+			rpc_erase(f->offset, len);
+			rpc_ack(f, NULL, 0);
+		}
+		break;
+	case RPC_FLASH_SHA256:
+		if (f->len != 4)
+			rpc_nak(f, RPC_ERR_ARGS);
+		else if (!rpc_flash_range(f->offset, len))
+			rpc_nak(f, RPC_ERR_RANGE);
+		else if (flash_sha256(f->offset, len, digest) != 0)
+			rpc_nak(f, RPC_ERR_READ);
+		else
+			rpc_ack(f, digest, sizeof(digest));
+		break;
+	case RPC_FLASH_HASHES:
+		if (len == 0 || len % RPC_SECTOR || f->offset % RPC_SECTOR ||
+		    len / RPC_SECTOR * RPC_SECTOR_HASH_LEN > RPC_DATA_MAX)
+			rpc_nak(f, RPC_ERR_ARGS);
+		else if (!rpc_flash_range(f->offset, len))
+			rpc_nak(f, RPC_ERR_RANGE);
+		else if (rpc_hashes(f->offset, len) != 0)
+			rpc_nak(f, RPC_ERR_READ);
+		else
+			rpc_ack(f, rpc_buf,
+				len / RPC_SECTOR * RPC_SECTOR_HASH_LEN);
+		break;
+	case RPC_FLASH_UPDATE:
+		if (f->len != RPC_SECTOR || f->offset % RPC_SECTOR)
+			rpc_nak(f, RPC_ERR_ARGS);
+		else if (!rpc_flash_range(f->offset, RPC_SECTOR))
+			rpc_nak(f, RPC_ERR_RANGE);
+		else if ((err = rpc_update(f->offset, f->payload)) != 0)
+			rpc_nak(f, err);
+		else
+			rpc_ack(f, NULL, 0);
+		break;
+	case RPC_MEM_READ:
+		if (len == 0 || len > RPC_DATA_MAX)
+			rpc_nak(f, RPC_ERR_ARGS);
+		else if (!rpc_mem_range(f->offset, len))
+			rpc_nak(f, RPC_ERR_RANGE);
+		else
+			rpc_ack(f, (const uint8_t *)(uintptr_t)f->offset, len);
+		break;
+	case RPC_MEM_WRITE:
+		if (f->len == 0)
+			rpc_nak(f, RPC_ERR_ARGS);
+		else if (!rpc_mem_range(f->offset, f->len))
+			rpc_nak(f, RPC_ERR_RANGE);
+		else {
+			memcpy((void *)(uintptr_t)f->offset, f->payload,
+			       f->len);
+			rpc_ack(f, NULL, 0);
+		}
+		break;
+	case RPC_RESET:
+		rpc_ack(f, NULL, 0);
+		console_flush(RPC_RESET_FLUSH);
+		sysctl_reset(SYSCTL_RESET_SOC);
+		break;
+	default:
+		rpc_nak(f, RPC_ERR_UNKNOWN);
+		break;
+	}
+}
+
+int rpc_serve(void)
+{
+	struct loadx_rx rx = { 0 };
+	struct loadx_frame f = { .type = RPC_INFO };
+	int ret;
+
+	flash_init(1);
+	flash_enable_quad_mode();
+	flash_disable_protect();
+
+	/* Tells the host the switch happened */
+	rpc_info(&f);
+	rx.last = loadx_clock();
+
+	for (;;) {
+		ret = loadx_poll(&rx, &f, 1);
+		if (ret == LOADX_ABORTED)
+			return 0;
+		if (ret == 0 && loadx_clock() - rx.last >
+		    CONFIG_CLI_IDLE_TIMEOUT * loadx_ticks_per_ms())
+			return -1;
+		if (ret != 1)
+			continue;
+		if (f.type == RPC_QUIT) {
+			rpc_ack(&f, NULL, 0);
+			return 0;
+		}
+		rpc_request(&f);
+	}
+}
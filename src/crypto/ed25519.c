@@ -0,0 +1,688 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Ed25519 signature check for secure boot.
+ *
+ * Field elements use five 51-bit limbs, so every product is a single
+ * mul/mulhu pair on RV64 and carries stay in 64-bit registers. The group
+ * law and the double scalar multiplication follow the ref10 layout; the
+ * odd multiples of the base point come from ed25519_tables.h which is
+ * generated by utils/gen_ed25519_tables.py.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "ed25519.h"
+#include "sha512.h"
+
+typedef uint64_t fe[5];
+typedef unsigned __int128 uint128_t;
+
+struct ge_p2 {
+	fe X, Y, Z;
+};
+
+struct ge_p3 {
+	fe X, Y, Z, T;
+};
+
+struct ge_p1p1 {
+	fe X, Y, Z, T;
+};
+
+struct ge_precomp {
+	fe yplusx, yminusx, xy2d;
+};
+
+struct ge_cached {
+	fe YplusX, YminusX, Z, T2d;
+};
+
+#include "ed25519_tables.h"
+
+/* clang-format off */
+#define MASK51			0x7ffffffffffffULL
+/* odd multiples of A up to 15A */
+#define ED25519_POINT_WINDOW	5
+/* clang-format on */
+
+/* ---------------------------------------------------------------------- */
+/* GF(2^255 - 19) */
+
+static void fe_0(fe h)
+{
+	h[0] = h[1] = h[2] = h[3] = h[4] = 0;
+}
+
+static void fe_1(fe h)
+{
+	h[0] = 1;
+	h[1] = h[2] = h[3] = h[4] = 0;
+}
+
+static void fe_copy(fe h, const fe f)
+{
+	memcpy(h, f, sizeof(fe));
+}
+
+static void fe_carry(fe h)
+{
+	uint64_t c;
+
+	c = h[0] >> 51;
+	h[0] &= MASK51;
+	h[1] += c;
+	c = h[1] >> 51;
+	h[1] &= MASK51;
+	h[2] += c;
+	c = h[2] >> 51;
+	h[2] &= MASK51;
+	h[3] += c;
+	c = h[3] >> 51;
+	h[3] &= MASK51;
+	h[4] += c;
+	c = h[4] >> 51;
+	h[4] &= MASK51;
+	h[0] += c * 19;
+}
+
+static void fe_add(fe h, const fe f, const fe g)
+{
+	h[0] = f[0] + g[0];
+	h[1] = f[1] + g[1];
+	h[2] = f[2] + g[2];
+	h[3] = f[3] + g[3];
+	h[4] = f[4] + g[4];
+	fe_carry(h);
+}
+
+/* h = f - g, 4p is added first so limbs below 2^53 never underflow */
+static void fe_sub(fe h, const fe f, const fe g)
+{
+	h[0] = f[0] + 0x1fffffffffffb4ULL - g[0];
+	h[1] = f[1] + 0x1ffffffffffffcULL - g[1];
+	h[2] = f[2] + 0x1ffffffffffffcULL - g[2];
+	h[3] = f[3] + 0x1ffffffffffffcULL - g[3];
+	h[4] = f[4] + 0x1ffffffffffffcULL - g[4];
+	fe_carry(h);
+}
+
+static void fe_neg(fe h, const fe f)
+{
+	fe zero;
+
+	fe_0(zero);
+	fe_sub(h, zero, f);
+}
+
+static void fe_mul(fe h, const fe f, const fe g)
+{
+	uint128_t r0, r1, r2, r3, r4;
+	uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+	uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+	uint64_t g1_19 = g1 * 19, g2_19 = g2 * 19, g3_19 = g3 * 19,
+		 g4_19 = g4 * 19;
+	uint64_t c;
+
+	r0 = (uint128_t)f0 * g0 + (uint128_t)f1 * g4_19 +
+	     (uint128_t)f2 * g3_19 + (uint128_t)f3 * g2_19 +
+	     (uint128_t)f4 * g1_19;
+	r1 = (uint128_t)f0 * g1 + (uint128_t)f1 * g0 + (uint128_t)f2 * g4_19 +
+	     (uint128_t)f3 * g3_19 + (uint128_t)f4 * g2_19;
+	r2 = (uint128_t)f0 * g2 + (uint128_t)f1 * g1 + (uint128_t)f2 * g0 +
+	     (uint128_t)f3 * g4_19 + (uint128_t)f4 * g3_19;
+	r3 = (uint128_t)f0 * g3 + (uint128_t)f1 * g2 + (uint128_t)f2 * g1 +
+	     (uint128_t)f3 * g0 + (uint128_t)f4 * g4_19;
+	r4 = (uint128_t)f0 * g4 + (uint128_t)f1 * g3 + (uint128_t)f2 * g2 +
+	     (uint128_t)f3 * g1 + (uint128_t)f4 * g0;
+
+	c = (uint64_t)(r0 >> 51);
+	h[0] = (uint64_t)r0 & MASK51;
+	r1 += c;
+	c = (uint64_t)(r1 >> 51);
+	h[1] = (uint64_t)r1 & MASK51;
+	r2 += c;
+	c = (uint64_t)(r2 >> 51);
+	h[2] = (uint64_t)r2 & MASK51;
+	r3 += c;
+	c = (uint64_t)(r3 >> 51);
+	h[3] = (uint64_t)r3 & MASK51;
+	r4 += c;
+	c = (uint64_t)(r4 >> 51);
+	h[4] = (uint64_t)r4 & MASK51;
+	h[0] += c * 19;
+	c = h[0] >> 51;
+	h[0] &= MASK51;
+	h[1] += c;
+}
+
+static void fe_sq(fe h, const fe f)
+{
+	uint128_t r0, r1, r2, r3, r4;
+	uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+	uint64_t f0_2 = f0 * 2, f1_2 = f1 * 2;
+	uint64_t f1_38 = f1 * 38, f2_38 = f2 * 38, f3_38 = f3 * 38;
+	uint64_t f3_19 = f3 * 19, f4_19 = f4 * 19;
+	uint64_t c;
+
+	r0 = (uint128_t)f0 * f0 + (uint128_t)f1_38 * f4 +
+	     (uint128_t)f2_38 * f3;
+	r1 = (uint128_t)f0_2 * f1 + (uint128_t)f2_38 * f4 +
+	     (uint128_t)f3_19 * f3;
+	r2 = (uint128_t)f0_2 * f2 + (uint128_t)f1 * f1 +
+	     (uint128_t)f3_38 * f4;
+	r3 = (uint128_t)f0_2 * f3 + (uint128_t)f1_2 * f2 +
+	     (uint128_t)f4_19 * f4;
+	r4 = (uint128_t)f0_2 * f4 + (uint128_t)f1_2 * f3 + (uint128_t)f2 * f2;
+
+	c = (uint64_t)(r0 >> 51);
+	h[0] = (uint64_t)r0 & MASK51;
+	r1 += c;
+	c = (uint64_t)(r1 >> 51);
+	h[1] = (uint64_t)r1 & MASK51;
+	r2 += c;
+	c = (uint64_t)(r2 >> 51);
+	h[2] = (uint64_t)r2 & MASK51;
+	r3 += c;
+	c = (uint64_t)(r3 >> 51);
+	h[3] = (uint64_t)r3 & MASK51;
+	r4 += c;
+	c = (uint64_t)(r4 >> 51);
+	h[4] = (uint64_t)r4 & MASK51;
+	h[0] += c * 19;
+	c = h[0] >> 51;
+	h[0] &= MASK51;
+	h[1] += c;
+}
+
+static void fe_sqn(fe h, const fe f, int n)
+{
+	fe_sq(h, f);
+	while (--n > 0)
+		fe_sq(h, h);
+}
+
+static void fe_frombytes(fe h, const uint8_t s[32])
+{
+	uint64_t w[4];
+	int i, j;
+
+	for (i = 0; i < 4; i++) {
+		w[i] = 0;
+		for (j = 7; j >= 0; j--)
+			w[i] = (w[i] << 8) | s[8 * i + j];
+	}
+	h[0] = w[0] & MASK51;
+	h[1] = ((w[0] >> 51) | (w[1] << 13)) & MASK51;
+	h[2] = ((w[1] >> 38) | (w[2] << 26)) & MASK51;
+	h[3] = ((w[2] >> 25) | (w[3] << 39)) & MASK51;
+	h[4] = (w[3] >> 12) & MASK51;
+}
+
+static void fe_tobytes(uint8_t s[32], const fe f)
+{
+	uint64_t h[5], w[4], q;
+	int i, j;
+
+	memcpy(h, f, sizeof(h));
+	fe_carry(h);
+	fe_carry(h);
+
+	/* q = 1 if h >= p */
+	q = (h[0] + 19) >> 51;
+	q = (h[1] + q) >> 51;
+	q = (h[2] + q) >> 51;
+	q = (h[3] + q) >> 51;
+	q = (h[4] + q) >> 51;
+
+	h[0] += 19 * q;
+	h[1] += h[0] >> 51;
+	h[0] &= MASK51;
+	h[2] += h[1] >> 51;
+	h[1] &= MASK51;
+	h[3] += h[2] >> 51;
+	h[2] &= MASK51;
+	h[4] += h[3] >> 51;
+	h[3] &= MASK51;
+	h[4] &= MASK51;
+
+	w[0] = h[0] | (h[1] << 51);
+	w[1] = (h[1] >> 13) | (h[2] << 38);
+	w[2] = (h[2] >> 26) | (h[3] << 25);
+	w[3] = (h[3] >> 39) | (h[4] << 12);
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < 8; j++)
+			s[8 * i + j] = (uint8_t)(w[i] >> (8 * j));
+}
+
+static int fe_isnegative(const fe f)
+{
+	uint8_t s[32];
+
+	fe_tobytes(s, f);
+	return s[0] & 1;
+}
+
+static int fe_isnonzero(const fe f)
+{
+	uint8_t s[32];
+	uint8_t r = 0;
+	int i;
+
+	fe_tobytes(s, f);
+	for (i = 0; i < 32; i++)
+		r |= s[i];
+	return r != 0;
+}
+
+/* z^(2^250 - 1) and z^11, shared by fe_invert() and fe_pow22523() */
+static void fe_pow2_250_1(fe out, fe z11, const fe z)
+{
+	fe t0, t1, z9, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0;
+
+	fe_sq(t0, z); /* 2 */
+	fe_sqn(t1, t0, 2); /* 8 */
+	fe_mul(z9, t1, z); /* 9 */
+	fe_mul(z11, z9, t0); /* 11 */
+	fe_sq(t1, z11); /* 22 */
+	fe_mul(z2_5_0, t1, z9); /* 2^5 - 1 */
+	fe_sqn(t1, z2_5_0, 5);
+	fe_mul(z2_10_0, t1, z2_5_0);
+	fe_sqn(t1, z2_10_0, 10);
+	fe_mul(z2_20_0, t1, z2_10_0);
+	fe_sqn(t1, z2_20_0, 20);
+	fe_mul(t1, t1, z2_20_0);
+	fe_sqn(t1, t1, 10);
+	fe_mul(z2_50_0, t1, z2_10_0);
+	fe_sqn(t1, z2_50_0, 50);
+	fe_mul(z2_100_0, t1, z2_50_0);
+	fe_sqn(t1, z2_100_0, 100);
+	fe_mul(t1, t1, z2_100_0);
+	fe_sqn(t1, t1, 50);
+	fe_mul(out, t1, z2_50_0);
+}
+
+/* z^(p - 2) = z^(2^255 - 21) */
+static void fe_invert(fe out, const fe z)
+{
+	fe t, z11;
+
+	fe_pow2_250_1(t, z11, z);
+	fe_sqn(t, t, 5);
+	fe_mul(out, t, z11);
+}
+
+/* z^((p - 5) / 8) = z^(2^252 - 3) */
+static void fe_pow22523(fe out, const fe z)
+{
+	fe t, z11;
+
+	fe_pow2_250_1(t, z11, z);
+	fe_sqn(t, t, 2);
+	fe_mul(out, t, z);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Edwards group */
+
+static void ge_p2_0(struct ge_p2 *h)
+{
+	fe_0(h->X);
+	fe_1(h->Y);
+	fe_1(h->Z);
+}
+
+static void ge_p1p1_to_p2(struct ge_p2 *r, const struct ge_p1p1 *p)
+{
+	fe_mul(r->X, p->X, p->T);
+	fe_mul(r->Y, p->Y, p->Z);
+	fe_mul(r->Z, p->Z, p->T);
+}
+
+static void ge_p1p1_to_p3(struct ge_p3 *r, const struct ge_p1p1 *p)
+{
+	fe_mul(r->X, p->X, p->T);
+	fe_mul(r->Y, p->Y, p->Z);
+	fe_mul(r->Z, p->Z, p->T);
+	fe_mul(r->T, p->X, p->Y);
+}
+
+static void ge_p3_to_cached(struct ge_cached *r, const struct ge_p3 *p)
+{
+	fe_add(r->YplusX, p->Y, p->X);
+	fe_sub(r->YminusX, p->Y, p->X);
+	fe_copy(r->Z, p->Z);
+	fe_mul(r->T2d, p->T, ed25519_d2);
+}
+
+static void ge_p2_dbl(struct ge_p1p1 *r, const struct ge_p2 *p)
+{
+	fe t0;
+
+	fe_sq(r->X, p->X);
+	fe_sq(r->Z, p->Y);
+	fe_sq(r->T, p->Z);
+	fe_add(r->T, r->T, r->T);
+	fe_add(r->Y, p->X, p->Y);
+	fe_sq(t0, r->Y);
+	fe_add(r->Y, r->Z, r->X);
+	fe_sub(r->Z, r->Z, r->X);
+	fe_sub(r->X, t0, r->Y);
+	fe_sub(r->T, r->T, r->Z);
+}
+
+static void ge_p3_dbl(struct ge_p1p1 *r, const struct ge_p3 *p)
+{
+	struct ge_p2 q;
+
+	fe_copy(q.X, p->X);
+	fe_copy(q.Y, p->Y);
+	fe_copy(q.Z, p->Z);
+	ge_p2_dbl(r, &q);
+}
+
+static void ge_add(struct ge_p1p1 *r, const struct ge_p3 *p,
+		   const struct ge_cached *q)
+{
+	fe t0;
+
+	fe_add(r->X, p->Y, p->X);
+	fe_sub(r->Y, p->Y, p->X);
+	fe_mul(r->Z, r->X, q->YplusX);
+	fe_mul(r->Y, r->Y, q->YminusX);
+	fe_mul(r->T, q->T2d, p->T);
+	fe_mul(r->X, p->Z, q->Z);
+	fe_add(t0, r->X, r->X);
+	fe_sub(r->X, r->Z, r->Y);
+	fe_add(r->Y, r->Z, r->Y);
+	fe_add(r->Z, t0, r->T);
+	fe_sub(r->T, t0, r->T);
+}
+
+static void ge_sub(struct ge_p1p1 *r, const struct ge_p3 *p,
+		   const struct ge_cached *q)
+{
+	fe t0;
+
+	fe_add(r->X, p->Y, p->X);
+	fe_sub(r->Y, p->Y, p->X);
+	fe_mul(r->Z, r->X, q->YminusX);
+	fe_mul(r->Y, r->Y, q->YplusX);
+	fe_mul(r->T, q->T2d, p->T);
+	fe_mul(r->X, p->Z, q->Z);
+	fe_add(t0, r->X, r->X);
+	fe_sub(r->X, r->Z, r->Y);
+	fe_add(r->Y, r->Z, r->Y);
+	fe_sub(r->Z, t0, r->T);
+	fe_add(r->T, t0, r->T);
+}
+
+static void ge_madd(struct ge_p1p1 *r, const struct ge_p3 *p,
+		    const struct ge_precomp *q)
+{
+	fe t0;
+
+	fe_add(r->X, p->Y, p->X);
+	fe_sub(r->Y, p->Y, p->X);
+	fe_mul(r->Z, r->X, q->yplusx);
+	fe_mul(r->Y, r->Y, q->yminusx);
+	fe_mul(r->T, q->xy2d, p->T);
+	fe_add(t0, p->Z, p->Z);
+	fe_sub(r->X, r->Z, r->Y);
+	fe_add(r->Y, r->Z, r->Y);
+	fe_add(r->Z, t0, r->T);
+	fe_sub(r->T, t0, r->T);
+}
+
+static void ge_msub(struct ge_p1p1 *r, const struct ge_p3 *p,
+		    const struct ge_precomp *q)
+{
+	fe t0;
+
+	fe_add(r->X, p->Y, p->X);
+	fe_sub(r->Y, p->Y, p->X);
+	fe_mul(r->Z, r->X, q->yminusx);
+	fe_mul(r->Y, r->Y, q->yplusx);
+	fe_mul(r->T, q->xy2d, p->T);
+	fe_add(t0, p->Z, p->Z);
+	fe_sub(r->X, r->Z, r->Y);
+	fe_add(r->Y, r->Z, r->Y);
+	fe_sub(r->Z, t0, r->T);
+	fe_add(r->T, t0, r->T);
+}
+
+static void ge_tobytes(uint8_t s[32], const struct ge_p2 *h)
+{
+	fe recip, x, y;
+
+	fe_invert(recip, h->Z);
+	fe_mul(x, h->X, recip);
+	fe_mul(y, h->Y, recip);
+	fe_tobytes(s, y);
+	s[31] ^= fe_isnegative(x) << 7;
+}
+
+/* Decode a point and return its negation, -A is what the check needs */
+static int ge_frombytes_negate_vartime(struct ge_p3 *h, const uint8_t s[32])
+{
+	fe u, v, v3, vxx, check;
+
+	fe_frombytes(h->Y, s);
+	fe_1(h->Z);
+	fe_sq(u, h->Y);
+	fe_mul(v, u, ed25519_d);
+	fe_sub(u, u, h->Z); /* u = y^2 - 1 */
+	fe_add(v, v, h->Z); /* v = dy^2 + 1 */
+
+	fe_sq(v3, v);
+	fe_mul(v3, v3, v); /* v3 = v^3 */
+	fe_sq(h->X, v3);
+	fe_mul(h->X, h->X, v);
+	fe_mul(h->X, h->X, u); /* x = uv^7 */
+
+	fe_pow22523(h->X, h->X); /* x = (uv^7)^((q - 5) / 8) */
+	fe_mul(h->X, h->X, v3);
+	fe_mul(h->X, h->X, u); /* x = uv^3(uv^7)^((q - 5) / 8) */
+
+	fe_sq(vxx, h->X);
+	fe_mul(vxx, vxx, v);
+	fe_sub(check, vxx, u); /* vx^2 - u */
+	if (fe_isnonzero(check)) {
+		fe_add(check, vxx, u); /* vx^2 + u */
+		if (fe_isnonzero(check))
+			return -1;
+		fe_mul(h->X, h->X, ed25519_sqrtm1);
+	}
+
+	if (fe_isnegative(h->X) == (s[31] >> 7))
+		fe_neg(h->X, h->X);
+
+	fe_mul(h->T, h->X, h->Y);
+	return 0;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Scalars mod L = 2^252 + 27742317777372353535851937790883648493 */
+
+static const uint8_t ed25519_l[32] = {
+	0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7,
+	0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+};
+
+/* s = s mod L, s is 64 bytes on input and 32 bytes on output */
+static void sc_reduce(uint8_t s[64])
+{
+	int64_t x[64], carry;
+	int i, j;
+
+	for (i = 0; i < 64; i++)
+		x[i] = s[i];
+
+	for (i = 63; i >= 32; i--) {
+		carry = 0;
+		for (j = i - 32; j < i - 12; j++) {
+			x[j] += carry - 16 * x[i] * ed25519_l[j - (i - 32)];
+			carry = (x[j] + 128) >> 8;
+			x[j] -= carry * 256;
+		}
+		x[j] += carry;
+		x[i] = 0;
+	}
+
+	carry = 0;
+	for (j = 0; j < 32; j++) {
+		x[j] += carry - (x[31] >> 4) * ed25519_l[j];
+		carry = x[j] >> 8;
+		x[j] &= 255;
+	}
+	for (j = 0; j < 32; j++)
+		x[j] -= carry * ed25519_l[j];
+	for (i = 0; i < 32; i++) {
+		x[i + 1] += x[i] >> 8;
+		s[i] = (uint8_t)(x[i] & 255);
+	}
+}
+
+/* S must be fully reduced, otherwise signatures are malleable */
+static int sc_is_canonical(const uint8_t s[32])
+{
+	int i;
+
+	for (i = 31; i >= 0; i--) {
+		if (s[i] < ed25519_l[i])
+			return 1;
+		if (s[i] > ed25519_l[i])
+			return 0;
+	}
+	return 0;
+}
+
+/* Signed sliding window recoding, digits are odd and below 2^(w - 1) */
+static void slide(int8_t r[256], const uint8_t a[32], int w)
+{
+	int bound = (1 << (w - 1)) - 1;
+	int i, b, k;
+
+	for (i = 0; i < 256; i++)
+		r[i] = 1 & (a[i >> 3] >> (i & 7));
+
+	for (i = 0; i < 256; i++) {
+		if (!r[i])
+			continue;
+		for (b = 1; b <= w + 1 && i + b < 256; b++) {
+			if (!r[i + b])
+				continue;
+			if (r[i] + (r[i + b] << b) <= bound) {
+				r[i] += r[i + b] << b;
+				r[i + b] = 0;
+			} else if (r[i] - (r[i + b] << b) >= -bound) {
+				r[i] -= r[i + b] << b;
+				for (k = i + b; k < 256; k++) {
+					if (!r[k]) {
+						r[k] = 1;
+						break;
+					}
+					r[k] = 0;
+				}
+			} else {
+				break;
+			}
+		}
+	}
+}
+
+/* r = a * A + b * B */
+static void ge_double_scalarmult_vartime(struct ge_p2 *r, const uint8_t a[32],
+					 const struct ge_p3 *A,
+					 const uint8_t b[32])
+{
+	int8_t aslide[256], bslide[256];
+	struct ge_cached Ai[1 << (ED25519_POINT_WINDOW - 2)];
+	struct ge_p1p1 t;
+	struct ge_p3 u, A2;
+	int i;
+
+	slide(aslide, a, ED25519_POINT_WINDOW);
+	slide(bslide, b, ED25519_BASE_WINDOW);
+
+	ge_p3_to_cached(&Ai[0], A);
+	ge_p3_dbl(&t, A);
+	ge_p1p1_to_p3(&A2, &t);
+	for (i = 1; i < (int)(sizeof(Ai) / sizeof(Ai[0])); i++) {
+		ge_add(&t, &A2, &Ai[i - 1]);
+		ge_p1p1_to_p3(&u, &t);
+		ge_p3_to_cached(&Ai[i], &u);
+	}
+
+	ge_p2_0(r);
+	for (i = 255; i >= 0; i--)
+		if (aslide[i] || bslide[i])
+			break;
+
+	for (; i >= 0; i--) {
+		ge_p2_dbl(&t, r);
+
+		if (aslide[i] > 0) {
+			ge_p1p1_to_p3(&u, &t);
+			ge_add(&t, &u, &Ai[aslide[i] / 2]);
+		} else if (aslide[i] < 0) {
+			ge_p1p1_to_p3(&u, &t);
+			ge_sub(&t, &u, &Ai[(-aslide[i]) / 2]);
+		}
+
+		if (bslide[i] > 0) {
+			ge_p1p1_to_p3(&u, &t);
+			ge_madd(&t, &u, &ed25519_base_odd[bslide[i] / 2]);
+		} else if (bslide[i] < 0) {
+			ge_p1p1_to_p3(&u, &t);
+			ge_msub(&t, &u, &ed25519_base_odd[(-bslide[i]) / 2]);
+		}
+
+		ge_p1p1_to_p2(r, &t);
+	}
+}
+
+int ed25519_verify(const uint8_t signature[ED25519_SIGNATURE_SIZE],
+		   const uint8_t *message, size_t message_len,
+		   const uint8_t public_key[ED25519_PUBKEY_SIZE])
+{
+	SHA512Context sha512_context;
+	uint8_t h[SHA512_HASH_SIZE];
+	uint8_t rcheck[32];
+	struct ge_p3 A;
+	struct ge_p2 R;
+
+	if (!sc_is_canonical(signature + 32))
+		return -1;
+	if (ge_frombytes_negate_vartime(&A, public_key) != 0)
+		return -1;
+
+	sha512_init(&sha512_context);
+	sha512_update(&sha512_context, signature, 32);
+	sha512_update(&sha512_context, public_key, ED25519_PUBKEY_SIZE);
+	sha512_update(&sha512_context, message, message_len);
+	sha512_final(&sha512_context, h);
+	sc_reduce(h);
+
+	/* R' = h * (-A) + S * B, valid when encode(R') == R */
+	ge_double_scalarmult_vartime(&R, h, &A, signature + 32);
+	ge_tobytes(rcheck, &R);
+
+	return memcmp(rcheck, signature, 32) == 0 ? 0 : -1;
+}
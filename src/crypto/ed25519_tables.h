@@ -0,0 +1,93 @@
+/* Generated by utils/gen_ed25519_tables.py 6, do not edit. */
+
+/* clang-format off */
+#define ED25519_BASE_WINDOW	6
+
+static const fe ed25519_d = { 0x34dca135978a3ULL, 0x1a8283b156ebdULL, 0x5e7a26001c029ULL, 0x739c663a03cbbULL, 0x52036cee2b6ffULL };
+static const fe ed25519_d2 = { 0x69b9426b2f159ULL, 0x35050762add7aULL, 0x3cf44c0038052ULL, 0x6738cc7407977ULL, 0x2406d9dc56dffULL };
+static const fe ed25519_sqrtm1 = { 0x61b274a0ea0b0ULL, 0x0d5a5fc8f189dULL, 0x7ef5e9cbd0c60ULL, 0x78595a6804c9eULL, 0x2b8324804fc1dULL };
+
+/* B, 3B, 5B, ... as (y + x, y - x, 2dxy) */
+static const struct ge_precomp ed25519_base_odd[16] = {
+	{
+		{ 0x493c6f58c3b85ULL, 0x0df7181c325f7ULL, 0x0f50b0b3e4cb7ULL, 0x5329385a44c32ULL, 0x07cf9d3a33d4bULL },
+		{ 0x03905d740913eULL, 0x0ba2817d673a2ULL, 0x23e2827f4e67cULL, 0x133d2e0c21a34ULL, 0x44fd2f9298f81ULL },
+		{ 0x11205877aaa68ULL, 0x479955893d579ULL, 0x50d66309b67a0ULL, 0x2d42d0dbee5eeULL, 0x6f117b689f0c6ULL },
+	},
+	{
+		{ 0x5b0a84cee9730ULL, 0x61d10c97155e4ULL, 0x4059cc8096a10ULL, 0x47a608da8014fULL, 0x7a164e1b9a80fULL },
+		{ 0x11fe8a4fcd265ULL, 0x7bcb8374faaccULL, 0x52f5af4ef4d4fULL, 0x5314098f98d10ULL, 0x2ab91587555bdULL },
+		{ 0x6933f0dd0d889ULL, 0x44386bb4c4295ULL, 0x3cb6d3162508cULL, 0x26368b872a2c6ULL, 0x5a2826af12b9bULL },
+	},
+	{
+		{ 0x2bc4408a5bb33ULL, 0x078ebdda05442ULL, 0x2ffb112354123ULL, 0x375ee8df5862dULL, 0x2945ccf146e20ULL },
+		{ 0x182c3a447d6baULL, 0x22964e536eff2ULL, 0x192821f540053ULL, 0x2f9f19e788e5cULL, 0x154a7e73eb1b5ULL },
+		{ 0x3dbf1812a8285ULL, 0x0fa17ba3f9797ULL, 0x6f69cb49c3820ULL, 0x34d5a0db3858dULL, 0x43aabe696b3bbULL },
+	},
+	{
+		{ 0x25cd0944ea3bfULL, 0x75673b81a4d63ULL, 0x150b925d1c0d4ULL, 0x13f38d9294114ULL, 0x461bea69283c9ULL },
+		{ 0x72c9aaa3221b1ULL, 0x267774474f74dULL, 0x064b0e9b28085ULL, 0x3f04ef53b27c9ULL, 0x1d6edd5d2e531ULL },
+		{ 0x36dc801b8b3a2ULL, 0x0e0a7d4935e30ULL, 0x1deb7cecc0d7dULL, 0x053a94e20dd2cULL, 0x7a9fbb1c6a0f9ULL },
+	},
+	{
+		{ 0x6678aa6a8632fULL, 0x5ea3788d8b365ULL, 0x21bd6d6994279ULL, 0x7ace75919e4e3ULL, 0x34b9ed338add7ULL },
+		{ 0x6217e039d8064ULL, 0x6dea408337e6dULL, 0x57ac112628206ULL, 0x647cb65e30473ULL, 0x49c05a51fadc9ULL },
+		{ 0x4e8bf9045af1bULL, 0x514e33a45e0d6ULL, 0x7533c5b8bfe0fULL, 0x583557b7e14c9ULL, 0x73c172021b008ULL },
+	},
+	{
+		{ 0x700848a802adeULL, 0x1e04605c4e5f7ULL, 0x5c0d01b9767fbULL, 0x7d7889f42388bULL, 0x4275aae2546d8ULL },
+		{ 0x75b0249864348ULL, 0x52ee11070262bULL, 0x237ae54fb5acdULL, 0x3bfd1d03aaab5ULL, 0x18ab598029d5cULL },
+		{ 0x32cc5fd6089e9ULL, 0x426505c949b05ULL, 0x46a18880c7ad2ULL, 0x4a4221888ccdaULL, 0x3dc65522b53dfULL },
+	},
+	{
+		{ 0x0c222a2007f6dULL, 0x356b79bdb77eeULL, 0x41ee81efe12ceULL, 0x120a9bd07097dULL, 0x234fd7eec346fULL },
+		{ 0x7013b327fbf93ULL, 0x1336eeded6a0dULL, 0x2b565a2bbf3afULL, 0x253ce89591955ULL, 0x0267882d17602ULL },
+		{ 0x0a119732ea378ULL, 0x63bf1ba8e2a6cULL, 0x69f94cc90df9aULL, 0x431d1779bfc48ULL, 0x497ba6fdaa097ULL },
+	},
+	{
+		{ 0x6cc0313cfeaa0ULL, 0x1a313848da499ULL, 0x7cb534219230aULL, 0x39596dedefd60ULL, 0x61e22917f12deULL },
+		{ 0x3cd86468ccf0bULL, 0x48553221ac081ULL, 0x6c9464b4e0a6eULL, 0x75fba84180403ULL, 0x43b5cd4218d05ULL },
+		{ 0x2762f9bd0b516ULL, 0x1c6e7fbddcbb3ULL, 0x75909c3ace2bdULL, 0x42101972d3ec9ULL, 0x511d61210ae4dULL },
+	},
+	{
+		{ 0x676ef950e9d81ULL, 0x1b81ae089f258ULL, 0x63c4922951883ULL, 0x2f1d54d9b3237ULL, 0x6d325924ddb85ULL },
+		{ 0x386484420de87ULL, 0x2d6b25db68102ULL, 0x650b4962873c0ULL, 0x4081cfd271394ULL, 0x71a7fe6fe2482ULL },
+		{ 0x182b8a5c8c854ULL, 0x73fcbe5406d8eULL, 0x5de3430cff451ULL, 0x554b967ac8c41ULL, 0x4746c4b6559eeULL },
+	},
+	{
+		{ 0x77b3c6dc69a2bULL, 0x4edf13ec2fa6eULL, 0x4e85ad77beac8ULL, 0x7dba2b28e7bdaULL, 0x5c9a51de34fe9ULL },
+		{ 0x546c864741147ULL, 0x3a1df99092690ULL, 0x1ca8cc9f4d6bbULL, 0x36b7fc9cd3b03ULL, 0x219663497db5eULL },
+		{ 0x0f1cf79f10e67ULL, 0x43ccb0a2b7ea2ULL, 0x05089dfff776aULL, 0x1dd84e1d38b88ULL, 0x4804503c60822ULL },
+	},
+	{
+		{ 0x49ed02ca37fc7ULL, 0x474c2b5957884ULL, 0x5b8388e816683ULL, 0x4b6c454b76be4ULL, 0x553398a516506ULL },
+		{ 0x021d23a36d175ULL, 0x4fd3373c6476dULL, 0x20e291eeed02aULL, 0x62f2ecf2e7210ULL, 0x771e098858de4ULL },
+		{ 0x2f5d278451edfULL, 0x730b133997342ULL, 0x6965420eb6975ULL, 0x308a3bfa516cfULL, 0x5a5ed1d68ff5aULL },
+	},
+	{
+		{ 0x5122afe150e83ULL, 0x4afc966bb0232ULL, 0x1c478833c8268ULL, 0x17839c3fc148fULL, 0x44acb897d8bf9ULL },
+		{ 0x5e0c558527359ULL, 0x3395b73afd75cULL, 0x072afa4e4b970ULL, 0x62214329e0f6dULL, 0x019b60135fefdULL },
+		{ 0x068145e134b83ULL, 0x1e4860982c3ccULL, 0x068fb5f13d799ULL, 0x7c9283744547eULL, 0x150c49fde6ad2ULL },
+	},
+	{
+		{ 0x3f29509471138ULL, 0x729eeb4ca31cfULL, 0x69c22b575bfbcULL, 0x4910857bce212ULL, 0x6b2b5a075bb99ULL },
+		{ 0x1863c9cdca868ULL, 0x3770e295a1709ULL, 0x0d85a3720fd13ULL, 0x5e0ff1f71ab06ULL, 0x78a6d7791e05fULL },
+		{ 0x7704b47a0b976ULL, 0x2ae82e91aab17ULL, 0x50bd6429806cdULL, 0x68055158fd8eaULL, 0x725c7ffc4ad55ULL },
+	},
+	{
+		{ 0x26715d1cf99b2ULL, 0x2205441a69c88ULL, 0x448427dcd4b54ULL, 0x1d191e88abdc5ULL, 0x794cc9277cb1fULL },
+		{ 0x02bf71cd098c0ULL, 0x49dabcc6cd230ULL, 0x40a6533f905b2ULL, 0x573efac2eb8a4ULL, 0x4cd54625f855fULL },
+		{ 0x6c426c2ac5053ULL, 0x5a65ece4b095eULL, 0x0c44086f26bb6ULL, 0x7429568197885ULL, 0x7008357b6fcc8ULL },
+	},
+	{
+		{ 0x0672738773f01ULL, 0x752bf799f6171ULL, 0x6b4a6dae33323ULL, 0x7b54696ead1dcULL, 0x06ef7e9851ad0ULL },
+		{ 0x39fbb82584a34ULL, 0x47a568f257a03ULL, 0x14d88091ead91ULL, 0x2145b18b1ce24ULL, 0x13a92a3669d6dULL },
+		{ 0x3771cc0577de5ULL, 0x3ca06bb8b9952ULL, 0x00b81c5d50390ULL, 0x43512340780ecULL, 0x3c296ddf8a2afULL },
+	},
+	{
+		{ 0x515f9d914a713ULL, 0x73191ff2255d5ULL, 0x54f5cc2a4bdefULL, 0x3dd57fc118bcfULL, 0x7a99d393490c7ULL },
+		{ 0x34d2ebb1f2541ULL, 0x0e815b723ff9dULL, 0x286b416e25443ULL, 0x0bdfe38d1bee8ULL, 0x0a892c7007477ULL },
+		{ 0x2ed2436bda3e8ULL, 0x02afd00f291eaULL, 0x0be7381dea321ULL, 0x3e952d4b2b193ULL, 0x286762d28302fULL },
+	},
+};
+/* clang-format on */
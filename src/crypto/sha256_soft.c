@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "sha256_soft.h"
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+	0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+	0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t load_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void store_be32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)(v >> 24);
+	p[1] = (uint8_t)(v >> 16);
+	p[2] = (uint8_t)(v >> 8);
+	p[3] = (uint8_t)v;
+}
+
+void sha256_soft_transform(uint32_t hash[8], const uint8_t *block)
+{
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = load_be32(block + 4 * i);
+	for (i = 16; i < 64; i++) {
+		uint32_t s0 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^
+			      (w[i - 15] >> 3);
+		uint32_t s1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^
+			      (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	a = hash[0];
+	b = hash[1];
+	c = hash[2];
+	d = hash[3];
+	e = hash[4];
+	f = hash[5];
+	g = hash[6];
+	h = hash[7];
+
+	for (i = 0; i < 64; i++) {
+		t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) +
+		     ((e & f) ^ (~e & g)) + K[i] + w[i];
+		t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) +
+		     ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	hash[0] += a;
+	hash[1] += b;
+	hash[2] += c;
+	hash[3] += d;
+	hash[4] += e;
+	hash[5] += f;
+	hash[6] += g;
+	hash[7] += h;
+}
+
+void sha256_soft_init(SHA256SoftContext *sc)
+{
+	sc->hash[0] = 0x6a09e667;
+	sc->hash[1] = 0xbb67ae85;
+	sc->hash[2] = 0x3c6ef372;
+	sc->hash[3] = 0xa54ff53a;
+	sc->hash[4] = 0x510e527f;
+	sc->hash[5] = 0x9b05688c;
+	sc->hash[6] = 0x1f83d9ab;
+	sc->hash[7] = 0x5be0cd19;
+	sc->totalLength = 0;
+	sc->bufferLength = 0;
+}
+
+void sha256_soft_update(SHA256SoftContext *sc, const void *vdata, size_t len)
+{
+	const uint8_t *data = vdata;
+	size_t bytesToCopy;
+
+	sc->totalLength += len;
+	/* Whole blocks straight from the caller buffer */
+	if (sc->bufferLength == 0) {
+		while (len >= 64) {
+			sha256_soft_transform(sc->hash, data);
+			data += 64;
+			len -= 64;
+		}
+	}
+	while (len) {
+		bytesToCopy = 64 - sc->bufferLength;
+		if (bytesToCopy > len)
+			bytesToCopy = len;
+
+		memcpy(&sc->buffer[sc->bufferLength], data, bytesToCopy);
+		sc->bufferLength += bytesToCopy;
+		data += bytesToCopy;
+		len -= bytesToCopy;
+
+		if (sc->bufferLength == 64) {
+			sha256_soft_transform(sc->hash, sc->buffer);
+			sc->bufferLength = 0;
+		}
+	}
+}
+
+void sha256_soft_final(SHA256SoftContext *sc,
+		       uint8_t hash[SHA256_SOFT_HASH_SIZE])
+{
+	uint64_t bits = sc->totalLength * 8;
+	int i;
+
+	sc->buffer[sc->bufferLength++] = 0x80;
+	if (sc->bufferLength > 56) {
+		memset(&sc->buffer[sc->bufferLength], 0,
+		       64 - sc->bufferLength);
+		sha256_soft_transform(sc->hash, sc->buffer);
+		sc->bufferLength = 0;
+	}
+	memset(&sc->buffer[sc->bufferLength], 0, 56 - sc->bufferLength);
+	store_be32(&sc->buffer[56], (uint32_t)(bits >> 32));
+	store_be32(&sc->buffer[60], (uint32_t)bits);
+	sha256_soft_transform(sc->hash, sc->buffer);
+
+	for (i = 0; i < 8; i++)
+		store_be32(hash + 4 * i, sc->hash[i]);
+}
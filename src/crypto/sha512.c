@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "sha512.h"
+
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+static const uint64_t K[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+	0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+	0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+	0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+	0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+	0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+	0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+	0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+	0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+	0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+	0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+	0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+	0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+	0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+	0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+	0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+	0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+	0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+	0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+	0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+	0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static uint64_t load_be64(const uint8_t *p)
+{
+	return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+	       ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+	       ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+	       ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static void store_be64(uint8_t *p, uint64_t v)
+{
+	int i;
+
+	for (i = 7; i >= 0; i--) {
+		p[i] = (uint8_t)v;
+		v >>= 8;
+	}
+}
+
+static void sha512_transform(SHA512Context *sc, const uint8_t *block)
+{
+	uint64_t w[80];
+	uint64_t a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = load_be64(block + 8 * i);
+	for (i = 16; i < 80; i++) {
+		uint64_t s0 = ROTR64(w[i - 15], 1) ^ ROTR64(w[i - 15], 8) ^
+			      (w[i - 15] >> 7);
+		uint64_t s1 = ROTR64(w[i - 2], 19) ^ ROTR64(w[i - 2], 61) ^
+			      (w[i - 2] >> 6);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	a = sc->hash[0];
+	b = sc->hash[1];
+	c = sc->hash[2];
+	d = sc->hash[3];
+	e = sc->hash[4];
+	f = sc->hash[5];
+	g = sc->hash[6];
+	h = sc->hash[7];
+
+	for (i = 0; i < 80; i++) {
+		t1 = h + (ROTR64(e, 14) ^ ROTR64(e, 18) ^ ROTR64(e, 41)) +
+		     ((e & f) ^ (~e & g)) + K[i] + w[i];
+		t2 = (ROTR64(a, 28) ^ ROTR64(a, 34) ^ ROTR64(a, 39)) +
+		     ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	sc->hash[0] += a;
+	sc->hash[1] += b;
+	sc->hash[2] += c;
+	sc->hash[3] += d;
+	sc->hash[4] += e;
+	sc->hash[5] += f;
+	sc->hash[6] += g;
+	sc->hash[7] += h;
+}
+
+void sha512_init(SHA512Context *sc)
+{
+	sc->hash[0] = 0x6a09e667f3bcc908ULL;
+	sc->hash[1] = 0xbb67ae8584caa73bULL;
+	sc->hash[2] = 0x3c6ef372fe94f82bULL;
+	sc->hash[3] = 0xa54ff53a5f1d36f1ULL;
+	sc->hash[4] = 0x510e527fade682d1ULL;
+	sc->hash[5] = 0x9b05688c2b3e6c1fULL;
+	sc->hash[6] = 0x1f83d9abfb41bd6bULL;
+	sc->hash[7] = 0x5be0cd19137e2179ULL;
+	sc->totalLength = 0;
+	sc->bufferLength = 0;
+}
+
+void sha512_update(SHA512Context *sc, const void *vdata, size_t len)
+{
+	const uint8_t *data = vdata;
+	size_t bytesToCopy;
+
+	sc->totalLength += len;
+	while (len) {
+		bytesToCopy = 128 - sc->bufferLength;
+		if (bytesToCopy > len)
+			bytesToCopy = len;
+
+		memcpy(&sc->buffer[sc->bufferLength], data, bytesToCopy);
+		sc->bufferLength += bytesToCopy;
+		data += bytesToCopy;
+		len -= bytesToCopy;
+
+		if (sc->bufferLength == 128) {
+			sha512_transform(sc, sc->buffer);
+			sc->bufferLength = 0;
+		}
+	}
+}
+
+void sha512_final(SHA512Context *sc, uint8_t hash[SHA512_HASH_SIZE])
+{
+	uint64_t bits = sc->totalLength * 8;
+	int i;
+
+	sc->buffer[sc->bufferLength++] = 0x80;
+	if (sc->bufferLength > 112) {
+		memset(&sc->buffer[sc->bufferLength], 0,
+		       128 - sc->bufferLength);
+		sha512_transform(sc, sc->buffer);
+		sc->bufferLength = 0;
+	}
+	memset(&sc->buffer[sc->bufferLength], 0, 120 - sc->bufferLength);
+	store_be64(&sc->buffer[120], bits);
+	sha512_transform(sc, sc->buffer);
+
+	for (i = 0; i < 8; i++)
+		store_be64(hash + 8 * i, sc->hash[i]);
+}
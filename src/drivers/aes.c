@@ -16,9 +16,14 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include "common.h"
 #include "encoding.h"
 #include "aes.h"
+#include "io.h"
+#include "otp.h"
+#include "sysctl.h"
+#include "utils.h"
 
 volatile struct aes_t *const aes RODATA =
 	(volatile struct aes_t *)AES_BASE_ADDR;
@@ -34,12 +39,12 @@ int aes_init(uint8_t *key_addr, uint8_t key_length, uint8_t *aes_iv,
 
 	if ((cipher_mod == AES_ECB) || (cipher_mod == AES_CBC))
 		data_size = ((data_size + 15) / 16) * 16;
-	aes->aes_endian |= 1;
+	writel(readl(&aes->aes_endian) | 1, &aes->aes_endian);
 	// write key Low byte alignment
 	num = key_length / 4;
 	for (i = 0; i < num; i++)
-		aes->aes_key[i] =
-			*((uint32_t *)(&key_addr[key_length - (4 * i) - 4]));
+		writel(*((uint32_t *)(&key_addr[key_length - (4 * i) - 4])),
+		       &aes->aes_key[i]);
 	remainder = key_length % 4;
 	if (remainder) {
 		switch (remainder) {
@@ -58,13 +63,13 @@ int aes_init(uint8_t *key_addr, uint8_t key_length, uint8_t *aes_iv,
 		default:
 			break;
 		}
-		aes->aes_key[num] = *((uint32_t *)(&u8data[0]));
+		writel(*((uint32_t *)(&u8data[0])), &aes->aes_key[num]);
 	}
 	// write iv Low byte alignment
 	num = iv_length / 4;
 	for (i = 0; i < num; i++)
-		aes->aes_iv[i] =
-			*((uint32_t *)(&aes_iv[iv_length - (4 * i) - 4]));
+		writel(*((uint32_t *)(&aes_iv[iv_length - (4 * i) - 4])),
+		       &aes->aes_iv[i]);
 	remainder = iv_length % 4;
 	if (remainder) {
 		switch (remainder) {
@@ -83,17 +88,17 @@ int aes_init(uint8_t *key_addr, uint8_t key_length, uint8_t *aes_iv,
 		default:
 			break;
 		}
-		aes->aes_iv[num] = *((uint32_t *)(&u8data[0]));
+		writel(*((uint32_t *)(&u8data[0])), &aes->aes_iv[num]);
 	}
-	aes->cipher_mode = cipher_mod;
+	writel(cipher_mod, &aes->cipher_mode);
 	/*
 	 * [1:0],set the first bit and second bit 00:ecb; 01:cbc;
 	 * 10,11：aes_gcm
 	 */
-	aes->encrpt_sel = encrpt_sel;
-	aes->gb_aad_end_adr = add_size - 1;
-	aes->gb_pc_end_adr = data_size - 1;
-	aes->gb_aes_en |= 1;
+	writel(encrpt_sel, &aes->encrpt_sel);
+	writel(add_size - 1, &aes->gb_aad_end_adr);
+	writel(data_size - 1, &aes->gb_pc_end_adr);
+	writel(readl(&aes->gb_aes_en) | 1, &aes->gb_aes_en);
 	//write aad
 	if (cipher_mod == AES_GCM) {
 		num = add_size / 4;
@@ -136,51 +141,51 @@ int aes_init(uint8_t *key_addr, uint8_t key_length, uint8_t *aes_iv,
 /*write data*/
 int aes_write_aad(uint32_t aad_data)
 {
-	aes->aes_aad_data = aad_data;
+	writel(aad_data, &aes->aes_aad_data);
 	return 0;
 }
 
 int aes_write_text(uint32_t text_data)
 {
-	aes->aes_text_data = text_data;
+	writel(text_data, &aes->aes_text_data);
 	return 0;
 }
 
 int aes_write_tag(uint32_t *tag)
 {
-	aes->gcm_in_tag[0] = tag[3];
-	aes->gcm_in_tag[1] = tag[2];
-	aes->gcm_in_tag[2] = tag[1];
-	aes->gcm_in_tag[3] = tag[0];
+	writel(tag[3], &aes->gcm_in_tag[0]);
+	writel(tag[2], &aes->gcm_in_tag[1]);
+	writel(tag[1], &aes->gcm_in_tag[2]);
+	writel(tag[0], &aes->gcm_in_tag[3]);
 	return 0;
 }
 /*get tag*/
 int get_data_in_flag(void)
 {
 	/*data can in flag 1: data ready 0: data not ready*/
-	return aes->data_in_flag;
+	return readl(&aes->data_in_flag);
 }
 
 int get_data_out_flag(void)
 {
 	/*data can output flag 1: data ready 0: data not ready*/
-	return aes->data_out_flag;
+	return readl(&aes->data_out_flag);
 }
 
 int get_tag_in_flag(void)
 {
 	/*data can output flag 1: data ready 0: data not ready*/
-	return aes->tag_in_flag;
+	return readl(&aes->tag_in_flag);
 }
 
 uint32_t read_out_data(void)
 {
-	return aes->aes_out_data;
+	return readl(&aes->aes_out_data);
 }
 
 int aes_check_tag(void)
 {
-	return aes->tag_chk;
+	return readl(&aes->tag_chk);
 }
 
 int aes_get_tag(uint8_t *l_tag)
@@ -188,25 +193,25 @@ int aes_get_tag(uint8_t *l_tag)
 	uint32_t u32tag;
 	uint8_t i = 0;
 
-	u32tag = aes->gcm_out_tag[3];
+	u32tag = readl(&aes->gcm_out_tag[3]);
 	l_tag[i++] = (uint8_t)((u32tag >> 24) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag >> 16) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag >> 8) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag)&0xff);
 
-	u32tag = aes->gcm_out_tag[2];
+	u32tag = readl(&aes->gcm_out_tag[2]);
 	l_tag[i++] = (uint8_t)((u32tag >> 24) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag >> 16) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag >> 8) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag)&0xff);
 
-	u32tag = aes->gcm_out_tag[1];
+	u32tag = readl(&aes->gcm_out_tag[1]);
 	l_tag[i++] = (uint8_t)((u32tag >> 24) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag >> 16) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag >> 8) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag)&0xff);
 
-	u32tag = aes->gcm_out_tag[0];
+	u32tag = readl(&aes->gcm_out_tag[0]);
 	l_tag[i++] = (uint8_t)((u32tag >> 24) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag >> 16) & 0xff);
 	l_tag[i++] = (uint8_t)((u32tag >> 8) & 0xff);
@@ -216,7 +221,7 @@ int aes_get_tag(uint8_t *l_tag)
 
 int aes_clear_chk_tag(void)
 {
-	aes->tag_clear = 0;
+	writel(0, &aes->tag_clear);
 	return 0;
 }
 
@@ -341,3 +346,57 @@ int check_tag(uint32_t *aes_gcm_tag)
 		return 0;
 	}
 }
+
+void aes_session_open(struct aes_session *session, const uint8_t *key)
+{
+	memset(session, 0, sizeof(*session));
+	if (key)
+		memcpy(session->key, key, sizeof(session->key));
+	else
+		session->otp_key = 1;
+
+	sysctl_clock_enable(SYSCTL_CLOCK_AES);
+	sysctl_reset(SYSCTL_RESET_AES);
+	session->opened = 1;
+}
+
+int aes_session_decrypt(struct aes_session *session, uint8_t *in, uint8_t *out,
+			uint32_t len, const uint8_t *iv)
+{
+	uint8_t next_iv[16];
+
+	if (!session->opened || (len % 16) != 0)
+		return -1;
+	if (len == 0)
+		return 0;
+
+	if (iv)
+		memcpy(session->iv, iv, sizeof(session->iv));
+	// save the chaining block before it is overwritten in place
+	memcpy(next_iv, &in[len - 16], sizeof(next_iv));
+
+	if (session->otp_key)
+		otp_key_output_enable();
+	aes_init(session->key, 16, session->iv, 16, NULL, AES_CBC,
+		 AES_DENCRPTION, 0, len);
+	aes_process(in, out, len, AES_CBC);
+	if (session->otp_key)
+		otp_key_output_disable();
+
+	memcpy(session->iv, next_iv, sizeof(session->iv));
+	return 0;
+}
+
+void aes_session_close(struct aes_session *session)
+{
+	if (!session->opened)
+		return;
+
+	if (session->otp_key)
+		otp_key_output_disable();
+	// drop key and chaining state held by the engine
+	sysctl_reset(SYSCTL_RESET_AES);
+	sysctl_clock_disable(SYSCTL_CLOCK_AES);
+
+	secure_zero(session, sizeof(*session));
+}
@@ -15,7 +15,9 @@
  */
 
 #include "common.h"
+#include "encoding.h"
 #include "flash.h"
+#include "io.h"
 #include "fpioa.h"
 #include "printf.h"
 #include "sleep.h"
@@ -51,6 +53,8 @@
 #define CHIP_ERASE				0x60
 #define READ_ID					0x90
 
+#define SPI_RISR_RXOIR				0x08
+
 #define REG1_BUSY_MASK				0x01
 #define REG2_QUAL_MASK				0x02
 #define CONTINUE_READ_MASK			0x20
@@ -58,6 +62,9 @@
 
 enum flash_status_t (*flash_page_program_fun)(uint32_t addr, uint8_t *data_buf,
 					      uint32_t length);
+/* The same program without waiting for the flash, see flash_program_start() */
+static void (*flash_program_start_fun)(uint32_t addr, uint8_t *data_buf,
+				       uint32_t length);
 enum flash_status_t (*flash_read_fun)(uint32_t addr, uint8_t *data_buf,
 				      uint32_t length);
 
@@ -69,6 +76,10 @@ static enum flash_status_t flash_page_program(uint32_t addr, uint8_t *data_buf,
 					      uint32_t length);
 static enum flash_status_t
 flash_quad_page_program(uint32_t addr, uint8_t *data_buf, uint32_t length);
+static void flash_page_program_start(uint32_t addr, uint8_t *data_buf,
+				     uint32_t length);
+static void flash_quad_page_program_start(uint32_t addr, uint8_t *data_buf,
+					  uint32_t length);
 
 static volatile struct spi_t *spi_handle;
 static uint8_t dfs_offset, tmod_offset, frf_offset;
@@ -79,21 +90,22 @@ static enum flash_status_t flash_receive_data(uint8_t *cmd_buff,
 {
 	uint32_t index, fifo_len;
 
-	spi_handle->ctrlr0 = (0x07 << dfs_offset) | (0x03 << tmod_offset);
-	spi_handle->ctrlr1 = rx_len - 1;
-	spi_handle->ssienr = 0x01;
+	writel((0x07 << dfs_offset) | (0x03 << tmod_offset),
+	       &spi_handle->ctrlr0);
+	writel(rx_len - 1, &spi_handle->ctrlr1);
+	writel(0x01, &spi_handle->ssienr);
 	while (cmd_len--)
-		spi_handle->dr[0] = *cmd_buff++;
-	spi_handle->ser = SPI_SLAVE_SELECT;
+		writel(*cmd_buff++, &spi_handle->dr[0]);
+	writel(SPI_SLAVE_SELECT, &spi_handle->ser);
 	while (rx_len) {
-		fifo_len = spi_handle->rxflr;
+		fifo_len = readl(&spi_handle->rxflr);
 		fifo_len = fifo_len < rx_len ? fifo_len : rx_len;
 		for (index = 0; index < fifo_len; index++)
-			*rx_buff++ = spi_handle->dr[0];
+			*rx_buff++ = readl(&spi_handle->dr[0]);
 		rx_len -= fifo_len;
 	}
-	spi_handle->ser = 0x00;
-	spi_handle->ssienr = 0x00;
+	writel(0x00, &spi_handle->ser);
+	writel(0x00, &spi_handle->ssienr);
 	return FLASH_OK;
 }
 
@@ -102,27 +114,28 @@ static enum flash_status_t flash_send_data(uint8_t *cmd_buff, uint8_t cmd_len,
 {
 	uint32_t index, fifo_len;
 
-	spi_handle->ctrlr0 = (0x07 << dfs_offset) | (0x01 << tmod_offset);
-	spi_handle->ssienr = 0x01;
+	writel((0x07 << dfs_offset) | (0x01 << tmod_offset),
+	       &spi_handle->ctrlr0);
+	writel(0x01, &spi_handle->ssienr);
 	while (cmd_len--)
-		spi_handle->dr[0] = *cmd_buff++;
-	fifo_len = 32 - spi_handle->txflr;
+		writel(*cmd_buff++, &spi_handle->dr[0]);
+	fifo_len = 32 - readl(&spi_handle->txflr);
 	fifo_len = fifo_len < tx_len ? fifo_len : tx_len;
 	for (index = 0; index < fifo_len; index++)
-		spi_handle->dr[0] = *tx_buff++;
+		writel(*tx_buff++, &spi_handle->dr[0]);
 	tx_len -= fifo_len;
-	spi_handle->ser = SPI_SLAVE_SELECT;
+	writel(SPI_SLAVE_SELECT, &spi_handle->ser);
 	while (tx_len) {
-		fifo_len = 32 - spi_handle->txflr;
+		fifo_len = 32 - readl(&spi_handle->txflr);
 		fifo_len = fifo_len < tx_len ? fifo_len : tx_len;
 		for (index = 0; index < fifo_len; index++)
-			spi_handle->dr[0] = *tx_buff++;
+			writel(*tx_buff++, &spi_handle->dr[0]);
 		tx_len -= fifo_len;
 	}
-	while ((spi_handle->sr & 0x05) != 0x04)
+	while ((readl(&spi_handle->sr) & 0x05) != 0x04)
 		;
-	spi_handle->ser = 0x00;
-	spi_handle->ssienr = 0x00;
+	writel(0x00, &spi_handle->ser);
+	writel(0x00, &spi_handle->ssienr);
 	return FLASH_OK;
 }
 
@@ -131,23 +144,33 @@ static enum flash_status_t flash_receive_data_enhanced(uint32_t *cmd_buff,
 						       uint8_t *rx_buff,
 						       uint32_t rx_len)
 {
+	enum flash_status_t ret = FLASH_OK;
 	uint32_t index, fifo_len;
 
-	spi_handle->ctrlr1 = rx_len - 1;
-	spi_handle->ssienr = 0x01;
+	writel(rx_len - 1, &spi_handle->ctrlr1);
+	writel(0x01, &spi_handle->ssienr);
 	while (cmd_len--)
-		spi_handle->dr[0] = *cmd_buff++;
-	spi_handle->ser = SPI_SLAVE_SELECT;
+		writel(*cmd_buff++, &spi_handle->dr[0]);
+	writel(SPI_SLAVE_SELECT, &spi_handle->ser);
 	while (rx_len) {
-		fifo_len = spi_handle->rxflr;
+		fifo_len = readl(&spi_handle->rxflr);
 		fifo_len = fifo_len < rx_len ? fifo_len : rx_len;
 		for (index = 0; index < fifo_len; index++)
-			*rx_buff++ = spi_handle->dr[0];
+			*rx_buff++ = readl(&spi_handle->dr[0]);
 		rx_len -= fifo_len;
+		/*
+		 * More than a FIFO is clocked in without waiting for the CPU,
+		 * once bytes were dropped the count would never be reached.
+		 */
+		if (rx_len && (readl(&spi_handle->risr) & SPI_RISR_RXOIR)) {
+			(void)readl(&spi_handle->rxoicr);
+			ret = FLASH_ERROR;
+			break;
+		}
 	}
-	spi_handle->ser = 0x00;
-	spi_handle->ssienr = 0x00;
-	return FLASH_OK;
+	writel(0x00, &spi_handle->ser);
+	writel(0x00, &spi_handle->ssienr);
+	return ret;
 }
 
 static enum flash_status_t flash_send_data_enhanced(uint32_t *cmd_buff,
@@ -157,26 +180,26 @@ static enum flash_status_t flash_send_data_enhanced(uint32_t *cmd_buff,
 {
 	uint32_t index, fifo_len;
 
-	spi_handle->ssienr = 0x01;
+	writel(0x01, &spi_handle->ssienr);
 	while (cmd_len--)
-		spi_handle->dr[0] = *cmd_buff++;
-	fifo_len = 32 - spi_handle->txflr;
+		writel(*cmd_buff++, &spi_handle->dr[0]);
+	fifo_len = 32 - readl(&spi_handle->txflr);
 	fifo_len = fifo_len < tx_len ? fifo_len : tx_len;
 	for (index = 0; index < fifo_len; index++)
-		spi_handle->dr[0] = *tx_buff++;
+		writel(*tx_buff++, &spi_handle->dr[0]);
 	tx_len -= fifo_len;
-	spi_handle->ser = SPI_SLAVE_SELECT;
+	writel(SPI_SLAVE_SELECT, &spi_handle->ser);
 	while (tx_len) {
-		fifo_len = 32 - spi_handle->txflr;
+		fifo_len = 32 - readl(&spi_handle->txflr);
 		fifo_len = fifo_len < tx_len ? fifo_len : tx_len;
 		for (index = 0; index < fifo_len; index++)
-			spi_handle->dr[0] = *tx_buff++;
+			writel(*tx_buff++, &spi_handle->dr[0]);
 		tx_len -= fifo_len;
 	}
-	while ((spi_handle->sr & 0x05) != 0x04)
+	while ((readl(&spi_handle->sr) & 0x05) != 0x04)
 		;
-	spi_handle->ser = 0x00;
-	spi_handle->ssienr = 0x00;
+	writel(0x00, &spi_handle->ser);
+	writel(0x00, &spi_handle->ssienr);
 	return FLASH_OK;
 }
 
@@ -213,12 +236,13 @@ enum flash_status_t flash_init(uint8_t index)
 		frf_offset = 22;
 	}
 
-	spi_handle->baudr = 0x02;
-	spi_handle->imr = 0x00;
-	spi_handle->ser = 0x00;
-	spi_handle->ssienr = 0x00;
+	writel(0x02, &spi_handle->baudr);
+	writel(0x00, &spi_handle->imr);
+	writel(0x00, &spi_handle->ser);
+	writel(0x00, &spi_handle->ssienr);
 
 	flash_page_program_fun = flash_page_program;
+	flash_program_start_fun = flash_page_program_start;
 	flash_read_fun = flash_stand_read_data;
 	flash_send_data(cmd, 2, 0, 0);
 	return FLASH_OK;
@@ -325,39 +349,44 @@ enum flash_status_t flash_disable_protect(void)
 	return flash_check_status();
 }
 
-enum flash_status_t flash_sector_erase(uint32_t addr)
+static void flash_erase_start(uint8_t op, uint32_t addr)
 {
-	uint8_t cmd[4] = { SECTOR_ERASE };
+	uint8_t cmd[4] = { op };
 
 	cmd[1] = (uint8_t)(addr >> 16);
 	cmd[2] = (uint8_t)(addr >> 8);
 	cmd[3] = (uint8_t)(addr);
 	flash_write_enable();
 	flash_send_data(cmd, 4, 0, 0);
+}
+
+enum flash_status_t flash_sector_erase_start(uint32_t addr)
+{
+	flash_erase_start(SECTOR_ERASE, addr);
+	return FLASH_OK;
+}
+
+enum flash_status_t flash_64k_block_erase_start(uint32_t addr)
+{
+	flash_erase_start(BLOCK_64K_ERASE, addr);
+	return FLASH_OK;
+}
+
+enum flash_status_t flash_sector_erase(uint32_t addr)
+{
+	flash_erase_start(SECTOR_ERASE, addr);
 	return flash_check_status();
 }
 
 enum flash_status_t flash_32k_block_erase(uint32_t addr)
 {
-	uint8_t cmd[4] = { BLOCK_32K_ERASE };
-
-	cmd[1] = (uint8_t)(addr >> 16);
-	cmd[2] = (uint8_t)(addr >> 8);
-	cmd[3] = (uint8_t)(addr);
-	flash_write_enable();
-	flash_send_data(cmd, 4, 0, 0);
+	flash_erase_start(BLOCK_32K_ERASE, addr);
 	return flash_check_status();
 }
 
 enum flash_status_t flash_64k_block_erase(uint32_t addr)
 {
-	uint8_t cmd[4] = { BLOCK_64K_ERASE };
-
-	cmd[1] = (uint8_t)(addr >> 16);
-	cmd[2] = (uint8_t)(addr >> 8);
-	cmd[3] = (uint8_t)(addr);
-	flash_write_enable();
-	flash_send_data(cmd, 4, 0, 0);
+	flash_erase_start(BLOCK_64K_ERASE, addr);
 	return flash_check_status();
 }
 
@@ -381,6 +410,7 @@ enum flash_status_t flash_enable_quad_mode(void)
 		flash_write_status_reg(reg1_data, reg2_data);
 	}
 	flash_page_program_fun = flash_quad_page_program;
+	flash_program_start_fun = flash_quad_page_program_start;
 	flash_read_fun = flash_quad_read_data;
 	return flash_check_status();
 }
@@ -396,12 +426,13 @@ enum flash_status_t flash_disable_quad_mode(void)
 		flash_write_status_reg(reg1_data, reg2_data);
 	}
 	flash_page_program_fun = flash_page_program;
+	flash_program_start_fun = flash_page_program_start;
 	flash_read_fun = flash_stand_read_data;
 	return flash_check_status();
 }
 
-static enum flash_status_t flash_page_program(uint32_t addr, uint8_t *data_buf,
-					      uint32_t length)
+static void flash_page_program_start(uint32_t addr, uint8_t *data_buf,
+				     uint32_t length)
 {
 	uint8_t cmd[4] = { PAGE_PROGRAM };
 
@@ -410,21 +441,34 @@ static enum flash_status_t flash_page_program(uint32_t addr, uint8_t *data_buf,
 	cmd[3] = (uint8_t)(addr);
 	flash_write_enable();
 	flash_send_data(cmd, 4, data_buf, length);
+}
+
+static enum flash_status_t flash_page_program(uint32_t addr, uint8_t *data_buf,
+					      uint32_t length)
+{
+	flash_page_program_start(addr, data_buf, length);
 	return flash_check_status();
 }
 
-static enum flash_status_t
-flash_quad_page_program(uint32_t addr, uint8_t *data_buf, uint32_t length)
+static void flash_quad_page_program_start(uint32_t addr, uint8_t *data_buf,
+					  uint32_t length)
 {
 	uint32_t cmd[2];
 
 	cmd[0] = QUAD_PAGE_PROGRAM;
 	cmd[1] = addr;
 	flash_write_enable();
-	spi_handle->ctrlr0 = (0x01 << tmod_offset) | (0x07 << dfs_offset) |
-			     (0x02 << frf_offset);
-	spi_handle->spi_ctrlr0 = (0x06 << 2) | (0x02 << 8);
+	writel((0x01 << tmod_offset) | (0x07 << dfs_offset) |
+		       (0x02 << frf_offset),
+	       &spi_handle->ctrlr0);
+	writel((0x06 << 2) | (0x02 << 8), &spi_handle->spi_ctrlr0);
 	flash_send_data_enhanced(cmd, 2, data_buf, length);
+}
+
+static enum flash_status_t
+flash_quad_page_program(uint32_t addr, uint8_t *data_buf, uint32_t length)
+{
+	flash_quad_page_program_start(addr, data_buf, length);
 	return flash_check_status();
 }
 
@@ -439,7 +483,9 @@ enum flash_status_t flash_write_data(uint32_t addr, uint8_t *data_buf,
 		write_len = length < page_remain ? length : page_remain;
 		length -= write_len;
 		while (write_len) {
-			len = write_len > 32 ? 32 : write_len;
+			len = write_len > FLASH_PROGRAM_CHUNK ?
+				      FLASH_PROGRAM_CHUNK :
+				      write_len;
 			flash_page_program_fun(addr, data_buf, len);
 			addr += len;
 			data_buf += len;
@@ -449,9 +495,17 @@ enum flash_status_t flash_write_data(uint32_t addr, uint8_t *data_buf,
 	return flash_check_status();
 }
 
+enum flash_status_t flash_program_start(uint32_t addr, uint8_t *data_buf,
+					uint32_t length)
+{
+	flash_program_start_fun(addr, data_buf, length);
+	return FLASH_OK;
+}
+
 static enum flash_status_t flash_read(uint32_t addr, uint8_t *data_buf,
 				      uint32_t length, enum flash_read_t mode)
 {
+	enum flash_status_t ret = FLASH_OK;
 	uint32_t cmd[2];
 
 	switch (mode) {
@@ -473,58 +527,89 @@ static enum flash_status_t flash_read(uint32_t addr, uint8_t *data_buf,
 	case FLASH_DUAL:
 		cmd[0] = FAST_READ_DUAL_OUTPUT;
 		cmd[1] = addr;
-		spi_handle->ctrlr0 = (0x02 << tmod_offset) |
-				     (0x07 << dfs_offset) |
-				     (0x01 << frf_offset);
-		spi_handle->spi_ctrlr0 =
-			(0x06 << 2) | (0x02 << 8) | (0x08 << 11);
-		flash_receive_data_enhanced(cmd, 2, data_buf, length);
+		writel((0x02 << tmod_offset) | (0x07 << dfs_offset) |
+			       (0x01 << frf_offset),
+		       &spi_handle->ctrlr0);
+		writel((0x06 << 2) | (0x02 << 8) | (0x08 << 11),
+		       &spi_handle->spi_ctrlr0);
+		ret = flash_receive_data_enhanced(cmd, 2, data_buf, length);
 		break;
 	case FLASH_DUAL_SINGLE:
 		cmd[0] = FAST_READ_DUAL_IO;
 		cmd[1] = addr << 8;
-		spi_handle->ctrlr0 = (0x02 << tmod_offset) |
-				     (0x07 << dfs_offset) |
-				     (0x01 << frf_offset);
-		spi_handle->spi_ctrlr0 = (0x08 << 2) | (0x02 << 8) | 0x01;
-		flash_receive_data_enhanced(cmd, 2, data_buf, length);
+		writel((0x02 << tmod_offset) | (0x07 << dfs_offset) |
+			       (0x01 << frf_offset),
+		       &spi_handle->ctrlr0);
+		writel((0x08 << 2) | (0x02 << 8) | 0x01,
+		       &spi_handle->spi_ctrlr0);
+		ret = flash_receive_data_enhanced(cmd, 2, data_buf, length);
 		break;
 	case FLASH_QUAD:
 		cmd[0] = FAST_READ_QUAL_OUTPUT;
 		cmd[1] = addr;
-		spi_handle->ctrlr0 = (0x02 << tmod_offset) |
-				     (0x07 << dfs_offset) |
-				     (0x02 << frf_offset);
-		spi_handle->spi_ctrlr0 =
-			(0x06 << 2) | (0x02 << 8) | (0x08 << 11);
-		flash_receive_data_enhanced(cmd, 2, data_buf, length);
+		writel((0x02 << tmod_offset) | (0x07 << dfs_offset) |
+			       (0x02 << frf_offset),
+		       &spi_handle->ctrlr0);
+		writel((0x06 << 2) | (0x02 << 8) | (0x08 << 11),
+		       &spi_handle->spi_ctrlr0);
+		ret = flash_receive_data_enhanced(cmd, 2, data_buf, length);
 		break;
 	case FLASH_QUAD_SINGLE:
 		cmd[0] = FAST_READ_QUAL_IO;
 		cmd[1] = addr << 8;
-		spi_handle->ctrlr0 = (0x02 << tmod_offset) |
-				     (0x07 << dfs_offset) |
-				     (0x02 << frf_offset);
-		spi_handle->spi_ctrlr0 =
-			(0x08 << 2) | (0x02 << 8) | (0x04 << 11) | 0x01;
-		flash_receive_data_enhanced(cmd, 2, data_buf, length);
+		writel((0x02 << tmod_offset) | (0x07 << dfs_offset) |
+			       (0x02 << frf_offset),
+		       &spi_handle->ctrlr0);
+		writel((0x08 << 2) | (0x02 << 8) | (0x04 << 11) | 0x01,
+		       &spi_handle->spi_ctrlr0);
+		ret = flash_receive_data_enhanced(cmd, 2, data_buf, length);
 		break;
 	}
-	return FLASH_OK;
+	return ret;
 }
 
 enum flash_status_t flash_read_data(uint32_t addr, uint8_t *data_buf,
 				    uint32_t length, enum flash_read_t mode)
 {
+	enum flash_status_t ret = FLASH_OK, r;
 	uint32_t write_len;
 
 	while (length) {
 		write_len = length > 32 ? 32 : length;
-		flash_read(addr, data_buf, write_len, mode);
+		r = flash_read(addr, data_buf, write_len, mode);
+		if (ret == FLASH_OK)
+			ret = r;
 		addr += write_len;
 		data_buf += write_len;
 		length -= write_len;
 	}
+	return ret;
+}
+
+enum flash_status_t flash_read_bulk(uint32_t addr, uint8_t *data_buf,
+				    uint32_t length)
+{
+	uint32_t read_len;
+	enum flash_status_t ret;
+	uintptr_t mie;
+
+	while (length) {
+		read_len = length > FLASH_READ_BULK ? FLASH_READ_BULK : length;
+		/* an interrupt in the middle overflows the RX FIFO */
+		mie = read_csr(mstatus) & MSTATUS_MIE;
+		clear_csr(mstatus, MSTATUS_MIE);
+		ret = flash_read(addr, data_buf, read_len, FLASH_QUAD_SINGLE);
+		set_csr(mstatus, mie);
+		if (ret != FLASH_OK) {
+			ret = flash_read_data(addr, data_buf, read_len,
+					      FLASH_QUAD_SINGLE);
+			if (ret != FLASH_OK)
+				return ret;
+		}
+		addr += read_len;
+		data_buf += read_len;
+		length -= read_len;
+	}
 	return FLASH_OK;
 }
 
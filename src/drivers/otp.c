@@ -15,6 +15,7 @@
  */
 
 #include "common.h"
+#include "io.h"
 #include "otp.h"
 #include "platform.h"
 #include "sysctl.h"
@@ -30,48 +31,48 @@ volatile struct otp_t *const otp RODATA =
 void otp_init(uint8_t div)
 {
 	sysctl_clock_enable(SYSCTL_CLOCK_OTP);
-	otp->otp_cpu_ctrl = 0;
-	otp->otp_thershold = div;
-	otp->data_blk_ctrl = 0;
-	otp->gb_otp_en = 0;
-	otp->otp_pwr_mode = 0;
-	otp->otp_web_cpu = 1;
-	otp->otp_rstb_cpu = 1;
-	otp->otp_seltm_cpu = 0;
-	otp->otp_readen_cpu = 0;
-	otp->otp_pgmen_cpu = 0;
-	otp->otp_dle_cpu = 0;
-	otp->otp_din_cpu = 0;
-	otp->otp_cpumpen_cpu = 0;
-	otp->otp_cle_cpu = 0;
-	otp->otp_ceb_cpu = 1;
-	otp->otp_adr_cpu = 0;
-	otp->otp_dat_cpu = 0;
+	writel(0, &otp->otp_cpu_ctrl);
+	writel(div, &otp->otp_thershold);
+	writel(0, &otp->data_blk_ctrl);
+	writel(0, &otp->gb_otp_en);
+	writel(0, &otp->otp_pwr_mode);
+	writel(1, &otp->otp_web_cpu);
+	writel(1, &otp->otp_rstb_cpu);
+	writel(0, &otp->otp_seltm_cpu);
+	writel(0, &otp->otp_readen_cpu);
+	writel(0, &otp->otp_pgmen_cpu);
+	writel(0, &otp->otp_dle_cpu);
+	writel(0, &otp->otp_din_cpu);
+	writel(0, &otp->otp_cpumpen_cpu);
+	writel(0, &otp->otp_cle_cpu);
+	writel(1, &otp->otp_ceb_cpu);
+	writel(0, &otp->otp_adr_cpu);
+	writel(0, &otp->otp_dat_cpu);
 }
 
 void otp_test_enable(void)
 {
-	otp->otp_cpu_ctrl = 0xCAAC;
+	writel(0xCAAC, &otp->otp_cpu_ctrl);
 }
 
 void otp_test_disable(void)
 {
-	otp->otp_cpu_ctrl = 0;
+	writel(0, &otp->otp_cpu_ctrl);
 }
 
 void otp_key_output_enable(void)
 {
-	otp->gb_otp_en = 1;
+	writel(1, &otp->gb_otp_en);
 }
 
 void otp_key_output_disable(void)
 {
-	otp->gb_otp_en = 0;
+	writel(0, &otp->gb_otp_en);
 }
 
 enum otp_status_t otp_status_get(uint32_t flag)
 {
-	if (otp->otp_status & flag)
+	if (readl(&otp->otp_status) & flag)
 		return OTP_FLAG_SET;
 	return OTP_FLAG_UNSET;
 }
@@ -80,18 +81,18 @@ static enum otp_status_t otp_bisr_write(void)
 {
 	uint32_t time_out = 0;
 
-	otp->otp_cle = 1;
-	otp->otp_mode = 0x02;
-	otp->otp_test_mode = 0x30;
-	otp->test_step = 0;
-	otp->otp_ceb = 0;
-	while (otp->bisr_finish == 0) {
+	writel(1, &otp->otp_cle);
+	writel(0x02, &otp->otp_mode);
+	writel(0x30, &otp->otp_test_mode);
+	writel(0, &otp->test_step);
+	writel(0, &otp->otp_ceb);
+	while (readl(&otp->bisr_finish) == 0) {
 		time_out++;
 		if (time_out >= DELAY_TIMEOUT)
 			return OTP_ERROR_TIMEOUT;
 	}
-	otp->bisr_finish = 0;
-	if (otp->pro_wrong)
+	writel(0, &otp->bisr_finish);
+	if (readl(&otp->pro_wrong))
 		return OTP_ERROR_BISR;
 	return OTP_OK;
 }
@@ -100,17 +101,17 @@ static enum otp_status_t otp_bisr_read(void)
 {
 	uint32_t time_out = 0;
 
-	otp->otp_cle = 1;
-	otp->otp_mode = 0x02;
-	otp->otp_test_mode = 0x30;
-	otp->test_step = 1;
-	otp->otp_ceb = 0;
-	while (otp->bisr_finish == 0) {
+	writel(1, &otp->otp_cle);
+	writel(0x02, &otp->otp_mode);
+	writel(0x30, &otp->otp_test_mode);
+	writel(1, &otp->test_step);
+	writel(0, &otp->otp_ceb);
+	while (readl(&otp->bisr_finish) == 0) {
 		time_out++;
 		if (time_out >= DELAY_TIMEOUT)
 			return OTP_ERROR_TIMEOUT;
 	}
-	otp->bisr_finish = 0;
+	writel(0, &otp->bisr_finish);
 	return OTP_OK;
 }
 
@@ -122,17 +123,17 @@ enum otp_status_t otp_blank_check(void)
 	if (otp_func_reg_disable_get(BLANK_TEST_DISABLE) == OTP_WIRED_REG_SET)
 		return OTP_WIRED_REG_SET;
 
-	otp->otp_cle = 1;
-	otp->otp_mode = 0x02;
-	otp->otp_test_mode = 0x24;
-	otp->blank_finish = 0;
-	otp->otp_ceb = 0;
-	while (otp->blank_finish == 0) {
+	writel(1, &otp->otp_cle);
+	writel(0x02, &otp->otp_mode);
+	writel(0x24, &otp->otp_test_mode);
+	writel(0, &otp->blank_finish);
+	writel(0, &otp->otp_ceb);
+	while (readl(&otp->blank_finish) == 0) {
 		time_out++;
 		if (time_out >= DELAY_TIMEOUT)
 			return OTP_ERROR_TIMEOUT;
 	}
-	if (otp->otp_bisr_fail)
+	if (readl(&otp->otp_bisr_fail))
 		return OTP_ERROR_BLANK;
 
 	status = otp_bisr_write();
@@ -154,17 +155,17 @@ enum otp_status_t otp_testdec(void)
 {
 	uint32_t time_out = 0;
 
-	otp->otp_cle = 1;
-	otp->otp_mode = 0x02;
-	otp->otp_test_mode = 0x21;
-	otp->otp_ceb = 0;
-	while (otp->td_result == 0) {
+	writel(1, &otp->otp_cle);
+	writel(0x02, &otp->otp_mode);
+	writel(0x21, &otp->otp_test_mode);
+	writel(0, &otp->otp_ceb);
+	while (readl(&otp->td_result) == 0) {
 		time_out++;
 		if (time_out >= DELAY_TIMEOUT)
 			return OTP_ERROR_TIMEOUT;
 	}
-	if (otp->td_result == 0x01) {
-		otp->td_result = 0;
+	if (readl(&otp->td_result) == 0x01) {
+		writel(0, &otp->td_result);
 		return OTP_ERROR_TESTDEC;
 	}
 	return OTP_OK;
@@ -175,86 +176,86 @@ enum otp_status_t otp_wrtest(void)
 	uint16_t addr, data, i, j;
 	uint32_t time_out;
 
-	otp->otp_cle = 1;
-	otp->otp_mode = 0x02;
-	otp->otp_test_mode = 0x01;
-	otp->test_step = 0;
-	otp->data_acp_flag = 0;
-	otp->otp_ceb = 0;
+	writel(1, &otp->otp_cle);
+	writel(0x02, &otp->otp_mode);
+	writel(0x01, &otp->otp_test_mode);
+	writel(0, &otp->test_step);
+	writel(0, &otp->data_acp_flag);
+	writel(0, &otp->otp_ceb);
 	addr = 0;
 	for (i = 0; i < 128; i++) {
 		data = WRTEST_NUM;
 		for (j = 0; j < 8; j++) {
 			if ((addr == 1023) || (data & 0x01)) {
 				time_out = 0;
-				while (otp->otp_adr_in_flag == 0) {
+				while (readl(&otp->otp_adr_in_flag) == 0) {
 					time_out++;
 					if (time_out >= DELAY_TIMEOUT)
 						return OTP_ERROR_TIMEOUT;
 				}
-				otp->otp_apb_adr = addr;
+				writel(addr, &otp->otp_apb_adr);
 				if (addr == 1023) {
-					otp->otp_in_dat = data & 0x01;
-					otp->otp_last_dat = 0x01;
+					writel(data & 0x01, &otp->otp_in_dat);
+					writel(0x01, &otp->otp_last_dat);
 				} else
-					otp->otp_in_dat = 0x01;
-				otp->dat_in_finish = 0x01;
+					writel(0x01, &otp->otp_in_dat);
+				writel(0x01, &otp->dat_in_finish);
 				time_out = 0;
-				while (otp->data_acp_flag == 0) {
+				while (readl(&otp->data_acp_flag) == 0) {
 					time_out++;
 					if (time_out >= DELAY_TIMEOUT)
 						return OTP_ERROR_TIMEOUT;
 				}
-				if (otp->data_acp_flag == 0x01) {
-					otp->data_acp_flag = 0;
+				if (readl(&otp->data_acp_flag) == 0x01) {
+					writel(0, &otp->data_acp_flag);
 					return OTP_ERROR_WRITE;
 				}
-				otp->data_acp_flag = 0;
+				writel(0, &otp->data_acp_flag);
 			}
 			data >>= 1;
 			addr++;
 		}
 	}
 	time_out = 0;
-	while ((otp->wr_result & 0x04) == 0) {
+	while ((readl(&otp->wr_result) & 0x04) == 0) {
 		time_out++;
 		if (time_out >= DELAY_TIMEOUT)
 			return OTP_ERROR_TIMEOUT;
 	}
-	otp->wr_result &= 0xFFFFFFFB;
-
-	otp->otp_cle = 1;
-	otp->otp_mode = 0x02;
-	otp->otp_test_mode = 0x01;
-	otp->test_step = 1;
-	otp->data_acp_flag = 0;
-	otp->otp_ceb = 0;
+	writel(readl(&otp->wr_result) & 0xFFFFFFFB, &otp->wr_result);
+
+	writel(1, &otp->otp_cle);
+	writel(0x02, &otp->otp_mode);
+	writel(0x01, &otp->otp_test_mode);
+	writel(1, &otp->test_step);
+	writel(0, &otp->data_acp_flag);
+	writel(0, &otp->otp_ceb);
 	addr = 0;
 	for (i = 0; i < 128; i++) {
 		time_out = 0;
-		while (otp->otp_adr_in_flag == 0) {
+		while (readl(&otp->otp_adr_in_flag) == 0) {
 			time_out++;
 			if (time_out >= DELAY_TIMEOUT)
 				return OTP_ERROR_TIMEOUT;
-			if (otp->wr_result == 0x01) {
-				otp->wr_result = 0;
+			if (readl(&otp->wr_result) == 0x01) {
+				writel(0, &otp->wr_result);
 				return OTP_ERROR_WRTEST;
 			}
 		}
-		otp->otp_in_dat = WRTEST_NUM;
-		otp->otp_apb_adr = addr;
+		writel(WRTEST_NUM, &otp->otp_in_dat);
+		writel(addr, &otp->otp_apb_adr);
 		if (i == 127)
-			otp->otp_last_dat = 0x01;
+			writel(0x01, &otp->otp_last_dat);
 		addr += 8;
 	}
 	time_out = 0;
-	while ((otp->wr_result & 0x03) == 0) {
+	while ((readl(&otp->wr_result) & 0x03) == 0) {
 		time_out++;
 		if (time_out >= DELAY_TIMEOUT)
 			return OTP_ERROR_TIMEOUT;
 	}
-	if ((otp->wr_result & 0x03) == 0x01) {
-		otp->wr_result = 0;
+	if ((readl(&otp->wr_result) & 0x03) == 0x01) {
+		writel(0, &otp->wr_result);
 		return OTP_ERROR_WRTEST;
 	}
 	return OTP_OK;
@@ -267,11 +268,11 @@ static enum otp_status_t otp_write_byte(uint32_t addr, uint8_t *data_buf,
 	uint8_t data, index;
 	uint32_t time_out;
 
-	otp->otp_cle = 0;
-	otp->otp_mode = 1;
-	otp->data_acp_flag = 0;
-	otp->otp_wrg_adr_flag = 0;
-	otp->otp_ceb = 0;
+	writel(0, &otp->otp_cle);
+	writel(1, &otp->otp_mode);
+	writel(0, &otp->data_acp_flag);
+	writel(0, &otp->otp_wrg_adr_flag);
+	writel(0, &otp->otp_ceb);
 	index = 0;
 	addr *= 8;
 	length *= 8;
@@ -279,29 +280,29 @@ static enum otp_status_t otp_write_byte(uint32_t addr, uint8_t *data_buf,
 	while (length--) {
 		if ((length == 0) || (data & 0x01)) {
 			time_out = 0;
-			while (otp->otp_adr_in_flag == 0) {
+			while (readl(&otp->otp_adr_in_flag) == 0) {
 				time_out++;
 				if (time_out >= DELAY_TIMEOUT)
 					return OTP_ERROR_TIMEOUT;
 			}
-			otp->otp_apb_adr = addr;
+			writel(addr, &otp->otp_apb_adr);
 			if (length == 0) {
-				otp->otp_in_dat = data & 0x01;
-				otp->otp_last_dat = 1;
+				writel(data & 0x01, &otp->otp_in_dat);
+				writel(1, &otp->otp_last_dat);
 			} else
-				otp->otp_in_dat = 1;
-			otp->dat_in_finish = 1;
+				writel(1, &otp->otp_in_dat);
+			writel(1, &otp->dat_in_finish);
 			time_out = 0;
-			while (otp->data_acp_flag == 0) {
+			while (readl(&otp->data_acp_flag) == 0) {
 				time_out++;
 				if (time_out >= DELAY_TIMEOUT)
 					return OTP_ERROR_TIMEOUT;
 			}
-			if (otp->otp_wrg_adr_flag == 1)
+			if (readl(&otp->otp_wrg_adr_flag) == 1)
 				return OTP_ERROR_ADDRESS;
-			if (otp->data_acp_flag == 1)
+			if (readl(&otp->data_acp_flag) == 1)
 				return OTP_ERROR_WRITE;
-			otp->data_acp_flag = 0;
+			writel(0, &otp->data_acp_flag);
 		}
 		data >>= 1;
 		addr++;
@@ -326,30 +327,30 @@ static enum otp_status_t otp_read_byte(uint32_t addr, uint8_t *data_buf,
 {
 	uint32_t time_out;
 
-	otp->otp_cle = 0;
-	otp->otp_mode = 0;
-	otp->otp_wrg_adr_flag = 0;
-	otp->otp_ceb = 0;
+	writel(0, &otp->otp_cle);
+	writel(0, &otp->otp_mode);
+	writel(0, &otp->otp_wrg_adr_flag);
+	writel(0, &otp->otp_ceb);
 	addr *= 8;
 	while (length--) {
 		time_out = 0;
-		while (otp->otp_adr_in_flag == 0) {
+		while (readl(&otp->otp_adr_in_flag) == 0) {
 			time_out++;
 			if (time_out >= DELAY_TIMEOUT)
 				return OTP_ERROR_TIMEOUT;
 		}
 		if (length == 0)
-			otp->otp_last_dat = 1;
-		otp->otp_apb_adr = addr;
+			writel(1, &otp->otp_last_dat);
+		writel(addr, &otp->otp_apb_adr);
 		time_out = 0;
-		while (otp->otp_data_rdy == 0) {
+		while (readl(&otp->otp_data_rdy) == 0) {
 			time_out++;
 			if (time_out >= DELAY_TIMEOUT)
 				return OTP_ERROR_TIMEOUT;
 		}
-		if (otp->otp_wrg_adr_flag == 0x01)
+		if (readl(&otp->otp_wrg_adr_flag) == 0x01)
 			return OTP_ERROR_ADDRESS;
-		*data_buf++ = otp->otp_data;
+		*data_buf++ = readl(&otp->otp_data);
 		addr += 8;
 	}
 	return OTP_OK;
@@ -403,28 +404,31 @@ enum otp_status_t otp_key_compare(uint8_t *data_buf)
 {
 	uint32_t time_out = 0;
 
-	otp->key_cmp_result = 0;
-	otp->otp_cmp_key = ((uint32_t)data_buf[0] << 24) |
-			   ((uint32_t)data_buf[1] << 16) |
-			   ((uint32_t)data_buf[2] << 8) | (uint32_t)data_buf[3];
-	otp->otp_cmp_key = ((uint32_t)data_buf[4] << 24) |
-			   ((uint32_t)data_buf[5] << 16) |
-			   ((uint32_t)data_buf[6] << 8) | (uint32_t)data_buf[7];
-	otp->otp_cmp_key =
-		((uint32_t)data_buf[8] << 24) | ((uint32_t)data_buf[9] << 16) |
-		((uint32_t)data_buf[10] << 8) | (uint32_t)data_buf[11];
-	otp->otp_cmp_key = ((uint32_t)data_buf[12] << 24) |
-			   ((uint32_t)data_buf[13] << 16) |
-			   ((uint32_t)data_buf[14] << 8) |
-			   (uint32_t)data_buf[15];
-	while (otp->key_cmp_result == 0) {
+	writel(0, &otp->key_cmp_result);
+	writel(((uint32_t)data_buf[0] << 24) |
+		       ((uint32_t)data_buf[1] << 16) |
+		       ((uint32_t)data_buf[2] << 8) | (uint32_t)data_buf[3],
+	       &otp->otp_cmp_key);
+	writel(((uint32_t)data_buf[4] << 24) |
+		       ((uint32_t)data_buf[5] << 16) |
+		       ((uint32_t)data_buf[6] << 8) | (uint32_t)data_buf[7],
+	       &otp->otp_cmp_key);
+	writel(((uint32_t)data_buf[8] << 24) |
+		       ((uint32_t)data_buf[9] << 16) |
+		       ((uint32_t)data_buf[10] << 8) | (uint32_t)data_buf[11],
+	       &otp->otp_cmp_key);
+	writel(((uint32_t)data_buf[12] << 24) |
+		       ((uint32_t)data_buf[13] << 16) |
+		       ((uint32_t)data_buf[14] << 8) | (uint32_t)data_buf[15],
+	       &otp->otp_cmp_key);
+	while (readl(&otp->key_cmp_result) == 0) {
 		time_out++;
 		if (time_out >= DELAY_TIMEOUT)
 			return OTP_ERROR_TIMEOUT;
 	}
-	if (otp->key_cmp_result == 0x01)
+	if (readl(&otp->key_cmp_result) == 0x01)
 		return OTP_ERROR_KEYCOMP;
-	else if (otp->key_cmp_result == 0x03)
+	else if (readl(&otp->key_cmp_result) == 0x03)
 		return OTP_WIRED_REG_SET;
 	return OTP_OK;
 }
@@ -436,10 +440,10 @@ enum otp_status_t otp_data_block_protect_set(enum otp_data_block_t block)
 
 	if (block >= DATA_BLOCK_MAX)
 		return OTP_ERROR_PARAM;
-	otp->data_blk_ctrl = 0x01;
+	writel(0x01, &otp->data_blk_ctrl);
 	value = 0x03 << ((block % 4) * 2);
 	status = otp_write_byte(OTP_BLOCK_CTL_ADDR + block / 4, &value, 1);
-	otp->data_blk_ctrl = 0;
+	writel(0, &otp->data_blk_ctrl);
 	return status;
 }
 
@@ -450,20 +454,20 @@ enum otp_status_t otp_func_reg_disable_set(enum otp_func_reg_t func)
 
 	if (func >= FUNC_REG_MAX)
 		return OTP_ERROR_PARAM;
-	otp->data_blk_ctrl = 0x01;
+	writel(0x01, &otp->data_blk_ctrl);
 	value = 0x03 << ((func % 4) * 2);
 	status = otp_write_byte(OTP_WIRED_REG_ADDR + func / 4, &value, 1);
-	otp->data_blk_ctrl = 0;
+	writel(0, &otp->data_blk_ctrl);
 	return status;
 }
 
 enum otp_status_t otp_data_block_protect_get(enum otp_data_block_t block)
 {
 	if (block < DATA_BLOCK_MAX / 2) {
-		if (otp->block_flag_low & (0x01 << block))
+		if (readl(&otp->block_flag_low) & (0x01 << block))
 			return OTP_BLOCK_PROTECTED;
 	} else if (block < DATA_BLOCK_MAX) {
-		if (otp->block_flag_high &
+		if (readl(&otp->block_flag_high) &
 		    (0x01 << (block - DATA_BLOCK_MAX / 2)))
 			return OTP_BLOCK_PROTECTED;
 	} else
@@ -474,10 +478,11 @@ enum otp_status_t otp_data_block_protect_get(enum otp_data_block_t block)
 enum otp_status_t otp_func_reg_disable_get(enum otp_func_reg_t func)
 {
 	if (func < FUNC_REG_MAX / 2) {
-		if (otp->reg_flag_low & (0x01 << func))
+		if (readl(&otp->reg_flag_low) & (0x01 << func))
 			return OTP_WIRED_REG_SET;
 	} else if (func < FUNC_REG_MAX) {
-		if (otp->reg_flag_high & (0x01 << (func - FUNC_REG_MAX / 2)))
+		if (readl(&otp->reg_flag_high) &
+		    (0x01 << (func - FUNC_REG_MAX / 2)))
 			return OTP_WIRED_REG_SET;
 	} else
 		return OTP_ERROR_PARAM;
@@ -509,43 +514,43 @@ enum otp_status_t otp_soft_write(uint32_t addr, uint8_t *data_buf,
 {
 	uint8_t data, index, count;
 
-	otp->otp_ceb_cpu = 1;
-	otp->otp_cle_cpu = 0;
-	otp->otp_seltm_cpu = 0;
-	otp->otp_readen_cpu = 0;
-	otp->otp_dle_cpu = 0;
-	otp->otp_web_cpu = 1;
-	otp->otp_cpumpen_cpu = 0;
-	otp->otp_pgmen_cpu = 0;
-	otp->otp_rstb_cpu = 1;
+	writel(1, &otp->otp_ceb_cpu);
+	writel(0, &otp->otp_cle_cpu);
+	writel(0, &otp->otp_seltm_cpu);
+	writel(0, &otp->otp_readen_cpu);
+	writel(0, &otp->otp_dle_cpu);
+	writel(1, &otp->otp_web_cpu);
+	writel(0, &otp->otp_cpumpen_cpu);
+	writel(0, &otp->otp_pgmen_cpu);
+	writel(1, &otp->otp_rstb_cpu);
 
-	otp->otp_ceb_cpu = 0;
-	otp->otp_rstb_cpu = 0;
-	otp->otp_rstb_cpu = 1;
+	writel(0, &otp->otp_ceb_cpu);
+	writel(0, &otp->otp_rstb_cpu);
+	writel(1, &otp->otp_rstb_cpu);
 
 	index = 0;
 	addr *= 8;
 	length *= 8;
 	data = *data_buf++;
 	while (length) {
-		otp->otp_adr_cpu = addr;
-		otp->otp_din_cpu = data & 0x01;
-		otp->otp_dle_cpu = 1;
-		otp->otp_web_cpu = 0;
-		otp->otp_web_cpu = 1;
-		otp->otp_dle_cpu = 0;
+		writel(addr, &otp->otp_adr_cpu);
+		writel(data & 0x01, &otp->otp_din_cpu);
+		writel(1, &otp->otp_dle_cpu);
+		writel(0, &otp->otp_web_cpu);
+		writel(1, &otp->otp_web_cpu);
+		writel(0, &otp->otp_dle_cpu);
 		count = 20;
 		while (count--) {
-			otp->otp_pgmen_cpu = 1;
-			otp->otp_cpumpen_cpu = 1;
-			otp->otp_web_cpu = 0;
-			otp->otp_web_cpu = 1;
-			otp->otp_cpumpen_cpu = 0;
-			otp->otp_pgmen_cpu = 0;
-			if (otp->otp_dat_cpu == 0)
+			writel(1, &otp->otp_pgmen_cpu);
+			writel(1, &otp->otp_cpumpen_cpu);
+			writel(0, &otp->otp_web_cpu);
+			writel(1, &otp->otp_web_cpu);
+			writel(0, &otp->otp_cpumpen_cpu);
+			writel(0, &otp->otp_pgmen_cpu);
+			if (readl(&otp->otp_dat_cpu) == 0)
 				break;
 		}
-		if (otp->otp_dat_cpu & 0x01)
+		if (readl(&otp->otp_dat_cpu) & 0x01)
 			break;
 		data >>= 1;
 		addr++;
@@ -556,7 +561,7 @@ enum otp_status_t otp_soft_write(uint32_t addr, uint8_t *data_buf,
 		}
 		length--;
 	}
-	otp->otp_ceb_cpu = 1;
+	writel(1, &otp->otp_ceb_cpu);
 	if (length)
 		return OTP_ERROR_WRITE;
 	return OTP_OK;
@@ -565,27 +570,27 @@ enum otp_status_t otp_soft_write(uint32_t addr, uint8_t *data_buf,
 enum otp_status_t otp_soft_read(uint32_t addr, uint8_t *data_buf,
 				uint32_t length)
 {
-	otp->otp_ceb_cpu = 1;
-	otp->otp_dle_cpu = 0;
-	otp->otp_cle_cpu = 0;
-	otp->otp_pgmen_cpu = 0;
-	otp->otp_web_cpu = 1;
-	otp->otp_readen_cpu = 0;
-	otp->otp_rstb_cpu = 1;
-
-	otp->otp_ceb_cpu = 0;
-	otp->otp_rstb_cpu = 0;
-	otp->otp_rstb_cpu = 1;
+	writel(1, &otp->otp_ceb_cpu);
+	writel(0, &otp->otp_dle_cpu);
+	writel(0, &otp->otp_cle_cpu);
+	writel(0, &otp->otp_pgmen_cpu);
+	writel(1, &otp->otp_web_cpu);
+	writel(0, &otp->otp_readen_cpu);
+	writel(1, &otp->otp_rstb_cpu);
+
+	writel(0, &otp->otp_ceb_cpu);
+	writel(0, &otp->otp_rstb_cpu);
+	writel(1, &otp->otp_rstb_cpu);
 
 	while (length) {
-		otp->otp_adr_cpu = addr;
-		otp->otp_readen_cpu = 1;
-		*data_buf++ = otp->otp_dat_cpu;
-		otp->otp_readen_cpu = 0;
+		writel(addr, &otp->otp_adr_cpu);
+		writel(1, &otp->otp_readen_cpu);
+		*data_buf++ = readl(&otp->otp_dat_cpu);
+		writel(0, &otp->otp_readen_cpu);
 		addr += 8;
 		length--;
 	}
-	otp->otp_ceb_cpu = 1;
+	writel(1, &otp->otp_ceb_cpu);
 	if (length)
 		return OTP_ERROR_WRITE;
 	return OTP_OK;
@@ -593,5 +598,5 @@ enum otp_status_t otp_soft_read(uint32_t addr, uint8_t *data_buf,
 
 uint32_t otp_wrong_address_get(void)
 {
-	return otp->otp_pro_adr;
+	return readl(&otp->otp_pro_adr);
 }
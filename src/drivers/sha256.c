@@ -16,11 +16,14 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include "common.h"
 #include "encoding.h"
+#include "io.h"
 #include "sha256.h"
 #include "syscalls.h"
 #include "sysctl.h"
+#include "utils.h"
 
 volatile struct sha256_t *const sha256 RODATA =
 	(volatile struct sha256_t *)SHA256_BASE_ADDR;
@@ -52,19 +55,25 @@ int sha256_init(uint8_t dma_en, uint8_t double_sha_en, uint32_t input_size,
 {
 	sysctl_clock_enable(SYSCTL_CLOCK_SHA);
 	sysctl_reset(SYSCTL_RESET_SHA);
-	input_size = (input_size + 64) / 64;
-	if (dma_en)
-		sha256->sha_input_ctrl |= 1;
-	else
-		sha256->sha_input_ctrl &= !1;
+	// 1 unit is 64 bytes, padding adds 0x80 and the 8 bytes bit length
+	input_size = (input_size + 8 + 64) / 64;
+	if (dma_en) {
+		writel(readl(&sha256->sha_input_ctrl) | 1,
+		       &sha256->sha_input_ctrl);
+	} else {
+		writel(readl(&sha256->sha_input_ctrl) & !1,
+		       &sha256->sha_input_ctrl);
+	}
 	if (double_sha_en)
-		sha256->double_sha |= 1;
+		writel(readl(&sha256->double_sha) | 1, &sha256->double_sha);
 	//else
 	//	sha256->double_sha &= !1;
-	sha256->sha_data_num = input_size;
+	writel(input_size, &sha256->sha_data_num);
 
-	sha256->sha_status |= 1 << 16; //0 for little endian, 1 for big endian
-	sha256->sha_status |= 1; //enable sha256
+	//0 for little endian, 1 for big endian
+	writel(readl(&sha256->sha_status) | (1 << 16), &sha256->sha_status);
+	//enable sha256
+	writel(readl(&sha256->sha_status) | 1, &sha256->sha_status);
 
 	sc->totalLength = 0LL;
 	sc->hash[0] = 0x6a09e667L;
@@ -103,9 +112,11 @@ void sha256_update(SHA256Context *sc, const void *vdata, uint32_t len)
 
 		if (sc->bufferLength == 64L) {
 			for (i = 0; i < 16; i++) {
-				while (sha256->sha_input_ctrl & (1 << 8))
+				while (readl(&sha256->sha_input_ctrl) &
+				       (1 << 8))
 					;
-				sha256->sha_data_in1 = sc->buffer.words[i];
+				writel(sc->buffer.words[i],
+				       &sha256->sha_data_in1);
 			}
 			sc->bufferLength = 0L;
 		}
@@ -124,13 +135,55 @@ void sha256_final(SHA256Context *sc, uint8_t hash[SHA256_HASH_SIZE])
 	lengthPad = _BYTESWAP64(sc->totalLength);
 	sha256_update(sc, padding, bytesToPad);
 	sha256_update(sc, &lengthPad, 8L);
-	while (!(sha256->sha_status & 0x01))
+	while (!(readl(&sha256->sha_status) & 0x01))
 		;
 	if (hash) {
 		for (i = 0; i < SHA256_HASH_WORDS; i++) {
-			*((uint32_t *)hash) =
-				sha256->sha_result[SHA256_HASH_WORDS - i - 1];
+			*((uint32_t *)hash) = readl(
+				&sha256->sha_result[SHA256_HASH_WORDS - i - 1]);
 			hash += 4;
 		}
 	}
 }
+
+int hmac_sha256_init(HMACSHA256Context *hc, const uint8_t *key,
+		     uint32_t key_len, uint32_t input_size)
+{
+	uint8_t innerKey[HMAC_SHA256_BLOCK_SIZE];
+	int i;
+
+	if (key_len > HMAC_SHA256_BLOCK_SIZE)
+		return 0;
+
+	memset(innerKey, 0, sizeof(innerKey));
+	memcpy(innerKey, key, key_len);
+	for (i = 0; i < HMAC_SHA256_BLOCK_SIZE; i++) {
+		hc->outerKey[i] = innerKey[i] ^ 0x5c;
+		innerKey[i] ^= 0x36;
+	}
+
+	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA,
+		    HMAC_SHA256_BLOCK_SIZE + input_size, &hc->sha);
+	sha256_update(&hc->sha, innerKey, HMAC_SHA256_BLOCK_SIZE);
+	secure_zero(innerKey, sizeof(innerKey));
+	return 1;
+}
+
+void hmac_sha256_update(HMACSHA256Context *hc, const void *data, uint32_t len)
+{
+	sha256_update(&hc->sha, data, len);
+}
+
+void hmac_sha256_final(HMACSHA256Context *hc, uint8_t mac[SHA256_HASH_SIZE])
+{
+	uint8_t inner[SHA256_HASH_SIZE];
+
+	sha256_final(&hc->sha, inner);
+
+	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA,
+		    HMAC_SHA256_BLOCK_SIZE + SHA256_HASH_SIZE, &hc->sha);
+	sha256_update(&hc->sha, hc->outerKey, HMAC_SHA256_BLOCK_SIZE);
+	sha256_update(&hc->sha, inner, SHA256_HASH_SIZE);
+	sha256_final(&hc->sha, mac);
+	secure_zero(hc->outerKey, sizeof(hc->outerKey));
+}
@@ -18,6 +18,9 @@
 #include <stdio.h>
 #include "common.h"
 #include "encoding.h"
+#include "io.h"
+#include "plic.h"
+#include "sleep.h"
 #include "sysctl.h"
 #include "uarths.h"
 
@@ -27,26 +30,183 @@
 volatile struct uarths_t *const uarths RODATA =
 	(volatile struct uarths_t *)UARTHS_BASE_ADDR;
 
-static inline int uart_putc(char c)
+static uint32_t uart_baudrate = UARTHS_DEFAULT_BAUD;
+
+/*
+ * RX ring filled by the watermark interrupt, single producer (interrupt) and
+ * single consumer (uart_getc), indexes only ever grow and wrap naturally.
+ */
+static uint8_t uart_rx_ring[UARTHS_RX_RING_SIZE];
+static volatile uint32_t uart_rx_head, uart_rx_tail;
+static int uart_rx_irq_on;
+
+/*
+ * TX ring drained by the watermark interrupt, the other way round: core 0
+ * printing is the producer and the interrupt the consumer. Armed while the
+ * ring holds data, the interrupt disarms itself when it runs empty.
+ */
+static uint8_t uart_tx_ring[UARTHS_TX_RING_SIZE];
+static volatile uint32_t uart_tx_head, uart_tx_tail;
+static volatile int uart_tx_armed;
+static int uart_tx_irq_on;
+
+/* One handler serves both directions */
+static int uart_irq_on;
+
+/* Interrupt enables are set and cleared by both directions */
+static inline void uart_ie_set(uint32_t mask, int on)
 {
-	while (uarths->txdata.full)
+	uint32_t ie = readl(&uarths->ie);
+
+	writel(on ? ie | mask : ie & ~mask, &uarths->ie);
+}
+
+static inline int uart_fifo_putc(char c)
+{
+	while (readl(&uarths->txdata) & UARTHS_TXFIFO_FULL)
 		continue;
-	uarths->txdata.data = c;
+	writel((uint8_t)c, &uarths->txdata);
 	return 0;
 }
 
+/* Move the ring into the TX FIFO until either is exhausted, never waits */
+static void uart_tx_fill(void)
+{
+	uint32_t tail = uart_tx_tail;
+
+	while (tail != uart_tx_head &&
+	       !(readl(&uarths->txdata) & UARTHS_TXFIFO_FULL)) {
+		writel(uart_tx_ring[tail % UARTHS_TX_RING_SIZE],
+		       &uarths->txdata);
+		tail++;
+	}
+	uart_tx_tail = tail;
+	if (tail == uart_tx_head) {
+		uart_ie_set(UARTHS_IE_TXWM, 0);
+		uart_tx_armed = 0;
+	}
+}
+
+/* Empty the ring by polling, for when the interrupt cannot run */
+static void uart_tx_fill_all(void)
+{
+	while (uart_tx_tail != uart_tx_head)
+		uart_tx_fill();
+}
+
+static int uart_putc(char c)
+{
+	uint64_t mie;
+	uint32_t head;
+
+	/* Core 1 only prints around the jump, it keeps writing the FIFO */
+	if (!uart_tx_irq_on || current_coreid() != 0)
+		return uart_fifo_putc(c);
+
+	mie = read_csr(mstatus) & MSTATUS_MIE;
+	if (!mie) {
+		/* Trap or masked section, write through behind what is queued */
+		uart_tx_fill_all();
+		return uart_fifo_putc(c);
+	}
+
+	/*
+	 * Full: feed the FIFO from here as well, the interrupt may be held
+	 * off by a handler which prints.
+	 */
+	while (uart_tx_head - uart_tx_tail >= UARTHS_TX_RING_SIZE) {
+		clear_csr(mstatus, MSTATUS_MIE);
+		uart_tx_fill();
+		set_csr(mstatus, mie);
+	}
+
+	head = uart_tx_head;
+	uart_tx_ring[head % UARTHS_TX_RING_SIZE] = c;
+	/* the byte is stored before head moves */
+	asm volatile("" ::: "memory");
+	uart_tx_head = head + 1;
+
+	if (!uart_tx_armed) {
+		clear_csr(mstatus, MSTATUS_MIE);
+		uart_tx_armed = 1;
+		uart_ie_set(UARTHS_IE_TXWM, 1);
+		set_csr(mstatus, mie);
+	}
+	return 0;
+}
+
+/* Move the RX FIFO into the ring, bytes which do not fit are dropped */
+static void uart_rx_drain(void)
+{
+	uint32_t recv;
+	uint32_t head = uart_rx_head;
+
+	while (1) {
+		recv = readl(&uarths->rxdata);
+		if (recv & UARTHS_RXFIFO_EMPTY)
+			break;
+		if (head - uart_rx_tail >= UARTHS_RX_RING_SIZE)
+			continue;
+		uart_rx_ring[head % UARTHS_RX_RING_SIZE] =
+			recv & UARTHS_FIFO_DATA;
+		head++;
+	}
+	asm volatile("" ::: "memory");
+	uart_rx_head = head;
+}
+
+static int uart_irq(void *ctx)
+{
+	if (uart_rx_irq_on)
+		uart_rx_drain();
+	if (uart_tx_irq_on)
+		uart_tx_fill();
+	return 0;
+}
+
+/*
+ * The watermark leaves up to UARTHS_RX_IRQ_LEVEL bytes in the FIFO, pick them
+ * up when the ring runs empty. Masked so the interrupt cannot put newer bytes
+ * in the ring in between.
+ */
+static int uart_rx_ring_ready(void)
+{
+	uint64_t mie;
+
+	if (uart_rx_head != uart_rx_tail)
+		return 1;
+
+	mie = read_csr(mstatus) & MSTATUS_MIE;
+	clear_csr(mstatus, MSTATUS_MIE);
+	uart_rx_drain();
+	set_csr(mstatus, mie);
+
+	return uart_rx_head != uart_rx_tail;
+}
+
 int uart_getc(void)
 {
 	/* while not empty */
-	struct uarths_rxdata_t recv;
+	uint32_t recv;
+	int c;
+
+	if (uart_rx_irq_on) {
+		while (!uart_rx_ring_ready())
+			continue;
+		/* the byte was stored before head moved, read it after */
+		asm volatile("" ::: "memory");
+		c = uart_rx_ring[uart_rx_tail % UARTHS_RX_RING_SIZE];
+		uart_rx_tail++;
+		return c;
+	}
 
 	while (1) {
-		recv = uarths->rxdata;
-		if (!recv.empty)
+		recv = readl(&uarths->rxdata);
+		if (!(recv & UARTHS_RXFIFO_EMPTY))
 			break;
 	}
 
-	return recv.data;
+	return recv & UARTHS_FIFO_DATA;
 }
 
 int uart_putchar(char c)
@@ -64,25 +224,160 @@ int uart_puts(const char *s)
 
 int uart_init(void)
 {
-	uint16_t div = sysctl_clock_get_freq(SYSCTL_CLOCK_CPU) / 115200 - 1;
+	uint16_t div =
+		sysctl_clock_get_freq(SYSCTL_CLOCK_CPU) / UARTHS_DEFAULT_BAUD - 1;
 
 	/* Set UART registers */
-	uarths->div.div = div;
-	uarths->txctrl.txen = 1;
-	uarths->rxctrl.rxen = 1;
-	uarths->txctrl.txcnt = 0;
-	uarths->rxctrl.rxcnt = 0;
-	uarths->ip.txwm = 1;
-	uarths->ip.rxwm = 1;
-	uarths->ie.txwm = 0;
-	uarths->ie.rxwm = 1;
+	writel(UARTHS_DIV(div), &uarths->div);
+	writel(UARTHS_TXEN | UARTHS_TXWM(UARTHS_TX_IRQ_LEVEL), &uarths->txctrl);
+	writel(UARTHS_RXEN | UARTHS_RXWM(0), &uarths->rxctrl);
+	writel(UARTHS_IP_TXWM | UARTHS_IP_RXWM, &uarths->ip);
+	writel(UARTHS_IE_RXWM, &uarths->ie);
+	uart_baudrate = UARTHS_DEFAULT_BAUD;
 
 	return 0;
 }
 
+/* Bit time is div + 1 CPU clocks, 0 when out of range */
+static uint32_t uart_baud_div(uint32_t baud)
+{
+	uint32_t freq = sysctl_clock_get_freq(SYSCTL_CLOCK_CPU);
+	uint32_t div, real, err;
+
+	if (baud == 0)
+		return 0;
+	div = (freq + baud / 2) / baud;
+	if (div < 2 || div > 0x10000)
+		return 0;
+
+	real = freq / div;
+	err = real > baud ? real - baud : baud - real;
+	if ((uint64_t)err * 100 > (uint64_t)baud * UARTHS_BAUD_TOLERANCE)
+		return 0;
+	return div;
+}
+
+int uart_baudrate_valid(uint32_t baud)
+{
+	return uart_baud_div(baud) != 0;
+}
+
+int uart_set_baudrate(uint32_t baud)
+{
+	uint32_t div = uart_baud_div(baud);
+
+	if (!div)
+		return -1;
+
+	console_flush(UARTHS_FLUSH_TIMEOUT);
+	writel(UARTHS_DIV(div - 1), &uarths->div);
+	uart_baudrate = baud;
+	return 0;
+}
+
+uint32_t uart_get_baudrate(void)
+{
+	return uart_baudrate;
+}
+
 int uart_tstc(void)
 {
-	return uarths->ip.rxwm;
+	if (uart_rx_irq_on)
+		return uart_rx_ring_ready();
+	return !!(readl(&uarths->ip) & UARTHS_IP_RXWM);
+}
+
+static void uart_irq_attach(void)
+{
+	if (uart_irq_on)
+		return;
+
+	plic_init();
+	plic_set_priority(IRQN_UARTHS_INTERRUPT, 1);
+	plic_irq_register(IRQN_UARTHS_INTERRUPT, uart_irq, NULL);
+	uart_irq_on = 1;
+	plic_irq_enable(IRQN_UARTHS_INTERRUPT);
+	sysctl_enable_irq();
+}
+
+int uart_rx_irq_enable(void)
+{
+	if (uart_rx_irq_on)
+		return 0;
+
+	uart_rx_head = uart_rx_tail = 0;
+	uart_rx_irq_on = 1;
+	writel(UARTHS_RXEN | UARTHS_RXWM(UARTHS_RX_IRQ_LEVEL), &uarths->rxctrl);
+	uart_ie_set(UARTHS_IE_RXWM, 1);
+	uart_irq_attach();
+
+	return 0;
+}
+
+int uart_tx_irq_enable(void)
+{
+	if (uart_tx_irq_on)
+		return 0;
+
+	uart_tx_head = uart_tx_tail = 0;
+	uart_tx_armed = 0;
+	writel(UARTHS_TXEN | UARTHS_TXWM(UARTHS_TX_IRQ_LEVEL), &uarths->txctrl);
+	uart_tx_irq_on = 1;
+	uart_irq_attach();
+
+	return 0;
+}
+
+void uart_irq_disable(void)
+{
+	if (!uart_irq_on)
+		return;
+
+	sysctl_disable_irq();
+	plic_irq_disable(IRQN_UARTHS_INTERRUPT);
+	plic_irq_unregister(IRQN_UARTHS_INTERRUPT);
+	uart_ie_set(UARTHS_IE_TXWM, 0);
+	writel(UARTHS_RXEN | UARTHS_RXWM(0), &uarths->rxctrl);
+	/* what is still queued goes out polled */
+	uart_tx_fill_all();
+	uart_tx_armed = 0;
+	uart_tx_irq_on = 0;
+	uart_rx_irq_on = 0;
+	uart_irq_on = 0;
+}
+
+int console_flush(uint32_t timeout_ms)
+{
+	uint64_t start = read_cycle();
+	uint64_t limit = (uint64_t)timeout_ms *
+			 (sysctl_clock_get_freq(SYSCTL_CLOCK_CPU) / 1000);
+
+	/* txwm is pending once the FIFO is below UARTHS_TX_IRQ_LEVEL entries */
+	while (uart_tx_head != uart_tx_tail ||
+	       !(readl(&uarths->ip) & UARTHS_IP_TXWM)) {
+		if (read_cycle() - start >= limit)
+			return -1;
+		if (uart_tx_irq_on && current_coreid() == 0 &&
+		    !(read_csr(mstatus) & MSTATUS_MIE))
+			uart_tx_fill();
+	}
+	/* and let those and the shift register finish */
+	usleep((UARTHS_TX_IRQ_LEVEL + 1) * 10 * 1000000 / uart_baudrate + 1);
+
+	return 0;
+}
+
+int uart_getc_timeout(uint32_t timeout_ms)
+{
+	uint64_t start = read_cycle();
+	uint64_t limit = (uint64_t)timeout_ms *
+			 (sysctl_clock_get_freq(SYSCTL_CLOCK_CPU) / 1000);
+
+	while (!uart_tstc()) {
+		if (read_cycle() - start >= limit)
+			return -1;
+	}
+	return uart_getc();
 }
 
 int uart_ctrlc(void)
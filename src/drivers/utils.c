@@ -44,3 +44,11 @@ uint32_t get_gpio_bit(volatile uint32_t *bits, size_t offset)
 {
 	return get_bit(bits, 1, offset);
 }
+
+void secure_zero(void *buf, size_t len)
+{
+	volatile uint8_t *p = (volatile uint8_t *)buf;
+
+	while (len--)
+		*p++ = 0;
+}
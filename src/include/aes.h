@@ -108,6 +108,39 @@ int aes_process(uint8_t *aes_in_data, uint8_t *aes_out_data, uint32_t data_size,
 		enum aes_cipher_mod cipher_mod);
 int check_tag(uint32_t *aes_gcm_tag);
 
+/* Pass as key to aes_session_open() to decipher with the OTP AES key */
+#define AES_SESSION_OTP_KEY NULL
+
+/**
+ * @brief      AES-128-CBC decipher session
+ *
+ *             The engine clock and reset are done once in open, then any
+ *             number of regions are deciphered back to back. OTP key output
+ *             is only enabled while a region is processed, and close resets
+ *             the engine and wipes the key and chaining value.
+ */
+struct aes_session {
+	uint8_t key[16];
+	/* IV of the next region, last cipher block of the previous one */
+	uint8_t iv[16];
+	uint8_t otp_key;
+	uint8_t opened;
+};
+
+void aes_session_open(struct aes_session *session, const uint8_t *key);
+/**
+ * @brief      Decipher len bytes, in may be equal to out
+ *
+ * @param[in]  iv    IV starting a new region, NULL to chain on the previous
+ *                   region as if both were one
+ *
+ * @return     0 on success, -1 if session is closed or len is not a multiple
+ *             of 16
+ */
+int aes_session_decrypt(struct aes_session *session, uint8_t *in, uint8_t *out,
+			uint32_t len, const uint8_t *iv);
+void aes_session_close(struct aes_session *session);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_BENCH_H_
+#define __INCLUDE_BENCH_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest buffer size measured, in bytes */
+#define BENCH_MAX_SIZE (32 * 1024)
+/* Scratch RAM needed by bench_run(): source, destination and misalignment */
+#define BENCH_BUF_SIZE (2 * (BENCH_MAX_SIZE + 64))
+
+/**
+ * @brief      Measure throughput and per call cost of the primitives used by
+ *             flash_image_check(): SHA256 engine, software SHA256, AES
+ *             engine, crc_16(), memcpy() and flash read.
+ *
+ *             Results are printed one per line as
+ *             bench,<name>,<size>,<align>,<calls>,<cycles>,<cycles/call>,<KB/s>
+ *             where cycles count the clock printed in the "# clock" line.
+ *
+ * @param[in]  buf   Scratch RAM of BENCH_BUF_SIZE bytes
+ * @param[in]  name  Only run this primitive, NULL for all of them
+ *
+ * @return     0 on success, 1 when a cross check fails or name is unknown
+ */
+int bench_run(uint8_t *buf, const char *name);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_BENCH_H_ */
@@ -19,6 +19,7 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include "crc.h"
 #include "printf.h"
 
 #ifdef __cplusplus
@@ -30,12 +31,33 @@ extern "C" {
 #define CONFIG_SYS_MAXARGS	8
 #define CONFIG_SYS_PROMPT	"=> "
 /* clang-format on */
+#ifndef CONFIG_CLI_IDLE_TIMEOUT
+/* Milliseconds without a byte before the CLI and machine mode give up */
+#define CONFIG_CLI_IDLE_TIMEOUT	60000
+#endif
 
+/* Run commands, returns once the input stayed idle CONFIG_CLI_IDLE_TIMEOUT */
 void cli_simple_loop(void);
 void cmd_init(void);
 int cmd_process(int argc, char *const argv[]);
-uint16_t crc_16(const unsigned char *input_str, size_t num_bytes);
 ulong load_serial_bin(ulong offset);
+/* Move UARTHS to another rate, see utils/loadx.py for the host side */
+int baud_switch(uint32_t baud);
+/*
+ * SHA256 of a flash range on the SHA256 engine, after flash_init(), -1 if
+ * the flash could not be read
+ */
+int flash_sha256(uint32_t floffset, uint32_t length, uint8_t *digest);
+/*
+ * Print "flsha,<name>,<floffset>,<length>,<sha256>,<ms>" for a range, -1
+ * and an error line instead if it could not be read
+ */
+int flash_sha256_print(const char *name, uint32_t floffset, uint32_t length);
+/*
+ * Same for a partition of the flash map, or all of them, -1 if unknown and
+ * 1 if one could not be read
+ */
+int flash_sha256_map(const char *name);
 
 #ifdef __cplusplus
 }
@@ -24,6 +24,7 @@
 #include "gpiohs.h"
 #include "sleep.h"
 #include "printf.h"
+#include "tlog.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,7 +52,10 @@ extern "C" {
 /* Clear unused warnings for actually unused variables */
 #define UNUSED(x)		(void)(x)
 
-#ifdef DEBUG
+#if defined CONFIG_TLOG
+/* Kept in any build type, they only cost a few stores */
+#define debug_parser(...)	TLOG(__VA_ARGS__)
+#elif defined DEBUG
 #define debug_parser(...)	printk(__VA_ARGS__)
 #else
 #define debug_parser(...)
@@ -72,6 +76,9 @@ extern "C" {
 
 #define EXIT_REASON_SHA256OTP	(23)
 #define EXIT_REASON_SHA256FLASH	(24)
+#define EXIT_REASON_SIGNATURE	(25)
+#define EXIT_REASON_CIPHER	(26)
+#define EXIT_REASON_MAC		(27)
 #define EXIT_REASON_OVERSIZE	(233)
 
 #define EXIT_REASON_NOFLASH	(234)
@@ -81,7 +88,20 @@ extern "C" {
 /* clang-format on */
 
 extern void __attribute__((noreturn)) safe_main(void);
+#ifdef CONFIG_HOST_SIM
+/* Host build: SRAM is mapped where ld/maixloader.ld puts _boot */
+#ifdef LOADER_STAGE1
+#define _boot ((void (*)(void))0x80500000UL)
+#else
+#define _boot ((void (*)(void))0x80000000UL)
+#endif
+/* jumping to the next stage ends the run */
+extern void __attribute__((noreturn)) sim_boot(void);
+/* end of a boot phase, timed in simulated time */
+extern void sim_boot_phase(const char *name);
+#else
 extern void __attribute__((noreturn)) _boot(void);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_CRC_H_
+#define __INCLUDE_CRC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The speed profile folds eight bytes per step with 8 tables of 256 entries,
+ * 12K of .rodata for both CRCs. Otherwise they go byte by byte with one
+ * table each, 1.5K.
+ */
+#ifdef CONFIG_CRC_SLICE_BY_8
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "slicing-by-8 CRC tables assume a little endian CPU"
+#endif
+#define CRC_TABLES 8
+#else
+#define CRC_TABLES 1
+#endif
+
+/* CRC16/ARC as used by loadb, 0xBB3D for "123456789" */
+#define CRC_START_16 0x0000
+/* CRC-32C, 0xE3069283 for "123456789" */
+#define CRC_START_32C 0x00000000
+
+uint16_t crc_16(const unsigned char *input_str, size_t num_bytes);
+
+/**
+ * @brief      Incremental CRCs, feed the returned value back in with the next
+ *             chunk. Starting with CRC_START_* and feeding the whole buffer
+ *             in one call gives the same result.
+ */
+uint16_t crc16_update(uint16_t crc, const void *data, size_t num_bytes);
+uint32_t crc32c_update(uint32_t crc, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_CRC_H_ */
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __INCLUDE_ED25519_H_
+#define __INCLUDE_ED25519_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ED25519_PUBKEY_SIZE 32
+#define ED25519_SIGNATURE_SIZE 64
+
+/**
+ * @brief       Check an Ed25519 (RFC 8032) signature
+ *
+ * Variable time, only public data goes through it.
+ *
+ * @param[in]   signature       R || S, 64 bytes
+ * @param[in]   message         signed message
+ * @param[in]   message_len     length of message
+ * @param[in]   public_key      32 bytes compressed public key
+ *
+ * @return      0 if the signature is valid, -1 otherwise
+ */
+int ed25519_verify(const uint8_t signature[ED25519_SIGNATURE_SIZE],
+		   const uint8_t *message, size_t message_len,
+		   const uint8_t public_key[ED25519_PUBKEY_SIZE]);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_ED25519_H_ */
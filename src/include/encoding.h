@@ -252,6 +252,37 @@ extern "C" {
 
 #endif /* __ASSEMBLER__ */
 
+#elif defined(CONFIG_HOST_SIM) && !defined(__ASSEMBLER__)
+
+/*
+ * Host build: one hart whose CSRs are variables in host/sim_cpu.c, mcycle
+ * and mtime follow the host clock. Every access is a read, then the bits in
+ * clear are cleared and those in set are set, the old value is returned.
+ */
+enum sim_csr {
+	sim_csr_mstatus,
+	sim_csr_mie,
+	sim_csr_mip,
+	sim_csr_mhartid,
+	sim_csr_mcycle,
+	sim_csr_minstret,
+	sim_csr_mtime,
+	sim_csr_count
+};
+
+unsigned long sim_csr_access(enum sim_csr csr, unsigned long set,
+			     unsigned long clear);
+
+#define read_csr(reg) sim_csr_access(sim_csr_##reg, 0, 0)
+#define write_csr(reg, val) sim_csr_access(sim_csr_##reg, (val), ~0UL)
+#define swap_csr(reg, val) sim_csr_access(sim_csr_##reg, (val), ~0UL)
+#define set_csr(reg, bit) sim_csr_access(sim_csr_##reg, (bit), 0)
+#define clear_csr(reg, bit) sim_csr_access(sim_csr_##reg, 0, (bit))
+
+#define read_time() read_csr(mtime)
+#define read_cycle() read_csr(mcycle)
+#define current_coreid() read_csr(mhartid)
+
 #endif /* __riscv */
 
 /* clang-format off */
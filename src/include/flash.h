@@ -27,12 +27,23 @@
 extern "C" {
 #endif
 
+/* The 16MB GD25LQ128 of the board, bound of every flash range checked */
+#define FLASH_CHIP_SIZE (16 * 1024 * 1024)
+/* Largest program command, bytes the SPI FIFO takes in one go */
+#define FLASH_PROGRAM_CHUNK 32
+/*
+ * Bytes of one flash_read_bulk() transaction: a few us of quad reading with
+ * interrupts masked, shorter than the UART FIFOs last at 4.5 Mbaud
+ */
+#define FLASH_READ_BULK 256
+
 /**
  * @brief      flash operating status enumerate
  */
 enum flash_status_t {
 	FLASH_OK = 0,
 	FLASH_BUSY,
+	FLASH_ERROR,
 };
 
 /**
@@ -55,6 +66,15 @@ enum flash_status_t flash_disable_quad_mode(void);
 enum flash_status_t flash_sector_erase(uint32_t addr);
 enum flash_status_t flash_32k_block_erase(uint32_t addr);
 enum flash_status_t flash_64k_block_erase(uint32_t addr);
+/*
+ * Issue an erase or a program and return while the flash is busy, the next
+ * command must wait until flash_is_busy() returns FLASH_OK. A program covers
+ * at most FLASH_PROGRAM_CHUNK bytes within one 256 bytes page.
+ */
+enum flash_status_t flash_sector_erase_start(uint32_t addr);
+enum flash_status_t flash_64k_block_erase_start(uint32_t addr);
+enum flash_status_t flash_program_start(uint32_t addr, uint8_t *data_buf,
+					uint32_t length);
 enum flash_status_t flash_read_status_reg1(uint8_t *reg_data);
 enum flash_status_t flash_read_status_reg2(uint8_t *reg_data);
 enum flash_status_t flash_write_status_reg(uint8_t reg1_data,
@@ -64,6 +84,12 @@ enum flash_status_t flash_write_data(uint32_t addr, uint8_t *data_buf,
 				     uint32_t length);
 enum flash_status_t flash_read_data(uint32_t addr, uint8_t *data_buf,
 				    uint32_t length, enum flash_read_t mode);
+/*
+ * Quad read in FLASH_READ_BULK transactions instead of FIFO sized ones, a
+ * transaction the CPU could not drain in time is read again the slow way
+ */
+enum flash_status_t flash_read_bulk(uint32_t addr, uint8_t *data_buf,
+				    uint32_t length);
 enum flash_status_t flash_disable_protect(void);
 int do_flash_erase(uint32_t offset, uint32_t length);
 int do_flash_write(uint32_t offset, uint32_t length, uint8_t *ramptr);
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_FLASH_MAP_H_
+#define __INCLUDE_FLASH_MAP_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Slot copy journals of stage 1 and 2 (journal.h), after the 6MB of images */
+#define FLASH_JOURNAL_OFFSET 0x600000
+#define FLASH_JOURNAL_SIZE (8 * 1024)
+
+/* One partition of the flash map of the README */
+struct flash_part {
+	const char *name;
+	uint32_t offset;
+	uint32_t length;
+};
+
+/* In flash order, utils/flashmap.py holds the same table */
+extern const struct flash_part flash_map[];
+extern const uint32_t flash_map_parts;
+
+/**
+ * @brief      Partition called name
+ *
+ * @return     The partition, NULL when the map has none of that name
+ */
+const struct flash_part *flash_map_find(const char *name);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_FLASH_MAP_H_ */
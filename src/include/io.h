@@ -23,6 +23,24 @@
 extern "C" {
 #endif
 
+#ifdef CONFIG_HOST_SIM
+/*
+ * Host build: peripheral registers are software models, every access goes
+ * through the register model dispatcher in host/sim_mmio.c.
+ */
+uint64_t sim_mmio_read(uintptr_t addr, int size);
+void sim_mmio_write(uintptr_t addr, uint64_t value, int size);
+
+#define readb(addr) ((uint8_t)sim_mmio_read((uintptr_t)(addr), 1))
+#define readw(addr) ((uint16_t)sim_mmio_read((uintptr_t)(addr), 2))
+#define readl(addr) ((uint32_t)sim_mmio_read((uintptr_t)(addr), 4))
+#define readq(addr) ((uint64_t)sim_mmio_read((uintptr_t)(addr), 8))
+
+#define writeb(v, addr) sim_mmio_write((uintptr_t)(addr), (uint8_t)(v), 1)
+#define writew(v, addr) sim_mmio_write((uintptr_t)(addr), (uint16_t)(v), 2)
+#define writel(v, addr) sim_mmio_write((uintptr_t)(addr), (uint32_t)(v), 4)
+#define writeq(v, addr) sim_mmio_write((uintptr_t)(addr), (uint64_t)(v), 8)
+#else
 #define readb(addr) (*(volatile uint8_t *)(addr))
 #define readw(addr) (*(volatile uint16_t *)(addr))
 #define readl(addr) (*(volatile uint32_t *)(addr))
@@ -44,6 +62,7 @@ extern "C" {
 	{                                                                      \
 		(*(volatile uint64_t *)(addr)) = (v);                          \
 	}
+#endif /* CONFIG_HOST_SIM */
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_JOURNAL_H_
+#define __INCLUDE_JOURNAL_H_
+
+#include <stdint.h>
+#include "flash_map.h"
+#include "sha256.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Journal of a slot copy, one 4 KB sector of the "journal" partition per
+ * loader stage. Each stage writes its copy of one slot over the other here
+ * before the first destination sector is erased. Stage 2 leaves the copy
+ * of application slots pending, and the application runs it sector by
+ * sector through the service table (svc.h) when it has time.
+ *
+ *   0x00  struct journal_entry, programmed once
+ *   0x40  one bit per destination sector, cleared once it is written and
+ *         read back
+ *   0x60  one bit cleared per boot which found the copy pending
+ *
+ * Bits are only ever cleared, so the sector is erased once per copy, when
+ * it is complete. A power loss costs at most the sector being copied, the
+ * next step starts again from the first bit still set. An erase or bit
+ * clear cut short can only leave bits set, a sector already done is then
+ * copied again, and an entry cut short fails its CRC and is written anew.
+ * Before each step the image digest at src + hash_offset must still be the
+ * recorded one, else the source changed and the copy is dropped.
+ */
+#define JOURNAL_BASE FLASH_JOURNAL_OFFSET
+#define JOURNAL_SECTOR (4 * 1024)
+#define JOURNAL_ADDR(stage) (JOURNAL_BASE + ((stage)-1) * JOURNAL_SECTOR)
+
+#define JOURNAL_MAGIC 0x4c4e4a4bU /* "KJNL" */
+#define JOURNAL_OP_COPY 1
+#define JOURNAL_MAX_SECTORS 256
+#define JOURNAL_BITMAP_OFFSET 0x40
+#define JOURNAL_BOOTS_OFFSET 0x60
+
+/* Boots an application gets to complete the copy before the loader does */
+#define JOURNAL_DEFER_BOOTS 3
+
+struct journal_entry {
+	uint32_t magic;
+	uint32_t op;
+	uint32_t src;
+	uint32_t dst;
+	/* bytes, rounded up to whole destination sectors */
+	uint32_t length;
+	uint32_t hash_offset;
+	uint8_t digest[SHA256_HASH_SIZE];
+	uint32_t reserved;
+	/* CRC-32C of the fields above */
+	uint32_t crc;
+};
+
+/**
+ * @brief      Record the copy of length bytes from src to dst, keeping the
+ *             progress of the same copy when it is already pending
+ *
+ * @return     0 on success, -1 when length is over JOURNAL_MAX_SECTORS
+ */
+int journal_begin(uint32_t journal, uint32_t src, uint32_t dst,
+		  uint32_t length, uint32_t hash_offset);
+
+/**
+ * @brief      Count a boot with the copy pending
+ *
+ * @return     Boots counted so far with this one, 0 when nothing is pending
+ */
+int journal_boot(uint32_t journal);
+
+/**
+ * @brief      Copy up to sectors sectors of the pending copy, 0 only tells
+ *             what is left. The journal is erased once the copy is done.
+ *
+ * @return     Sectors left, 0 when nothing is pending, -1 when the source
+ *             changed and the copy was dropped, or a sector could not be
+ *             read or did not read back
+ */
+int journal_step(uint32_t journal, uint32_t sectors);
+
+/* Drop a copy left in the journal, slots are in sync without it */
+void journal_cancel(uint32_t journal);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_JOURNAL_H_ */
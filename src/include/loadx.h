@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_LOADX_H_
+#define __INCLUDE_LOADX_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * loadx frame, both directions, little endian, no byte escaping:
+ *
+ *   'L' 'X' | type(1) | flags(1) | offset(4) | len(2) | payload | crc(4)
+ *
+ * crc is CRC-32C over type..payload. The host keeps up to a window of DATA
+ * frames in flight, each acknowledged on its own by offset, and resends only
+ * the frames whose ACK is missing. Corrupted frames are dropped silently.
+ */
+/* clang-format off */
+#define LOADX_SYNC0		'L'
+#define LOADX_SYNC1		'X'
+#define LOADX_HDR_LEN		10
+#define LOADX_CRC_LEN		4
+
+/* Largest DATA payload accepted, hosts use 4096 by default */
+#define LOADX_FRAME_MAX		8192
+/* Frames the host may keep in flight, reported in the START ACK */
+#define LOADX_WINDOW		16
+
+/* host -> loader */
+#define LOADX_START		'S'	/* offset = total size */
+#define LOADX_DATA		'D'	/* offset = position in the image */
+#define LOADX_END		'E'	/* offset = total size, payload = CRC */
+#define LOADX_CANCEL		'C'
+/* loader -> host, offset echoes the frame answered */
+#define LOADX_ACK		'A'
+#define LOADX_NAK		'N'
+
+#define LOADX_ERROR		(~0UL)
+
+/* loadx_poll() results besides 1 (frame) and 0 (need more bytes) */
+#define LOADX_DROPPED		(-2)	/* bad CRC, oversized or cut short */
+#define LOADX_ABORTED		(-3)	/* ^C between frames */
+/* clang-format on */
+
+/* A received frame, payload points into a static buffer */
+struct loadx_frame {
+	uint8_t type;
+	uint8_t flags;
+	uint32_t offset;
+	uint16_t len;
+	const uint8_t *payload;
+};
+
+/* Receive state kept between loadx_poll() calls, start zeroed */
+struct loadx_rx {
+	uint32_t have; /* bytes of the current frame in the buffer */
+	uint64_t last; /* loadx_clock() of its last byte */
+};
+
+/*
+ * Where received data goes. write() may return 1 when it cannot take the
+ * frame yet, it is offered again after work() ran; the ACK is held back
+ * meanwhile, which paces the host. 0 accepts, -1 refuses with a NAK.
+ */
+struct loadx_sink {
+	uint16_t frame_max; /* reported to the host in the START ACK */
+	uint16_t window;
+	int (*start)(void *ctx, uint32_t total);
+	int (*write)(void *ctx, uint32_t offset, const uint8_t *data,
+		     uint32_t len);
+	/* background work between frames, may be NULL */
+	void (*work)(void *ctx);
+	/* complete the image and return its CRC-32C */
+	uint32_t (*finish)(void *ctx, uint32_t total);
+};
+
+/**
+ * @brief      Consume what the UART has without waiting.
+ *
+ * @note       Text and broken frames in front of a frame are skipped. The
+ *             payload stays valid until the next call.
+ *
+ * @param[in]  ctrlc  Return LOADX_ABORTED on ^C between frames
+ *
+ * @return     1 once a frame passed its CRC, 0 when more bytes are needed,
+ *             LOADX_DROPPED or LOADX_ABORTED
+ */
+int loadx_poll(struct loadx_rx *rx, struct loadx_frame *f, int ctrlc);
+
+/**
+ * @brief      Send one frame, the CRC is added here
+ */
+void loadx_frame_send(uint8_t type, uint8_t flags, uint32_t offset,
+		      const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief      The host repeats END until it sees our ACK, keep answering it
+ *             with an ACK for LOADX_LINGER ms after the first one
+ */
+void loadx_linger(struct loadx_rx *rx, uint32_t total);
+
+/**
+ * @brief      Time base of the protocol timeouts
+ *
+ * @return     Ticks, loadx_ticks_per_ms() per millisecond
+ */
+uint64_t loadx_clock(void);
+uint64_t loadx_ticks_per_ms(void);
+
+/**
+ * @brief      Run the loadx protocol until END, CANCEL or a timeout.
+ *
+ * @return     Image size, or LOADX_ERROR
+ */
+unsigned long loadx_receive(const struct loadx_sink *sink, void *ctx);
+
+/**
+ * @brief      Receive an image with the loadx protocol (utils/loadx.py).
+ *
+ * @param[in]  addr    RAM address the image is written to
+ * @param[in]  maxlen  Largest image accepted, in bytes
+ *
+ * @return     Image size, or LOADX_ERROR on cancel, timeout or CRC mismatch
+ */
+unsigned long load_serial_x(unsigned long addr, unsigned long maxlen);
+
+/**
+ * @brief      Receive an image with the loadx protocol straight into flash.
+ *             Sectors are erased ahead of the data, and frames are taken in
+ *             while the previous 32 KB is programmed. END is only ACKed when
+ *             the CRC-32C of the flash content read back matches.
+ *
+ * @param[in]  floffset  Flash offset, aligned to a 4 KB sector
+ *
+ * @return     Image size, or LOADX_ERROR
+ */
+unsigned long flash_serial_x(uint32_t floffset);
+
+/**
+ * @brief      Send a flash range to the host (utils/fldumpb.py): DATA frames
+ *             streamed without ACKs, then END with the SHA256 of the range.
+ *             Frames the host missed are sent again when it asks by offset.
+ *
+ * @param[out] digest  SHA256 of the range, SHA256_HASH_SIZE bytes
+ *
+ * @return     0 once the host confirmed, -1 on cancel or timeout
+ */
+int flash_serial_dump(uint32_t floffset, uint32_t length, uint8_t *digest);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_LOADX_H_ */
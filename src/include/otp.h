@@ -31,6 +31,12 @@ extern "C" {
 #define OTP_WIRED_REG_ADDR	0x00003FE0// 0x0001FF00(bit)
 #define OTP_AES_KEY_ADDR	0x00003FF0// 0x0001FF80(bit)
 
+/* SHA256 of the secure boot Ed25519 public key, end of common data */
+#define OTP_BOOT_PUBKEY_HASH_ADDR	0x00003AB0// 0x0001D580(bit)
+/* HMAC-SHA256 key of image digests, right before the public key hash */
+#define OTP_IMAGE_MAC_KEY_ADDR		0x00003A90// 0x0001D480(bit)
+#define OTP_IMAGE_MAC_KEY_SIZE		32
+
 #define OTP_BUSY_FLAG		0x00000001
 #define OTP_BYPASS_FLAG		0x00000002
 #define OTP_TEST_FLAG		0x00000004
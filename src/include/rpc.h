@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_RPC_H_
+#define __INCLUDE_RPC_H_
+
+#include "loadx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Machine mode for host tools (utils/rpc.py). RPC_MAGIC received at the CLI
+ * prompt drops the current line and switches to loadx frames (see loadx.h):
+ * the loader first sends an RPC_INFO answer, then serves one request at a
+ * time until RPC_QUIT or ^C between frames, or until no byte came for
+ * CONFIG_CLI_IDLE_TIMEOUT.
+ *
+ * A request is a frame whose type is an RPC_* opcode. It is answered with
+ * exactly one LOADX_ACK or LOADX_NAK frame, flags = the opcode and offset
+ * echoed. A NAK carries a 4 bytes RPC_ERR_* code. Lost requests or answers
+ * are simply sent again by the host, every request can be repeated. Numbers
+ * are little endian.
+ */
+/* clang-format off */
+#define RPC_MAGIC		"\x16\x16\x10\x02" /* SYN SYN DLE STX */
+#define RPC_MAGIC_LEN		4
+/* The same as the last 4 bytes received, first one highest */
+#define RPC_MAGIC_WORD		0x16161002U
+#define RPC_VERSION		2
+
+/* Largest data in one request or answer */
+#define RPC_DATA_MAX		LOADX_FRAME_MAX
+/* Erase unit, and what RPC_FLASH_HASHES and RPC_FLASH_UPDATE work on */
+#define RPC_SECTOR		(4 * 1024)
+/* Leading bytes of a sector SHA256 sent back by RPC_FLASH_HASHES */
+#define RPC_SECTOR_HASH_LEN	16
+
+/* ACK: version(2) data max(2) baud(4) */
+#define RPC_INFO		'i'
+/* offset = flash offset, payload = length(4); ACK: data */
+#define RPC_FLASH_READ		'r'
+/* offset = flash offset, payload = data, the range must be erased */
+#define RPC_FLASH_WRITE		'w'
+/* offset = 4 KB aligned flash offset, payload = length(4) */
+#define RPC_FLASH_ERASE		'e'
+/* offset = flash offset, payload = length(4); ACK: SHA256(32) */
+#define RPC_FLASH_SHA256	'h'
+/*
+ * offset = RPC_SECTOR aligned flash offset, payload = length(4), at most
+ * RPC_DATA_MAX / RPC_SECTOR_HASH_LEN sectors; ACK: SHA256 of each sector,
+ * cut to RPC_SECTOR_HASH_LEN bytes. Since version 2.
+ */
+#define RPC_FLASH_HASHES	'H'
+/*
+ * offset = RPC_SECTOR aligned flash offset, payload = one sector: erase,
+ * program and read back. Since version 2.
+ */
+#define RPC_FLASH_UPDATE	'u'
+/*
+ * offset = RAM address, payload = length(4); ACK: data. RPC_MEM_* only
+ * reach the 64 KB stage 1 loads stage 2 to.
+ */
+#define RPC_MEM_READ		'R'
+/* offset = RAM address, payload = data */
+#define RPC_MEM_WRITE		'W'
+/* ACK, then the SoC resets */
+#define RPC_RESET		'x'
+/* ACK, then back to the text CLI */
+#define RPC_QUIT		'q'
+
+#define RPC_ERR_UNKNOWN		1	/* opcode not supported */
+#define RPC_ERR_ARGS		2	/* payload size or alignment */
+#define RPC_ERR_RANGE		3	/* outside the RAM window or flash */
+#define RPC_ERR_VERIFY		4	/* flash differs after programming */
+#define RPC_ERR_READ		5	/* flash could not be read */
+/* clang-format on */
+
+/**
+ * @brief      Serve requests until RPC_QUIT or ^C, the CLI calls it once it
+ *             saw RPC_MAGIC
+ *
+ * @return     0 back to the CLI, -1 when the host went idle
+ */
+int rpc_serve(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_RPC_H_ */
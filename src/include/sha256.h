@@ -69,6 +69,26 @@ int sha256_init(uint8_t dma_en, uint8_t double_sha_en, uint32_t input_size,
 void sha256_update(SHA256Context *sc, const void *data, uint32_t len);
 void sha256_final(SHA256Context *sc, uint8_t hash[SHA256_HASH_SIZE]);
 
+/**
+ * @brief      HMAC-SHA256 on the SHA256 engine. The inner hash streams the
+ *             message like sha256_update(), so a MAC only costs one more
+ *             block plus a two block outer hash.
+ */
+#define HMAC_SHA256_BLOCK_SIZE 64
+
+struct _HMACSHA256Context {
+	SHA256Context sha;
+	uint8_t outerKey[HMAC_SHA256_BLOCK_SIZE];
+};
+
+typedef struct _HMACSHA256Context HMACSHA256Context;
+
+/* key_len is at most HMAC_SHA256_BLOCK_SIZE, input_size as for sha256_init */
+int hmac_sha256_init(HMACSHA256Context *hc, const uint8_t *key,
+		     uint32_t key_len, uint32_t input_size);
+void hmac_sha256_update(HMACSHA256Context *hc, const void *data, uint32_t len);
+void hmac_sha256_final(HMACSHA256Context *hc, uint8_t mac[SHA256_HASH_SIZE]);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_SHA256_SOFT_H_
+#define __INCLUDE_SHA256_SOFT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHA256_SOFT_HASH_SIZE 32
+
+/**
+ * @brief      Software SHA-256, reference for the SHA256 engine in the
+ *             crypto benchmark and in the host register model.
+ */
+struct _SHA256SoftContext {
+	uint32_t hash[8];
+	uint64_t totalLength;
+	uint32_t bufferLength;
+	uint8_t buffer[64];
+};
+
+typedef struct _SHA256SoftContext SHA256SoftContext;
+
+void sha256_soft_transform(uint32_t hash[8], const uint8_t *block);
+void sha256_soft_init(SHA256SoftContext *sc);
+void sha256_soft_update(SHA256SoftContext *sc, const void *data, size_t len);
+void sha256_soft_final(SHA256SoftContext *sc,
+		       uint8_t hash[SHA256_SOFT_HASH_SIZE]);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_SHA256_SOFT_H_ */
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __INCLUDE_SHA512_H_
+#define __INCLUDE_SHA512_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHA512_HASH_SIZE 64
+
+/**
+ * @brief      Software SHA-512, there is no engine for it on K210. Only
+ *             used by the Ed25519 signature check.
+ */
+struct _SHA512Context {
+	uint64_t hash[8];
+	uint64_t totalLength;
+	uint32_t bufferLength;
+	uint8_t buffer[128];
+};
+
+typedef struct _SHA512Context SHA512Context;
+
+void sha512_init(SHA512Context *sc);
+void sha512_update(SHA512Context *sc, const void *data, size_t len);
+void sha512_final(SHA512Context *sc, uint8_t hash[SHA512_HASH_SIZE]);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_SHA512_H_ */
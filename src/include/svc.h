@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_SVC_H_
+#define __INCLUDE_SVC_H_
+
+#include <stdint.h>
+#include "aes.h"
+#include "flash_map.h"
+#include "sha256.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Loader services for the application. Before the jump to the application
+ * stage 2 stores the address of its struct svc_table at SVC_TABLE_PTR, a
+ * slot of the crt.S header of its own image, so the application can use
+ * the loader flash, SHA256 and AES drivers instead of linking and setting
+ * up its own:
+ *
+ *   const struct svc_table *svc = *(struct svc_table **)SVC_TABLE_PTR;
+ *
+ *   if (svc->magic == SVC_MAGIC && svc->version >= 1)
+ *           svc->flash_read(svc->partition("feature")->offset, buf, len);
+ *
+ * Only valid while the stage 2 RAM, SVC_RAM_BASE to SVC_RAM_END, is left alone:
+ * the application must not load, link or allocate anything there. Entries load
+ * the loader gp and tp around the call and run on the caller stack (2 KB is
+ * plenty), interrupts are kept as they are. Flash addresses are offsets in the
+ * SPI3 flash, the SHA256 and AES engines are used as the loader drivers do, one
+ * context at a time.
+ *
+ * New entries are only ever appended: version is bumped and size grows,
+ * an application checks version before using an entry newer than 1.
+ */
+#define SVC_TABLE_PTR 0x80500018UL
+#define SVC_RAM_BASE 0x80500000UL
+#define SVC_RAM_END 0x80580000UL
+
+#define SVC_MAGIC 0x4356534bU /* "KSVC" */
+#define SVC_VERSION 2
+
+/*
+ * Copy between the APP and BAK slots this boot found necessary. Stage 2
+ * leaves it to the application, sync_step() tells when it is pending.
+ */
+#define SVC_SYNC_NONE 0
+#define SVC_SYNC_APP_TO_BAK 1
+#define SVC_SYNC_BAK_TO_APP 2
+
+struct svc_boot_info {
+	/* loader stage which booted the application, 2 */
+	uint32_t stage;
+	/* flash offset of the image loaded at 0x80000000, APP or BAK */
+	uint32_t image_offset;
+	/*
+	 * payload length, header flag (bit 0 AES, 1 signed, 2 MAC) and
+	 * digest of that image
+	 */
+	uint32_t image_length;
+	uint8_t image_flag;
+	uint8_t sync;
+	uint8_t reserved[2];
+	uint8_t image_digest[SHA256_HASH_SIZE];
+	/* first check of each slot, 0 or -EXIT_REASON_* */
+	int32_t app_check;
+	int32_t bak_check;
+	/* cycle counter at the jump */
+	uint64_t boot_cycles;
+	/* BUILD_VERSION of stage 2, NUL terminated */
+	char build[16];
+};
+
+struct svc_table {
+	uint32_t magic;
+	uint16_t version;
+	/* sizeof(struct svc_table) of this loader */
+	uint16_t size;
+
+	/*
+	 * Flash, 0 or -1 when the range is off the flash or a read fails.
+	 * Erase works on the 4 KB sectors holding the range, in 64 KB blocks
+	 * where it can. Program does not erase.
+	 */
+	int (*flash_read)(uint32_t addr, uint8_t *buf, uint32_t len);
+	int (*flash_erase)(uint32_t addr, uint32_t len);
+	int (*flash_program)(uint32_t addr, const uint8_t *buf, uint32_t len);
+
+	/* SHA256 engine, total is the byte count of all updates */
+	int (*sha256_init)(SHA256Context *ctx, uint32_t total);
+	void (*sha256_update)(SHA256Context *ctx, const void *data,
+			      uint32_t len);
+	void (*sha256_final)(SHA256Context *ctx,
+			     uint8_t digest[SHA256_HASH_SIZE]);
+
+	/*
+	 * AES-128-CBC decipher session as aes.h has it. The OTP key stays
+	 * with the loader, open fails without a key.
+	 */
+	int (*aes_open)(struct aes_session *session, const uint8_t *key);
+	int (*aes_decrypt)(struct aes_session *session, uint8_t *in,
+			   uint8_t *out, uint32_t len, const uint8_t *iv);
+	void (*aes_close)(struct aes_session *session);
+
+	/* Flash map of the README, NULL for an unknown name */
+	const struct flash_part *(*partition)(const char *name);
+	const struct svc_boot_info *(*boot_info)(void);
+
+	/*
+	 * Version 2. Copy up to sectors 4 KB sectors of the pending slot
+	 * copy (journal.h), about 60 ms each, 0 only asks. Returns sectors
+	 * left, 0 once nothing is pending and -1 when the copy failed or was
+	 * dropped. Both slots must be left alone while it is pending, an
+	 * update has to finish it first.
+	 */
+	int (*sync_step)(uint32_t sectors);
+};
+
+/**
+ * @brief      Fill the boot info and publish the table at SVC_TABLE_PTR,
+ *             last thing before the jump to the application
+ *
+ * @param[in]  image_offset  Flash offset of the image loaded at _boot
+ * @param[in]  app_check     First flash_image_check() of APP
+ * @param[in]  bak_check     First flash_image_check() of BAK
+ * @param[in]  sync          SVC_SYNC_*
+ */
+void svc_publish(uint32_t image_offset, int app_check, int bak_check,
+		 int sync);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_SVC_H_ */
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include "printf.h"
 #include "encoding.h"
+#include "tlog.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -119,7 +120,9 @@ typedef enum _kendryte_log_level
 #define CONFIG_LOG_LEVEL LOG_LEVEL
 #endif
 
-#ifdef LOG_KERNEL
+#if defined CONFIG_TLOG
+#define LOG_PRINTF TLOG
+#elif defined LOG_KERNEL
 #define LOG_PRINTF printk
 #else
 #define LOG_PRINTF printf
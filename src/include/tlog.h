@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: Apache-2.0
+/* Copyright (C) 2013-2019 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __INCLUDE_TLOG_H_
+#define __INCLUDE_TLOG_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Tokenized log
+ *
+ * TLOG(format, ...) does not format anything on the target. The format
+ * string is kept in the "tlog_fmt" section, which the linker script marks
+ * INFO so it takes no room in the image, and a record of its offset, the
+ * cycle counter and up to TLOG_MAX_ARGS raw arguments goes into a RAM ring
+ * per core, overwriting the oldest records.
+ *
+ * The "tlog" command sends the rings over the UART and utils/tlog.py decodes
+ * them with the strings read back from the ELF:
+ *
+ *      python3 utils/tlog.py build/loader_stage1 /dev/ttyUSB0
+ *
+ * Arguments are stored as 64 bits words. "%s" records the pointer only, the
+ * decoder resolves it if it points into the ELF, so pass constant strings.
+ *
+ * Record layout, in 64 bits words:
+ *
+ *      TLOG_MAGIC << 48 | nargs << 32 | format offset
+ *      read_cycle()
+ *      argument 0 .. nargs - 1
+ */
+
+/* clang-format off */
+/* Ring size per core in 64 bits words, power of 2 */
+#define TLOG_RING_WORDS		(1024)
+#define TLOG_MAX_ARGS		(8)
+#define TLOG_MAGIC		(0x544CULL)
+/* clang-format on */
+
+extern const char __start_tlog_fmt[];
+
+#define TLOG_NARGS(...) TLOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define TLOG(format, ...)                                                      \
+	do {                                                                   \
+		static const char tlog_fmt_[]                                  \
+			__attribute__((section("tlog_fmt"), used)) = format;   \
+		tlog_write(tlog_fmt_ - __start_tlog_fmt,                       \
+			   TLOG_NARGS(__VA_ARGS__), ##__VA_ARGS__);            \
+	} while (0)
+
+/**
+ * @brief      Append a record to the ring of this core, use TLOG()
+ *
+ * @param[in]  id     Offset of the format string in the "tlog_fmt" section
+ * @param[in]  nargs  Number of arguments which follow, at most TLOG_MAX_ARGS
+ */
+void tlog_write(uint32_t id, unsigned int nargs, ...);
+
+/**
+ * @brief      Send both rings, oldest record first
+ *
+ * @note       Each ring goes out as a text line
+ *             "## Token log core <n>: <count> of <total> words", then count
+ *             little endian words and the CRC-32C of their bytes. total is
+ *             the number of words ever written, when it is larger than count
+ *             the first record was partly overwritten.
+ */
+void tlog_dump(void);
+
+/**
+ * @brief      Drop all records
+ */
+void tlog_clear(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __INCLUDE_TLOG_H_ */
@@ -65,6 +65,11 @@ extern "C" {
 #define UARTHS_REG_IP     (0x14)
 #define UARTHS_REG_DIV    (0x18)
 
+/* TXFIFO and RXFIFO registers */
+#define UARTHS_TXFIFO_FULL  (0x80000000)
+#define UARTHS_RXFIFO_EMPTY (0x80000000)
+#define UARTHS_FIFO_DATA    (0xff)
+
 /* TXCTRL register */
 #define UARTHS_TXEN       (0x01)
 #define UARTHS_TXWM(x)    (((x) & 0xffff) << 16)
@@ -76,6 +81,30 @@ extern "C" {
 /* IP register */
 #define UARTHS_IP_TXWM    (0x01)
 #define UARTHS_IP_RXWM    (0x02)
+
+/* IE register */
+#define UARTHS_IE_TXWM    (0x01)
+#define UARTHS_IE_RXWM    (0x02)
+
+/* DIV register */
+#define UARTHS_DIV(x)     ((x) & 0xffff)
+
+/* Rate set by uart_init() */
+#define UARTHS_DEFAULT_BAUD   (115200)
+/* Largest rate error uart_set_baudrate() accepts, in percent */
+#define UARTHS_BAUD_TOLERANCE (2)
+
+/* RX ring used with uart_rx_irq_enable(), a few loadx frames, power of 2 */
+#define UARTHS_RX_RING_SIZE   (16 * 1024)
+/* Interrupt once more than this many bytes wait in the 8 entries FIFO */
+#define UARTHS_RX_IRQ_LEVEL   (3)
+
+/* TX ring used with uart_tx_irq_enable(), power of 2 */
+#define UARTHS_TX_RING_SIZE   (4 * 1024)
+/* Interrupt once fewer than this many bytes are left in the TX FIFO */
+#define UARTHS_TX_IRQ_LEVEL   (4)
+/* Longest wait for the console before uart_set_baudrate() changes the rate */
+#define UARTHS_FLUSH_TIMEOUT  (1000)
 /* clang-format on */
 
 struct uarths_txdata_t {
@@ -200,6 +229,90 @@ int uart_getc(void);
  */
 int uart_tstc(void);
 
+/**
+ * @brief      Get a byte from UART, giving up after a while
+ *
+ * @param[in]  timeout_ms  Time to wait for the byte, in milliseconds
+ *
+ * @return     byte as int type from UART, -1 on timeout
+ */
+int uart_getc_timeout(uint32_t timeout_ms);
+
+/**
+ * @brief      Check if a rate can be set within UARTHS_BAUD_TOLERANCE
+ *
+ * @param[in]  baud  Rate in bits per second
+ *
+ * @return     1 if uart_set_baudrate() would accept it, 0 if not
+ */
+int uart_baudrate_valid(uint32_t baud);
+
+/**
+ * @brief      Change the rate, after the TX FIFO has drained
+ *
+ * @param[in]  baud  Rate in bits per second
+ *
+ * @return     result
+ *     - 0     Success
+ *     - Other Fail, rate not reachable and left unchanged
+ */
+int uart_set_baudrate(uint32_t baud);
+
+/**
+ * @brief      Get the rate requested by the last uart_set_baudrate()
+ *
+ * @return     Rate in bits per second
+ */
+uint32_t uart_get_baudrate(void);
+
+/**
+ * @brief      Receive through the RX watermark interrupt on this core
+ *
+ * @note       uart_getc() and uart_tstc() then read from a ring buffer of
+ *             UARTHS_RX_RING_SIZE bytes which is filled while the CPU erases,
+ *             programs or hashes, so the 8 bytes FIFO does not overrun at
+ *             high rates. Calls plic_init() and sets MSTATUS_MIE.
+ *
+ * @return     result
+ *     - 0     Success
+ *     - Other Fail
+ */
+int uart_rx_irq_enable(void);
+
+/**
+ * @brief      Transmit through the TX watermark interrupt on this core
+ *
+ * @note       uart_putchar() and uart_puts() on core 0 then only queue into a
+ *             ring buffer of UARTHS_TX_RING_SIZE bytes and return, the
+ *             interrupt refills the 8 bytes FIFO. Output from core 1, from
+ *             traps and with MSTATUS_MIE clear is written through in order.
+ *             Calls plic_init() and sets MSTATUS_MIE.
+ *
+ * @return     result
+ *     - 0     Success
+ *     - Other Fail
+ */
+int uart_tx_irq_enable(void);
+
+/**
+ * @brief      Go back to polling in both directions
+ *
+ * @note       Queued output is written out first, bytes left in the RX ring
+ *             are lost
+ */
+void uart_irq_disable(void);
+
+/**
+ * @brief      Wait until all output has left the UART
+ *
+ * @param[in]  timeout_ms  Longest wait, in milliseconds
+ *
+ * @return     result
+ *     - 0     Success, TX ring, FIFO and shift register are empty
+ *     - Other Timeout
+ */
+int console_flush(uint32_t timeout_ms);
+
 /**
  * @brief      check if CTRL+C is pressed from UART
  *
@@ -347,6 +347,17 @@ uint32_t get_bit(volatile uint32_t *bits, uint32_t mask, size_t offset);
  */
 uint32_t get_gpio_bit(volatile uint32_t *bits, size_t offset);
 
+/**
+ * @brief       Clear a buffer holding key material
+ *
+ * @note        The stores are volatile, so the compiler keeps them even
+ *              when the buffer is not read again, unlike a memset()
+ *
+ * @param[in]   buf         The buffer to clear
+ * @param[in]   len         Its length in bytes
+ */
+void secure_zero(void *buf, size_t len);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
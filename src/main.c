@@ -21,16 +21,21 @@
 #include "cli.h"
 #include "clint.h"
 #include "common.h"
+#include "ed25519.h"
 #include "encoding.h"
 #include "flash.h"
 #include "fpioa.h"
+#include "journal.h"
 #include "otp.h"
 #include "printf.h"
+#include "rpc.h"
 #include "sha256.h"
 #include "sleep.h"
+#include "svc.h"
 #include "syscalls.h"
 #include "sysctl.h"
 #include "uarths.h"
+#include "utils.h"
 
 #ifndef BUILD_VERSION
 #define BUILD_VERSION "unstable dev"
@@ -54,22 +59,86 @@
 #define FLASH_APP_ADDR (64 * 1024)
 #define FLASH_BAK_ADDR (2 * 64 * 1024)
 #define FLASH_NEXT_SIZE (64 * 1024) /* Loader Stage2 APP & BAK, both 64K */
+#define FLASH_JOURNAL_ADDR JOURNAL_ADDR(1)
 #else
 #define FLASH_APP_ADDR (3 * 64 * 1024)
 #define FLASH_BAK_ADDR ((3 * 64 + 320) * 1024)
 #define FLASH_NEXT_SIZE (320 * 1024) /* APP & BAK, both 320KB */
+#define FLASH_JOURNAL_ADDR JOURNAL_ADDR(2)
 #endif
 
 #define FLASH_SHA256_LEN 32
+/* Ed25519 public key + signature of the digest, after the digest */
+#define FLASH_SIGN_LEN (ED25519_PUBKEY_SIZE + ED25519_SIGNATURE_SIZE)
+
+/* Console drain before the jump, at most the old fixed print delay */
+#define BOOT_FLUSH_TIMEOUT 100
+/* Stage 1 RPC_MAGIC window, the wait for core 1 it replaces */
+#define BOOT_CLI_WINDOW 20
+
+/* Bits of the 1 byte image header flag */
+#define FIRMWARE_FLAG_AES (1U << 0)
+#define FIRMWARE_FLAG_SIGNED (1U << 1)
+#define FIRMWARE_FLAG_MAC (1U << 2)
+
+#define FLASH_TRAILER_LEN(flag)                                                \
+	(FLASH_SHA256_LEN + (((flag)&FIRMWARE_FLAG_SIGNED) ? FLASH_SIGN_LEN : 0))
 
 #ifdef DEBUG
 #warning "THIS IS A DEBUG BUILD, DO NOT USE IT IN PRODUCTION!!!"
 #endif
 
+/* End of a boot phase, name is a string literal */
+#ifdef CONFIG_HOST_SIM
+#define boot_phase(name) sim_boot_phase(name)
+#else
+#define boot_phase(name)                                                       \
+	debug_parser("[DEBUG] Boot phase " name " done at %lu cycles\n",      \
+		     read_cycle())
+#endif
+
+#if defined(LOADER_STAGE1) && defined(CONFIG_BOOT_CLI)
+/*
+ * The CLI, its serial commands and machine mode (rpc.h) are only reached
+ * from here, in builds with the BOOT_CLI option: the whole RPC_MAGIC
+ * received while stage 1 waits for core 1 stops the boot. Host tools keep
+ * sending it across the reset, the CLI then takes a following one as the
+ * switch to machine mode.
+ */
+static int boot_cli_magic(uint32_t window_ms)
+{
+	uint64_t start = read_cycle();
+	uint64_t limit = (uint64_t)window_ms *
+			 (sysctl_clock_get_freq(SYSCTL_CLOCK_CPU) / 1000);
+	uint32_t last = 0;
+
+	while (read_cycle() - start < limit) {
+		if (!uart_tstc())
+			continue;
+		last = last << 8 | (uart_getc() & 0xff);
+		if (last == RPC_MAGIC_WORD)
+			return 1;
+	}
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_HOST_SIM
+/* The host runs core 0 alone, the next stage is left in sim_boot_ram */
+static void go_boot(void)
+{
+	printk("Core %lX is jumping to 0x%lX now...\n", current_coreid(),
+	       (intptr_t)_boot);
+	console_flush(BOOT_FLUSH_TIMEOUT);
+	uart_irq_disable();
+	sim_boot();
+}
+#else
 /* Core 0 and Core 1 will call go_boot() almost the same time */
 static void go_boot(void)
 {
 	static int jump_flag = 0;
+	static volatile int flushed[2];
 
 	if (current_coreid() == 0) {
 		debug_parser("[DEBUG] Sending IPI.\n");
@@ -83,10 +152,15 @@ static void go_boot(void)
 	printk("Core %lX is jumping to 0x%lX now...\n", current_coreid(),
 	       (intptr_t)_boot);
 
-	/* Waiting for print ready */
-	msleep(100);
+	/* Waiting for print ready, neither core leaves while the other prints */
+	console_flush(BOOT_FLUSH_TIMEOUT);
+	flushed[current_coreid()] = 1;
+	while (!flushed[0] || !flushed[1])
+		continue;
 
-	/* Disable Interrupt */
+	/* Disable Interrupt, the UART one was registered on core 0 */
+	if (current_coreid() == 0)
+		uart_irq_disable();
 	asm volatile("csrw mideleg, 0");
 	asm volatile("csrw medeleg, 0");
 	asm volatile("csrw mie, 0");
@@ -100,9 +174,87 @@ static void go_boot(void)
 
 	_boot();
 }
+#endif
+
+/*
+ * Once an image MAC key is fused in OTP the digest after the image is its
+ * HMAC-SHA256 with that key, and plain SHA256 images are refused.
+ * Returns 1 when the key is fused, 0 when blank and -1 on OTP error.
+ */
+static int flash_image_mac_key(uint8_t key[OTP_IMAGE_MAC_KEY_SIZE])
+{
+	uint8_t fused = 0;
+	int i;
+
+	if (otp_read_data(OTP_IMAGE_MAC_KEY_ADDR, key,
+			  OTP_IMAGE_MAC_KEY_SIZE) != OTP_OK)
+		return -1;
+	for (i = 0; i < OTP_IMAGE_MAC_KEY_SIZE; i++)
+		fused |= key[i];
+
+	return fused != 0;
+}
+
+#ifdef CONFIG_SECURE_BOOT
+/*
+ * Signed images carry the Ed25519 public key and a signature of the image
+ * digest, SHA256 or HMAC. The key is trusted when its SHA256 matches the
+ * hash fused in OTP. Nothing is enforced as long as that OTP area is blank.
+ */
+static int flash_image_check_signature(uint32_t sign_addr,
+				       uint8_t firmware_flag,
+				       const uint8_t *sha256_sign)
+{
+	uint8_t otp_key_hash[FLASH_SHA256_LEN];
+	uint8_t key_hash[FLASH_SHA256_LEN];
+	uint8_t sign[FLASH_SIGN_LEN];
+	uint8_t fused = 0;
+	SHA256Context sha256_context;
+	uint64_t cycle;
+	int i, ret;
+
+	if (otp_read_data(OTP_BOOT_PUBKEY_HASH_ADDR, otp_key_hash,
+			  FLASH_SHA256_LEN) != OTP_OK) {
+		debug_parser("[DEBUG] Can not read public key hash in OTP\n");
+		return -(EXIT_REASON_SIGNATURE);
+	}
+	for (i = 0; i < FLASH_SHA256_LEN; i++)
+		fused |= otp_key_hash[i];
+	if (fused == 0) {
+		debug_parser("[DEBUG] No public key hash in OTP, skip.\n");
+		return 0;
+	}
+
+	if ((firmware_flag & FIRMWARE_FLAG_SIGNED) == 0) {
+		debug_parser("[DEBUG] Image is not signed\n");
+		return -(EXIT_REASON_SIGNATURE);
+	}
+
+	// 32 bytes public key + 64 bytes signature
+	flash_read_data(sign_addr, sign, FLASH_SIGN_LEN, FLASH_QUAD_SINGLE);
+
+	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, ED25519_PUBKEY_SIZE,
+		    &sha256_context);
+	sha256_update(&sha256_context, sign, ED25519_PUBKEY_SIZE);
+	sha256_final(&sha256_context, key_hash);
+	if (memcmp(key_hash, otp_key_hash, FLASH_SHA256_LEN) != 0) {
+		debug_parser("[DEBUG] Public key does not match OTP\n");
+		return -(EXIT_REASON_SIGNATURE);
+	}
+
+	cycle = read_cycle();
+	ret = ed25519_verify(sign + ED25519_PUBKEY_SIZE, sha256_sign,
+			     FLASH_SHA256_LEN, sign);
+	cycle = read_cycle() - cycle;
+	debug_parser("[DEBUG] Ed25519 verify %s in %lu cycles\n",
+		     ret == 0 ? "pass" : "FAILED", cycle);
+
+	return ret == 0 ? 0 : -(EXIT_REASON_SIGNATURE);
+}
+#endif
 
 static int flash_image_check(uint32_t flash_addr, uintptr_t *ramptr,
-			     uint32_t length)
+			     uint32_t length, struct aes_session *aes_session)
 {
 	uint8_t firmware_aes_enabled = 0;
 	uint32_t codes_length;
@@ -124,7 +276,8 @@ static int flash_image_check(uint32_t flash_addr, uintptr_t *ramptr,
 	debug_parser("[DEBUG] Code length: 0x%08X = %u\n", codes_length,
 		     codes_length);
 
-	if (codes_length > length - 1 - 4 - FLASH_SHA256_LEN) {
+	if (codes_length >
+	    length - 1 - 4 - FLASH_TRAILER_LEN(firmware_aes_enabled)) {
 		debug_parser(
 			"[DEBUG] Code length 0x%08X is larger than 0x%08X\n",
 			codes_length, length);
@@ -139,52 +292,82 @@ static int flash_image_check(uint32_t flash_addr, uintptr_t *ramptr,
 			(uint8_t *)sha256_sign_firmware, FLASH_SHA256_LEN,
 			FLASH_QUAD_SINGLE);
 
-	/* 3. Check user data's SHA256 hash */
-	SHA256Context sha256_context;
+	/* 3. Check user data's SHA256 hash or HMAC */
+	uint8_t mac_key[OTP_IMAGE_MAC_KEY_SIZE];
+	uint8_t diff = 0;
+	int mac_fused = flash_image_mac_key(mac_key);
+
+	if (mac_fused < 0 ||
+	    mac_fused != !!(firmware_aes_enabled & FIRMWARE_FLAG_MAC)) {
+		debug_parser("[DEBUG] Image MAC flag %d, OTP MAC key %d\n",
+			     !!(firmware_aes_enabled & FIRMWARE_FLAG_MAC),
+			     mac_fused);
+		secure_zero(mac_key, sizeof(mac_key));
+		return -(EXIT_REASON_MAC);
+	}
 
-	debug_parser(
-		"[DEBUG] start calculate SHA256, sha256_context addr: %p, data_len: %d\n",
-		&sha256_context, (codes_length) + 5);
+	if (mac_fused) {
+		HMACSHA256Context hmac_context;
 
-	sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA, (codes_length) + 5,
-		    &sha256_context);
-	sha256_update(&sha256_context, &firmware_aes_enabled, 1);
-	sha256_update(&sha256_context, &codes_length, 4);
-	sha256_update(&sha256_context, (uint8_t *)ramptr, codes_length);
-	sha256_final(&sha256_context, sha256_sign);
-
-	// check if SHA256 checksum matches
-	for (int i = 0; i < FLASH_SHA256_LEN; i++) {
-		if (sha256_sign_firmware[i] != sha256_sign[i]) {
-			debug_parser("[DEBUG] SHA256 hash does not match\n");
-			debug_parser("[DEBUG] SHA256(firmware): ");
-			for (int i = 0; i < FLASH_SHA256_LEN; i++)
-				debug_parser("%02x", sha256_sign_firmware[i]);
-
-			debug_parser("\n[DEBUG] SHA256(calculate): ");
-
-			for (int i = 0; i < FLASH_SHA256_LEN; i++)
-				debug_parser("%02x", sha256_sign[i]);
-			debug_parser("\n");
-
-			/* Exit may due to sha256 fail. */
-			return -(EXIT_REASON_SHA256FLASH);
-		}
+		debug_parser("[DEBUG] start calculate HMAC, data_len: %d\n",
+			     (codes_length) + 5);
+
+		hmac_sha256_init(&hmac_context, mac_key, OTP_IMAGE_MAC_KEY_SIZE,
+				 (codes_length) + 5);
+		secure_zero(mac_key, sizeof(mac_key));
+		hmac_sha256_update(&hmac_context, &firmware_aes_enabled, 1);
+		hmac_sha256_update(&hmac_context, &codes_length, 4);
+		hmac_sha256_update(&hmac_context, (uint8_t *)ramptr,
+				   codes_length);
+		hmac_sha256_final(&hmac_context, sha256_sign);
+	} else {
+		SHA256Context sha256_context;
+
+		debug_parser(
+			"[DEBUG] start calculate SHA256, sha256_context addr: %p, data_len: %d\n",
+			&sha256_context, (codes_length) + 5);
+
+		sha256_init(DISABLE_SHA_DMA, DISABLE_DOUBLE_SHA,
+			    (codes_length) + 5, &sha256_context);
+		sha256_update(&sha256_context, &firmware_aes_enabled, 1);
+		sha256_update(&sha256_context, &codes_length, 4);
+		sha256_update(&sha256_context, (uint8_t *)ramptr, codes_length);
+		sha256_final(&sha256_context, sha256_sign);
+	}
+
+	// check if digest matches, without an early exit on the first byte
+	for (int i = 0; i < FLASH_SHA256_LEN; i++)
+		diff |= sha256_sign_firmware[i] ^ sha256_sign[i];
+	if (diff != 0) {
+		debug_parser("[DEBUG] SHA256 hash does not match\n");
+		debug_parser("[DEBUG] SHA256(firmware): ");
+		for (int i = 0; i < FLASH_SHA256_LEN; i++)
+			debug_parser("%02x", sha256_sign_firmware[i]);
+
+		debug_parser("\n[DEBUG] SHA256(calculate): ");
+
+		for (int i = 0; i < FLASH_SHA256_LEN; i++)
+			debug_parser("%02x", sha256_sign[i]);
+		debug_parser("\n");
+
+		/* Exit may due to sha256 fail. */
+		return -(EXIT_REASON_SHA256FLASH);
 	}
 
 	debug_parser("[DEBUG] SHA256 hash check pass.\n");
 
+#ifdef CONFIG_SECURE_BOOT
+	int sign_check = flash_image_check_signature(
+		flash_addr + 5 + codes_length + FLASH_SHA256_LEN,
+		firmware_aes_enabled, sha256_sign);
+	if (sign_check != 0)
+		return sign_check;
+#endif
+
 	/* 4. Decipher firmware */
-	if ((firmware_aes_enabled & 1U) == 1U) {
+	if ((firmware_aes_enabled & FIRMWARE_FLAG_AES) == FIRMWARE_FLAG_AES) {
 		// NOTE: Firmware must aligned with 16bytes, and padding 0 at tail
-
-		// enable OTP key
-		otp_key_output_enable();
-
-		uint8_t aes_key[16] = { 0 };
 		uint8_t aes_iv[16] = { 0 };
-		uint64_t aes_output[2];
-		uint64_t *aes_input_ptr = ramptr;
 
 		debug_parser("[DEBUG] AES deciphering\n");
 		debug_parser("[DEBUG] AES iv\n");
@@ -192,24 +375,18 @@ static int flash_image_check(uint32_t flash_addr, uintptr_t *ramptr,
 			debug_parser("%02x", aes_iv[i]);
 		debug_parser("\n");
 
-		sysctl_clock_enable(SYSCTL_CLOCK_AES);
-		sysctl_reset(SYSCTL_RESET_AES);
-
-		aes_init(aes_key, 16, aes_iv, 16, NULL, AES_CBC, AES_DENCRPTION,
-			 0, codes_length);
-
-		while (codes_length > 0) {
-			// decrypt
-			aes_process((uint8_t *)aes_input_ptr,
-				    (uint8_t *)aes_output, 16, AES_CBC);
-
-			*(aes_input_ptr++) = aes_output[0];
-			*(aes_input_ptr++) = aes_output[1];
-
-			codes_length -= 16;
+		// engine setup is shared by all images checked in this boot
+		if (!aes_session->opened)
+			aes_session_open(aes_session, AES_SESSION_OTP_KEY);
+
+		if (aes_session_decrypt(aes_session, (uint8_t *)ramptr,
+					(uint8_t *)ramptr, codes_length,
+					aes_iv) != 0) {
+			debug_parser(
+				"[DEBUG] Code length 0x%08X is not 16 bytes aligned\n",
+				codes_length);
+			return -(EXIT_REASON_CIPHER);
 		}
-
-		otp_key_output_disable(); // disable OTP aeskey output
 	} else {
 		debug_parser("[DEBUG] Firmware cipher DISABLED.\n");
 	}
@@ -239,29 +416,63 @@ static int flash_image_compare(uint32_t flash_addr1, uint32_t flash_addr2)
 	return memcmp(sha256_sign1, sha256_sign2, FLASH_SHA256_LEN);
 }
 
-static void flash_image_backup(uint32_t from_addr, uint32_t to_addr,
-			       uint8_t *ramptr)
+/*
+ * Bytes the image at flash_addr takes: flag, length, codes_length for app,
+ * SHA256 and signature if any. The digest is at flash_addr + 5 + *length.
+ */
+static uint32_t flash_image_size(uint32_t flash_addr, uint32_t *length)
 {
 	uint8_t firmware_aes_enabled = 0;
 	uint32_t codes_length;
 
 	// 1 byte AES flag
-	flash_read_data(from_addr, &firmware_aes_enabled, 1, FLASH_QUAD_SINGLE);
+	flash_read_data(flash_addr, &firmware_aes_enabled, 1,
+			FLASH_QUAD_SINGLE);
 	// 4 bytes length
-	flash_read_data(from_addr + 1, (uint8_t *)(uintptr_t)&codes_length, 4,
+	flash_read_data(flash_addr + 1, (uint8_t *)(uintptr_t)&codes_length, 4,
 			FLASH_QUAD_SINGLE);
-	// codes_length for app
-	flash_read_data(from_addr + 1 + 4, ramptr,
-			codes_length + FLASH_SHA256_LEN, FLASH_QUAD_SINGLE);
+	if (length)
+		*length = codes_length;
 
-	do_flash_erase(to_addr, 1 + 4 + codes_length + FLASH_SHA256_LEN);
+	return 1 + 4 + codes_length + FLASH_TRAILER_LEN(firmware_aes_enabled);
+}
 
-	flash_write_data(to_addr, (uint8_t *)(uintptr_t)&firmware_aes_enabled,
-			 1);
-	flash_write_data(to_addr + 1, (uint8_t *)(uintptr_t)&codes_length, 4);
+/*
+ * Copy the image at from_addr over the one at to_addr, sector by sector
+ * through the stage journal (journal.h) so _boot is left alone. A copy a
+ * power loss cut short goes on from the last sector written, the next boot
+ * finds the same slots out of sync and the same copy pending.
+ *
+ * Stage 2 only journals application slots, the application copies them
+ * through the service table (svc.h) when it has time. One which did not
+ * within JOURNAL_DEFER_BOOTS boots has the copy done before the jump.
+ */
+static void flash_image_sync(uint32_t from_addr, uint32_t to_addr)
+{
+	uint32_t codes_length, total;
+	int left;
+
+	total = flash_image_size(from_addr, &codes_length);
+	if (journal_begin(FLASH_JOURNAL_ADDR, from_addr, to_addr, total,
+			  5 + codes_length) != 0) {
+		printk("ERROR: image too large to copy\n");
+		return;
+	}
+#ifndef LOADER_STAGE1
+	if (journal_boot(FLASH_JOURNAL_ADDR) <= JOURNAL_DEFER_BOOTS) {
+		printk("## Left to the application\n");
+		return;
+	}
+#endif
 
-	do_flash_write(to_addr + 1 + 4, codes_length + FLASH_SHA256_LEN,
-		       ramptr);
+	printk("## Writing data into flash from 0x%08X to 0x%08X:\n", to_addr,
+	       to_addr + total - 1);
+	for (left = journal_step(FLASH_JOURNAL_ADDR, 0); left > 0;
+	     left = journal_step(FLASH_JOURNAL_ADDR, 1))
+		printk(".");
+	printk("\n");
+	if (left < 0)
+		printk("WARNING: copy failed, left to the next boot\n");
 }
 
 int core1_entry(void *ctx)
@@ -270,7 +481,9 @@ int core1_entry(void *ctx)
 	clint_ipi_clear(current_coreid());
 	clint_ipi_enable();
 	debug_parser("[DEBUG] Before wfi\n");
+#ifndef CONFIG_HOST_SIM
 	asm volatile("wfi");
+#endif
 	debug_parser("[DEBUG] After wfi\n");
 	clint_ipi_disable();
 	clint_ipi_clear(current_coreid());
@@ -289,60 +502,87 @@ int main()
 	uint32_t stage = 2;
 #endif
 
+	/* Queue console output, the boot path must not wait for the UART */
+	uart_tx_irq_enable();
+
 	printk("\nMAIX Bootloader stage %d running with core: %ld\n", stage,
 	       current_coreid());
 	printk("Build: " BUILD_VERSION "\n");
 	debug_parser("Next boot RAM address = 0x%08lX\n", (intptr_t)_boot);
 
 	register_core1(core1_entry, NULL);
+#if defined(LOADER_STAGE1) && defined(CONFIG_BOOT_CLI)
+	if (boot_cli_magic(BOOT_CLI_WINDOW)) {
+		printk("## Entering CLI\n");
+		cli_simple_loop();
+		printk("## CLI idle, booting\n");
+	}
+#else
 	msleep(20);
-
-#if (defined DEBUG && defined LOADER_STAGE1)
-	/* Show command line interface */
-	debug_parser("Please press 'k' or 'K' to enter CLI in 3 seconds");
-
-	/*for (int i = 0; i < 30; i++) {
-		msleep(100);
-		if (i % 10 == 0)
-			debug_parser(".");
-		if (!uart_tstc())
-			continue;
-		int c = uart_getc();
-		if (c == 'k' || c == 'K') {
-			debug_parser("\n");
-			cli_simple_loop();
-		}
-	}*/
-	debug_parser("\n");
 #endif
 
+	boot_phase("init");
+
 	/* TO run later, we must check APP last */
+	struct aes_session aes_session = { 0 };
+	uint32_t boot_addr = FLASH_APP_ADDR;
+	int sync = SVC_SYNC_NONE;
 	int bak_check = flash_image_check(FLASH_BAK_ADDR, (uint64_t *)_boot,
-					  FLASH_NEXT_SIZE);
+					  FLASH_NEXT_SIZE, &aes_session);
+	boot_phase("bak_check");
 	int app_check = flash_image_check(FLASH_APP_ADDR, (uint64_t *)_boot,
-					  FLASH_NEXT_SIZE);
-
-	if (flash_image_compare(FLASH_APP_ADDR, FLASH_BAK_ADDR) != 0) {
-		printk("WARNING: Different image found!\n");
-		if (app_check == 0) {
+					  FLASH_NEXT_SIZE, &aes_session);
+	// OTP key output and AES engine are off from here on, on any path
+	aes_session_close(&aes_session);
+	boot_phase("app_check");
+
+	/*
+	 * Both slots passed and carry the same digest: nothing to do. A bad
+	 * BAK is written again even when its digest still matches APP, a bad
+	 * APP is restored from BAK and checked again to be loaded. Stage 2
+	 * leaves both copies to the application and boots BAK as it is.
+	 */
+	if (app_check == 0) {
+		if (bak_check != 0 ||
+		    flash_image_compare(FLASH_APP_ADDR, FLASH_BAK_ADDR) != 0) {
+			printk("WARNING: Different image found!\n");
 			printk("## Copy from app 0x%08X to bak 0x%08X:\n",
 			       FLASH_APP_ADDR, FLASH_BAK_ADDR);
-			flash_image_backup(FLASH_APP_ADDR, FLASH_BAK_ADDR,
-					   (uint8_t *)_boot);
-		} else if (bak_check == 0) {
-			printk("## Copy from bak 0x%08X to app 0x%08X:\n",
-			       FLASH_BAK_ADDR, FLASH_APP_ADDR);
-			flash_image_backup(FLASH_BAK_ADDR, FLASH_APP_ADDR,
-					   (uint8_t *)_boot);
+			flash_image_sync(FLASH_APP_ADDR, FLASH_BAK_ADDR);
+			sync = SVC_SYNC_APP_TO_BAK;
 		} else {
-			printk("\nFailed to boot: Image check failed!\n");
+			/* a copy some earlier boot left pending is moot */
+			journal_cancel(FLASH_JOURNAL_ADDR);
+		}
+	} else if (bak_check == 0) {
+		printk("WARNING: Different image found!\n");
+		printk("## Copy from bak 0x%08X to app 0x%08X:\n",
+		       FLASH_BAK_ADDR, FLASH_APP_ADDR);
+		flash_image_sync(FLASH_BAK_ADDR, FLASH_APP_ADDR);
+		sync = SVC_SYNC_BAK_TO_APP;
+#ifndef LOADER_STAGE1
+		/* BAK is booted as it is, APP may not be restored yet */
+		boot_addr = FLASH_BAK_ADDR;
+#endif
+		int restored = flash_image_check(boot_addr, (uint64_t *)_boot,
+						 FLASH_NEXT_SIZE, &aes_session);
+		aes_session_close(&aes_session);
+		if (restored != 0) {
+			printk("\nFailed to boot: image check failed!\n");
 			goto FAILED;
 		}
-	} else if (app_check != 0) {
-		printk("\nFailed to boot: image check failed!\n");
+	} else {
+		printk("\nFailed to boot: Image check failed!\n");
 		goto FAILED;
 	}
+	boot_phase("sync");
 
+#ifdef LOADER_STAGE1
+	(void)sync;
+#else
+	/* flash, SHA256 and AES drivers stay usable by the application */
+	svc_publish(boot_addr, app_check, bak_check, sync);
+#endif
 	go_boot();
 
 FAILED:
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Pure python Ed25519 (RFC 8032), used to sign image digests for secure boot.
+# Slow, but it has no dependency besides hashlib and signs one digest per image.
+#
+# Usage:
+#   ed25519.py genkey <key.bin>              create a 32 bytes private seed
+#   ed25519.py pubkey <key.bin>              print public key and its SHA256
+#   ed25519.py otp <key.bin> <otp_hash.bin>  write SHA256(pubkey) for OTP fusing
+
+import sys
+import os
+import hashlib
+import binascii
+
+p = 2**255 - 19
+L = 2**252 + 27742317777372353535851937790883648493
+d = -121665 * pow(121666, p - 2, p) % p
+I = pow(2, (p - 1) // 4, p)
+
+SIGNATURE_LEN = 64
+PUBKEY_LEN = 32
+
+
+def _sha512(s):
+    return hashlib.sha512(s).digest()
+
+
+def _from_le(s):
+    return int(binascii.hexlify(bytes(bytearray(s))[::-1]), 16)
+
+
+def _to_le(n, length):
+    return binascii.unhexlify(('%0*x' % (length * 2, n)).encode())[::-1]
+
+
+def _inv(x):
+    return pow(x, p - 2, p)
+
+
+def _xrecover(y, sign):
+    xx = (y * y - 1) * _inv(d * y * y + 1)
+    x = pow(xx, (p + 3) // 8, p)
+    if (x * x - xx) % p != 0:
+        x = (x * I) % p
+    if (x * x - xx) % p != 0:
+        return None
+    if x == 0 and sign:
+        return None
+    if x & 1 != sign:
+        x = p - x
+    return x
+
+
+By = 4 * _inv(5) % p
+Bx = _xrecover(By, 0)
+B = (Bx, By, 1, Bx * By % p)
+IDENT = (0, 1, 1, 0)
+
+
+def point_add(P, Q):
+    A = (P[1] - P[0]) * (Q[1] - Q[0]) % p
+    Bv = (P[1] + P[0]) * (Q[1] + Q[0]) % p
+    C = 2 * P[3] * Q[3] * d % p
+    D = 2 * P[2] * Q[2] % p
+    E, F, G, H = Bv - A, D - C, D + C, Bv + A
+    return (E * F % p, G * H % p, F * G % p, E * H % p)
+
+
+def point_mul(s, P):
+    Q = IDENT
+    while s > 0:
+        if s & 1:
+            Q = point_add(Q, P)
+        P = point_add(P, P)
+        s >>= 1
+    return Q
+
+
+def point_equal(P, Q):
+    if (P[0] * Q[2] - Q[0] * P[2]) % p != 0:
+        return False
+    if (P[1] * Q[2] - Q[1] * P[2]) % p != 0:
+        return False
+    return True
+
+
+def point_affine(P):
+    zinv = _inv(P[2])
+    return (P[0] * zinv % p, P[1] * zinv % p)
+
+
+def point_compress(P):
+    x, y = point_affine(P)
+    return _to_le(y | ((x & 1) << 255), 32)
+
+
+def point_decompress(s):
+    if len(s) != 32:
+        return None
+    y = _from_le(s)
+    sign = y >> 255
+    y &= (1 << 255) - 1
+    if y >= p:
+        return None
+    x = _xrecover(y, sign)
+    if x is None:
+        return None
+    return (x, y, 1, x * y % p)
+
+
+def _secret_expand(seed):
+    if len(seed) != 32:
+        raise ValueError('Ed25519 private key must be 32 bytes')
+    h = _sha512(seed)
+    a = _from_le(h[:32])
+    a &= (1 << 254) - 8
+    a |= (1 << 254)
+    return (a, h[32:])
+
+
+def public_key(seed):
+    a, _ = _secret_expand(seed)
+    return point_compress(point_mul(a, B))
+
+
+def sign(seed, msg):
+    a, prefix = _secret_expand(seed)
+    A = point_compress(point_mul(a, B))
+    r = _from_le(_sha512(prefix + msg)) % L
+    Rs = point_compress(point_mul(r, B))
+    h = _from_le(_sha512(Rs + A + msg)) % L
+    s = (r + h * a) % L
+    return Rs + _to_le(s, 32)
+
+
+def verify(pub, msg, signature):
+    if len(pub) != 32 or len(signature) != 64:
+        return False
+    A = point_decompress(pub)
+    if not A:
+        return False
+    Rs = signature[:32]
+    R = point_decompress(Rs)
+    if not R:
+        return False
+    s = _from_le(signature[32:])
+    if s >= L:
+        return False
+    h = _from_le(_sha512(Rs + pub + msg)) % L
+    sB = point_mul(s, B)
+    hA = point_mul(h, A)
+    return point_equal(sB, point_add(R, hA))
+
+
+def load_key(path):
+    seed = open(path, 'rb').read()
+    if len(seed) == 64:
+        # hex encoded seed
+        seed = binascii.unhexlify(seed)
+    return seed
+
+
+if __name__ == '__main__':
+    if len(sys.argv) == 3 and sys.argv[1] == 'genkey':
+        with open(sys.argv[2], 'wb') as f:
+            f.write(os.urandom(32))
+    elif len(sys.argv) == 3 and sys.argv[1] == 'pubkey':
+        pub = public_key(load_key(sys.argv[2]))
+        print('public key : ' + binascii.hexlify(pub).decode())
+        print('OTP SHA256 : ' + hashlib.sha256(pub).hexdigest())
+    elif len(sys.argv) == 4 and sys.argv[1] == 'otp':
+        pub = public_key(load_key(sys.argv[2]))
+        with open(sys.argv[3], 'wb') as f:
+            f.write(hashlib.sha256(pub).digest())
+    else:
+        print(sys.argv[0] + " genkey <key.bin>")
+        print(sys.argv[0] + " pubkey <key.bin>")
+        print(sys.argv[0] + " otp <key.bin> <otp_hash.bin>")
+        sys.exit(1)
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Flash map of the README and the sparse whole-flash image built from it.
+#
+# A manifest places files in partitions, one per line:
+#
+#   # partition  format  file
+#   stage1       image   build/loader_stage1.bin
+#   app          aes     guard.bin
+#   bak          aes     guard.bin
+#   feature      raw     models/feature.kmodel
+#
+# "image" wraps the file with imgfmt.genimgfile(), "aes" does the same and
+# ciphers the payload with the --aes key, "raw" writes the file as is.
+# Paths are relative to the manifest. Distinct files are built in parallel
+# processes.
+#
+# A sparse image holds only the extents the manifest fills, never the 0xff
+# between them:
+#
+#   magic "KSPR" | version (2) | count (2) | flash size (4)
+#   count x { name (16) | offset (4) | length (4) | sha256 (32) }
+#   count x { 16 bytes of SHA256 of every 4 KB sector of the extent }
+#   data of every extent, in table order
+#
+# Flash outside the extents is left as it is on the device: images carry
+# their length and models their own size, so what follows them is never
+# read. The SHA256 of an extent is what a loader "flsha" of the range
+# prints and its sector hashes are what the loader FLASH_HASHES request
+# answers, the last sector 0xff padded. rpc.py "flsparse" compares both
+# without hashing the image again. Version 1 images, without sector hashes,
+# are still read.
+#
+# Usage:
+#   flashmap.py list <image.simg>
+#   flashmap.py flat <image.simg> <out.img>
+
+import os
+import sys
+import struct
+import hashlib
+import concurrent.futures
+
+SECTOR = 4096
+SECTOR_HASH_LEN = 16
+
+# Flash map of the README, as flash_map in src/bsp/flash_map.c
+PARTITIONS = [
+    ('stage1', 0x000000, 64 * 1024),
+    ('stage2_app', 0x010000, 64 * 1024),
+    ('stage2_bak', 0x020000, 64 * 1024),
+    ('app', 0x030000, 320 * 1024),
+    ('bak', 0x080000, 320 * 1024),
+    ('algorithm', 0x0D0000, 1024 * 1024),
+    ('keypoint', 0x1D0000, 192 * 1024),
+    ('detect', 0x200000, 320 * 1024),
+    ('feature', 0x250000, 1024 * 1024),
+    ('alive', 0x350000, 1024 * 1024),
+    ('jpeg', 0x450000, 1728 * 1024),
+    ('journal', 0x600000, 8 * 1024),
+]
+# End of the map, the journal follows the 6MB of images
+FLASH_SIZE = PARTITIONS[-1][1] + PARTITIONS[-1][2]
+
+SPARSE_MAGIC = b'KSPR'
+SPARSE_VERSION = 2
+SPARSE_HEADER = '<4sHHI'
+SPARSE_EXTENT = '<16sII32s'
+
+FORMATS = ('image', 'aes', 'raw')
+
+
+def partition(name):
+    """(offset, size) of a partition of the flash map"""
+    for pname, off, size in PARTITIONS:
+        if pname == name:
+            return off, size
+    raise ValueError('unknown partition %s' % name)
+
+
+def load_manifest(path):
+    """[(partition, format, file)] of a manifest, files made absolute"""
+    base = os.path.dirname(os.path.abspath(path))
+    entries = []
+    for n, line in enumerate(open(path)):
+        f = line.split('#', 1)[0].split()
+        if not f:
+            continue
+        if len(f) != 3 or f[1] not in FORMATS:
+            raise ValueError('%s:%d: expected "<partition> %s <file>"' %
+                             (path, n + 1, '|'.join(FORMATS)))
+        partition(f[0])
+        entries.append((f[0], f[1], os.path.join(base, f[2])))
+    return entries
+
+
+def sector_hashes(data):
+    """Truncated SHA256 of each 4 KB sector, the last one 0xff padded"""
+    data = data + b'\xff' * (-len(data) % SECTOR)
+    return [hashlib.sha256(data[i:i + SECTOR]).digest()[:SECTOR_HASH_LEN]
+            for i in range(0, len(data), SECTOR)]
+
+
+def extent(name, off, data):
+    """(name, offset, data, sha256, sector hashes)"""
+    data = bytes(data)
+    return (name, off, data, hashlib.sha256(data).digest(),
+            sector_hashes(data))
+
+
+def check(extents):
+    """Raise if an extent overflows its partition or two share one"""
+    seen = set()
+    for e in extents:
+        name, off, data = e[:3]
+        poff, psize = partition(name)
+        if name in seen:
+            raise ValueError('partition %s placed twice' % name)
+        seen.add(name)
+        if off != poff or len(data) > psize:
+            raise ValueError('%s: %d bytes do not fit %d' %
+                             (name, len(data), psize))
+
+
+def _build_one(job):
+    fmt, path, sign_key, mac_key, aes_key = job
+    if fmt == 'raw':
+        return extent(None, 0, open(path, 'rb').read())
+    import imgfmt
+    if fmt == 'aes' and not aes_key:
+        raise ValueError('%s: "aes" needs an --aes key' % path)
+    return extent(None, 0, imgfmt.genimgfile(
+        path, sign_key, mac_key, aes_key if fmt == 'aes' else None))
+
+
+def build(entries, sign_key=None, mac_key=None, aes_key=None, jobs=None):
+    """Extents of manifest entries, by offset. Each distinct (format, file)
+    is built and hashed once, in up to jobs processes."""
+    todo = sorted(set((fmt, path) for name, fmt, path in entries))
+    args = [(fmt, path, sign_key, mac_key, aes_key) for fmt, path in todo]
+    jobs = min(jobs or os.cpu_count() or 1, len(args))
+    if jobs > 1:
+        with concurrent.futures.ProcessPoolExecutor(jobs) as pool:
+            done = list(pool.map(_build_one, args))
+    else:
+        done = [_build_one(a) for a in args]
+    built = dict(zip(todo, done))
+
+    extents = []
+    for name, fmt, path in entries:
+        extents.append((name, partition(name)[0]) + built[fmt, path][2:])
+    extents.sort(key=lambda e: e[1])
+    check(extents)
+    return extents
+
+
+def write_sparse(path, extents):
+    table = b''
+    hashes = b''
+    for name, off, data, digest, sectors in extents:
+        table += struct.pack(SPARSE_EXTENT, name.encode(), off, len(data),
+                             digest)
+        hashes += b''.join(sectors)
+    with open(path, 'wb') as f:
+        f.write(struct.pack(SPARSE_HEADER, SPARSE_MAGIC, SPARSE_VERSION,
+                            len(extents), FLASH_SIZE))
+        f.write(table)
+        f.write(hashes)
+        for e in extents:
+            f.write(e[2])
+
+
+def read_sparse(path):
+    """Extents of a sparse image, their SHA256 checked"""
+    raw = open(path, 'rb').read()
+    magic, version, count, size = struct.unpack_from(SPARSE_HEADER, raw)
+    if magic != SPARSE_MAGIC or version not in (1, SPARSE_VERSION):
+        raise ValueError('%s: not a sparse image' % path)
+    pos = struct.calcsize(SPARSE_HEADER)
+    table = []
+    for i in range(count):
+        table.append(struct.unpack_from(SPARSE_EXTENT, raw, pos))
+        pos += struct.calcsize(SPARSE_EXTENT)
+    hash_pos = pos
+    if version > 1:
+        pos += sum((t[2] + SECTOR - 1) // SECTOR for t in table) * \
+            SECTOR_HASH_LEN
+    extents = []
+    for name, off, length, digest in table:
+        name = name.rstrip(b'\0').decode()
+        data = raw[pos:pos + length]
+        pos += length
+        if len(data) != length or hashlib.sha256(data).digest() != digest:
+            raise ValueError('%s: extent %s is corrupt' % (path, name))
+        if off + length > size:
+            raise ValueError('%s: extent %s beyond the flash' % (path, name))
+        if version > 1:
+            n = (length + SECTOR - 1) // SECTOR
+            sectors = [raw[hash_pos + i * SECTOR_HASH_LEN:
+                           hash_pos + (i + 1) * SECTOR_HASH_LEN]
+                       for i in range(n)]
+            hash_pos += n * SECTOR_HASH_LEN
+        else:
+            sectors = sector_hashes(data)
+        extents.append((name, off, data, digest, sectors))
+    return extents
+
+
+def flatten(extents):
+    """Flat image from offset 0 to the end of the last extent, 0xff between
+    the extents as genimg_whole.py always wrote"""
+    out = bytearray()
+    for e in sorted(extents, key=lambda e: e[1]):
+        off, data = e[1], e[2]
+        if off < len(out):
+            raise ValueError('extent %s overlaps' % e[0])
+        out += b'\xff' * (off - len(out)) + data
+    return bytes(out)
+
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == 'list':
+        extents = read_sparse(sys.argv[2])
+        for name, off, data, digest, sectors in extents:
+            print('%-10s 0x%06x 0x%06x %s' % (name, off, len(data),
+                                               digest.hex()))
+        used = sum(len(e[2]) for e in extents)
+        print('%d bytes in %d extents, %d%% of the flash' %
+              (used, len(extents), used * 100 // FLASH_SIZE))
+    elif len(sys.argv) == 4 and sys.argv[1] == 'flat':
+        open(sys.argv[3], 'wb').write(flatten(read_sparse(sys.argv[2])))
+    else:
+        print(sys.argv[0] + ' list <image.simg> | flat <image.simg> <out.img>')
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Host side of the loader "fldumpb" command: read a flash range into a file
+# through CRC-32C checked loadx frames, see src/cli/fldumpb.c.
+#
+# The loader streams the range without waiting for ACKs and ends with the
+# SHA256 of what it read. Frames whose CRC fails are dropped by the frame
+# reader, the gaps they leave are asked for again by offset, and the file is
+# only written when the SHA256 of the reassembled data matches. A CANCEL
+# from the loader means it could not read the flash, nothing is written.
+#
+# With --fast the rate is negotiated first, as loadx.py does.
+#
+# Usage:
+#   fldumpb.py [-b baud] [--fast max] [--no-cmd]
+#              <port> <floffset> <length> <file>
+
+import sys
+import time
+import hashlib
+import argparse
+import loadx
+
+READY = b'## Ready for binary (fldumpb)'
+START_RETRIES = 20
+END_RETRIES = 10
+END_TIMEOUT = 0.05
+# Rounds of resend requests before giving up
+GAP_ROUNDS = 10
+# Requests in flight per round, replies queue up in the loader TX ring
+GAP_BATCH = 8
+
+
+class FldumpbError(Exception):
+    pass
+
+
+def _gaps(parts, total):
+    """Offsets where received data stops, ascending"""
+    gaps = []
+    pos = 0
+    for off in sorted(parts):
+        if off > pos:
+            gaps.append(pos)
+        pos = max(pos, off + len(parts[off]))
+    if pos < total:
+        gaps.append(pos)
+    return gaps
+
+
+def receive(port, total, log=None):
+    rx = loadx.FrameReader(port)
+    parts = {}
+    digest = None
+    resent = 0
+
+    def take(f):
+        if f[0] == loadx.CANCEL:
+            raise FldumpbError('loader could not read the flash at 0x%x' %
+                               f[1])
+        if f[0] == loadx.DATA and f[1] < total:
+            parts[f[1]] = f[2][:total - f[1]]
+        elif f[0] == loadx.END and f[1] == total and len(f[2]) == 32:
+            return f[2]
+        return None
+
+    for _ in range(START_RETRIES):
+        port.write(loadx.pack_frame(loadx.START, 0))
+        f = rx.frame(0.5)
+        if f and f[0] in (loadx.ACK, loadx.DATA, loadx.CANCEL):
+            break
+    else:
+        raise FldumpbError('no answer to START')
+    if f[0] == loadx.ACK and f[1] != total:
+        raise FldumpbError('loader sends 0x%x bytes' % f[1])
+    take(f)
+
+    # The stream: silence longer than a frame time means it is over
+    line = 10.0 / port.baud
+    idle = 0.2 + 4 * loadx.FRAME_DEFAULT * line
+    while digest is None:
+        f = rx.frame(idle)
+        if not f:
+            break
+        digest = take(f)
+        if log:
+            log(sum(len(p) for p in parts.values()), total)
+
+    for _ in range(GAP_ROUNDS):
+        gaps = _gaps(parts, total)
+        if digest is None:
+            gaps.append(total)
+        if not gaps:
+            break
+        wanted = set(gaps[:GAP_BATCH])
+        for off in sorted(wanted):
+            port.write(loadx.pack_frame(loadx.DATA, off))
+            resent += 1
+        while wanted:
+            f = rx.frame(idle)
+            if not f:
+                break
+            d = take(f)
+            if d:
+                digest = d
+            wanted.discard(f[1])
+    else:
+        raise FldumpbError('frames at %s still missing' %
+                           ', '.join('0x%x' % o for o in gaps[:4]))
+
+    data = bytearray(total)
+    for off in sorted(parts):
+        data[off:off + len(parts[off])] = parts[off]
+    data = bytes(data)
+    if hashlib.sha256(data).digest() != digest:
+        raise FldumpbError('SHA256 mismatch')
+
+    # the loader answers a repeated END for LOADX_LINGER (200 ms)
+    for _ in range(END_RETRIES):
+        port.write(loadx.pack_frame(loadx.END, total))
+        f = rx.frame(END_TIMEOUT)
+        while f and f[0] != loadx.ACK:
+            f = rx.frame(END_TIMEOUT)
+        if f:
+            return data, resent
+    raise FldumpbError('no answer to END')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Dump flash into a file')
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('--fast', type=int, default=0, metavar='MAX',
+                        help='negotiate a rate up to MAX before reading')
+    parser.add_argument('--no-cmd', action='store_true',
+                        help='fldumpb is already waiting, do not type it')
+    parser.add_argument('port')
+    parser.add_argument('floffset')
+    parser.add_argument('length')
+    parser.add_argument('file')
+    args = parser.parse_args()
+
+    offset = int(args.floffset, 16)
+    total = int(args.length, 16)
+    port = loadx.Port(args.port, args.baud)
+
+    if not args.no_cmd:
+        rx = loadx.FrameReader(port)
+        if args.fast:
+            print('link at %d baud' % loadx.negotiate(port, rx, args.fast))
+        loadx.type_command(port, 'fldumpb %x %x' % (offset, total))
+        if not rx.wait_text(READY, 3):
+            print('loader did not start fldumpb')
+            sys.exit(1)
+
+    def log(done, count):
+        sys.stdout.write('\r%d/%d bytes' % (done, count))
+        sys.stdout.flush()
+
+    start = time.time()
+    try:
+        data, resent = receive(port, total, log)
+    except FldumpbError as e:
+        port.write(loadx.pack_frame(loadx.CANCEL, 0))
+        print('\nfldumpb: %s' % e)
+        sys.exit(1)
+    finally:
+        port.close()
+    spent = time.time() - start
+
+    with open(args.file, 'wb') as f:
+        f.write(data)
+    rate = total / spent
+    print('\n%d bytes in %.2f s, %d KB/s, %.0f%% of line rate, %d resent' %
+          (total, spent, rate / 1024, rate * 1000 / port.baud, resent))
+    print('SHA256 %s' % hashlib.sha256(data).hexdigest())
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Generate the slicing-by-8 lookup tables for the reflected CRCs in src/cli,
+# so they live in .rodata instead of being built at run time. Only table[0],
+# the byte-wise one, is built without CONFIG_CRC_SLICE_BY_8.
+#
+# Usage:
+#   gen_crc_tables.py crc16  > src/cli/crc16_table.h
+#   gen_crc_tables.py crc32c > src/cli/crc32c_table.h
+
+import sys
+
+# name: (reflected polynomial, width)
+CRCS = {
+    'crc16': (0xA001, 16),
+    'crc32c': (0x82F63B78, 32),
+}
+
+SLICES = 8
+
+
+def tables(poly, width):
+    t = [[0] * 256 for _ in range(SLICES)]
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = (crc >> 1) ^ poly if crc & 1 else crc >> 1
+        t[0][i] = crc
+    for k in range(1, SLICES):
+        for i in range(256):
+            prev = t[k - 1][i]
+            t[k][i] = (prev >> 8) ^ t[0][prev & 0xff]
+    return t
+
+
+def main():
+    if len(sys.argv) != 2 or sys.argv[1] not in CRCS:
+        print(sys.argv[0] + " <" + "|".join(sorted(CRCS)) + ">")
+        sys.exit(1)
+    name = sys.argv[1]
+    poly, width = CRCS[name]
+    ctype = 'uint%d_t' % width
+    digits = width // 4
+    per_line = 8 if width == 16 else 6
+
+    out = []
+    out.append('/* Generated by utils/gen_crc_tables.py %s, do not edit. */' % name)
+    out.append('')
+    out.append('/* clang-format off */')
+    out.append('/* Reflected polynomial 0x%0*X, table[k][i] is i shifted by k more bytes */'
+               % (digits, poly))
+    out.append('static const %s %s_table[CRC_TABLES][256] = {' % (ctype, name))
+    for k, t in enumerate(tables(poly, width)):
+        if k == 1:
+            out.append('#ifdef CONFIG_CRC_SLICE_BY_8')
+        out.append('\t{')
+        for i in range(0, 256, per_line):
+            row = ', '.join('0x%0*X' % (digits, v) for v in t[i:i + per_line])
+            out.append('\t\t' + row + ',')
+        out.append('\t},')
+    out.append('#endif')
+    out.append('};')
+    out.append('/* clang-format on */')
+    print('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
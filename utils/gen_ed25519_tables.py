@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Generate src/crypto/ed25519_tables.h: curve constants and the odd multiples
+# of the base point used by the sliding window in ed25519_verify(), as
+# radix 2^51 limbs.
+#
+# Usage: gen_ed25519_tables.py <window> > src/crypto/ed25519_tables.h
+
+import sys
+import ed25519 as ed
+
+MASK51 = (1 << 51) - 1
+
+
+def limbs(x):
+    x %= ed.p
+    return [(x >> (51 * i)) & MASK51 for i in range(5)]
+
+
+def fe(x):
+    return '{ ' + ', '.join('0x%013xULL' % l for l in limbs(x)) + ' }'
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(sys.argv[0] + " <window>")
+        sys.exit(1)
+    window = int(sys.argv[1])
+    count = 1 << (window - 2)
+
+    out = []
+    out.append('/* Generated by utils/gen_ed25519_tables.py %d, do not edit. */' % window)
+    out.append('')
+    out.append('/* clang-format off */')
+    out.append('#define ED25519_BASE_WINDOW\t%d' % window)
+    out.append('')
+    out.append('static const fe ed25519_d = %s;' % fe(ed.d))
+    out.append('static const fe ed25519_d2 = %s;' % fe(2 * ed.d))
+    out.append('static const fe ed25519_sqrtm1 = %s;' % fe(ed.I))
+    out.append('')
+    out.append('/* B, 3B, 5B, ... as (y + x, y - x, 2dxy) */')
+    out.append('static const struct ge_precomp ed25519_base_odd[%d] = {' % count)
+
+    B2 = ed.point_add(ed.B, ed.B)
+    P = ed.B
+    for i in range(count):
+        x, y = ed.point_affine(P)
+        out.append('\t{')
+        out.append('\t\t%s,' % fe(y + x))
+        out.append('\t\t%s,' % fe(y - x))
+        out.append('\t\t%s,' % fe(2 * ed.d * x * y))
+        out.append('\t},')
+        P = ed.point_add(P, B2)
+    out.append('};')
+    out.append('/* clang-format on */')
+    print('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Sparse whole-flash image from a manifest, see flashmap.py for both
+# formats. Only the partitions the manifest names are stored, so the image
+# of a 6 MB flash holding the loader, the app and the models is the size of
+# those files, not of the flash. The files are built in parallel, one
+# process per CPU.
+#
+# Usage: genimg_sparse.py <manifest> <out.simg> [--sign key] [--mac key]
+#                         [--aes key]
+
+import sys
+import time
+import imgfmt
+import aescbc
+import flashmap
+
+
+def main():
+    args, sign_key, mac_key, aes_key = imgfmt.parse_args(
+        sys.argv, "<manifest> <out.simg>", 2, aes=True)
+
+    start = time.time()
+    try:
+        extents = flashmap.build(flashmap.load_manifest(args[0]), sign_key,
+                                 mac_key, aes_key)
+    except (ValueError, IOError) as e:
+        print('genimg_sparse: %s' % e)
+        sys.exit(1)
+    flashmap.write_sparse(args[1], extents)
+    for name, off, data, digest, sectors in extents:
+        print('%-10s 0x%06x %7d bytes' % (name, off, len(data)))
+    print('%.2f s, AES by %s' % (time.time() - start, aescbc.BACKEND))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Image format checked by flash_image_check() in the loader:
+#
+#   flag (1) | length (4, LE) | payload | digest (32) [| pubkey (32) | sig (64)]
+#
+# flag bit 0: payload is AES-128-CBC ciphered with the OTP key
+# flag bit 1: signed, Ed25519 public key and signature of the digest follow
+# flag bit 2: digest is HMAC-SHA256 with the OTP image MAC key, not SHA256
+#
+# The digest covers flag, length and payload. Payload is zero padded so the
+# digested part plus digest is a multiple of 64 bytes, or to 16 bytes when
+# it is ciphered, which the loader needs.
+#
+# The input is read, ciphered and digested in chunks, see aescbc.py for the
+# AES implementations.
+
+import os
+import sys
+import struct
+import hashlib
+import hmac
+import binascii
+import ed25519
+import aescbc
+
+FLAG_AES = 0x01
+FLAG_SIGNED = 0x02
+FLAG_MAC = 0x04
+
+DIGEST_LEN = 32
+MAC_KEY_LEN = 32
+AES_KEY_LEN = 16
+CHUNK = 64 * 1024
+
+
+def load_mac_key(path):
+    key = open(path, 'rb').read()
+    if len(key) == MAC_KEY_LEN * 2:
+        # hex encoded key
+        key = binascii.unhexlify(key)
+    if len(key) != MAC_KEY_LEN:
+        raise ValueError('image MAC key must be %d bytes' % MAC_KEY_LEN)
+    return key
+
+
+def load_aes_key(path):
+    key = open(path, 'rb').read().strip()
+    if len(key) == AES_KEY_LEN * 2:
+        key = binascii.unhexlify(key)
+    if len(key) != AES_KEY_LEN:
+        raise ValueError('AES key must be %d bytes' % AES_KEY_LEN)
+    return key
+
+
+def _payload(bin_file, pad_len):
+    """Chunks of the file, the last one zero padded"""
+    with open(bin_file, 'rb') as f:
+        while True:
+            chunk = f.read(CHUNK)
+            if len(chunk) < CHUNK:
+                yield chunk + bytes(pad_len)
+                return
+            yield chunk
+
+
+def genimgfile(bin_file, sign_key=None, mac_key=None, aes_key=None):
+    flag = 0
+    if aes_key:
+        flag |= FLAG_AES
+    if sign_key:
+        flag |= FLAG_SIGNED
+    if mac_key:
+        flag |= FLAG_MAC
+
+    firmware_len = os.path.getsize(bin_file)
+    if aes_key:
+        pad_len = -firmware_len % aescbc.BLOCK
+    else:
+        # 64bytes align
+        pad_len = -(firmware_len + 37) % 64
+    firmware_len += pad_len
+
+    data = bytearray(struct.pack('<BI', flag, firmware_len))
+    if mac_key:
+        hasher = hmac.new(mac_key, bytes(data), hashlib.sha256)
+    else:
+        hasher = hashlib.sha256(data)
+    enc = aescbc.Encryptor(aes_key) if aes_key else None
+    for chunk in _payload(bin_file, pad_len):
+        if enc:
+            chunk = enc.update(chunk)
+        hasher.update(chunk)
+        data += chunk
+    digest = hasher.digest()
+    firmware_with_header = data + digest
+    if sign_key:
+        # Ed25519 public key and signature of the digest
+        firmware_with_header += ed25519.public_key(sign_key)
+        firmware_with_header += ed25519.sign(sign_key, digest)
+    return firmware_with_header
+
+
+def parse_args(argv, usage, nargs, aes=False):
+    """Split argv into nargs positional arguments and the key options.
+    With aes, --aes is accepted too and its key returned last."""
+    args = []
+    sign_key = None
+    mac_key = None
+    aes_key = None
+    i = 1
+    while i < len(argv):
+        if argv[i] == '--sign' and i + 1 < len(argv):
+            sign_key = ed25519.load_key(argv[i + 1])
+            i += 2
+        elif argv[i] == '--mac' and i + 1 < len(argv):
+            mac_key = load_mac_key(argv[i + 1])
+            i += 2
+        elif aes and argv[i] == '--aes' and i + 1 < len(argv):
+            aes_key = load_aes_key(argv[i + 1])
+            i += 2
+        else:
+            args.append(argv[i])
+            i += 1
+    if len(args) != nargs:
+        print(argv[0] + ' ' + usage + ' [--sign key.bin] [--mac mac_key.bin]'
+              + (' [--aes aes_key.bin]' if aes else ''))
+        sys.exit(1)
+    if aes:
+        return args, sign_key, mac_key, aes_key
+    return args, sign_key, mac_key
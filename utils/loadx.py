@@ -0,0 +1,401 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Host side of the loader "loadx" command: send a file into loader RAM with
+# CRC-32C checked frames of several KB and a sliding window, see
+# src/include/loadx.h for the frame layout.
+#
+# Every DATA frame is acknowledged on its own. The link keeps frame order, so
+# an ACK for a later frame means the earlier unacknowledged ones were lost and
+# only those are sent again. A timeout covers a lost tail of the window.
+#
+# With --fast the link is first moved to the highest rate of BAUD_RATES up to
+# the given one that both ends reach: the loader "baud" command switches after
+# announcing it, the host follows and sends PROBE, the loader answers it
+# inverted and the host confirms. Anything missing sends both back to the old
+# rate and the next lower rate is tried.
+#
+# With --flash the file goes straight into flash through "flashrx": the
+# address is a flash offset, and the loader holds ACKs back while both of its
+# buffers are being programmed, so retransmissions wait longer.
+#
+# Usage:
+#   loadx.py [-b baud] [--fast max] [--flash] [-f frame] [-w window] [--no-cmd]
+#            <port> <address> <file>
+
+import sys
+import os
+import time
+import struct
+import argparse
+import gen_crc_tables
+
+SYNC = b'LX'
+HDR_LEN = 10
+CRC_LEN = 4
+
+START = b'S'
+DATA = b'D'
+END = b'E'
+CANCEL = b'C'
+ACK = b'A'
+NAK = b'N'
+
+FRAME_DEFAULT = 4096
+WINDOW_DEFAULT = 8
+START_RETRIES = 20
+END_RETRIES = 10
+FRAME_RETRIES = 10
+# Gap inside a frame after which it is given up, as LOADX_BYTE_TIMEOUT
+BYTE_TIMEOUT = 0.05
+
+# Pause after each typed command character, the CLI reads through its RX
+# ring and keeps up with the line
+CMD_CHAR_DELAY = 0.002
+READY = b'## Ready for binary (loadx)'
+READY_FLASH = b'## Ready for binary (flashrx)'
+# Frames may wait behind a 64 KB block erase and 32 KB of programming
+FLASH_RTO = 2.0
+
+# Same as baud_probe and baud_confirm in src/cli/baud.c
+PROBE = bytes(bytearray([0x55, 0xAA, 0x00, 0xFF, 0x0F, 0xF0, 0x33, 0xCC,
+                         0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80]))
+PROBE_ANSWER = bytes(bytearray([~b & 0xff for b in bytearray(PROBE)]))
+CONFIRM = b'BDOK'
+BAUD_RATES = [4500000, 4000000, 3000000, 2000000, 1500000, 921600, 460800,
+              230400]
+
+_CRC32C = gen_crc_tables.tables(0x82F63B78, 32)[0]
+
+
+class LoadxError(Exception):
+    pass
+
+
+def crc32c(data, crc=0):
+    crc ^= 0xffffffff
+    table = _CRC32C
+    for b in bytearray(data):
+        crc = table[(crc ^ b) & 0xff] ^ (crc >> 8)
+    return crc ^ 0xffffffff
+
+
+def pack_frame(ftype, offset, payload=b''):
+    body = ftype + b'\0' + struct.pack('<IH', offset, len(payload)) + payload
+    return SYNC + body + struct.pack('<I', crc32c(body))
+
+
+class Port(object):
+    """Raw serial port, termios on POSIX (also works on a pty) else pyserial.
+    ser is a pyserial port already open, path is not used then."""
+
+    def __init__(self, path, baud, ser=None):
+        self.ser = ser
+        self.baud = baud
+        if ser:
+            return
+        if os.name == 'posix':
+            import tty
+            self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+            tty.setraw(self.fd)
+            if self.can_baud(baud):
+                self.set_baud(baud)
+        else:
+            import serial
+            self.ser = serial.Serial(path, baud, timeout=0)
+
+    def can_baud(self, baud):
+        if self.ser:
+            return True
+        import termios
+        return hasattr(termios, 'B%d' % baud)
+
+    def set_baud(self, baud):
+        """Change rate once everything written so far is out"""
+        if self.ser:
+            self.ser.flush()
+            self.ser.baudrate = baud
+        else:
+            import termios
+            attr = termios.tcgetattr(self.fd)
+            attr[4] = attr[5] = getattr(termios, 'B%d' % baud)
+            termios.tcsetattr(self.fd, termios.TCSADRAIN, attr)
+        self.baud = baud
+
+    def flush_input(self):
+        if self.ser:
+            self.ser.reset_input_buffer()
+        else:
+            import termios
+            termios.tcflush(self.fd, termios.TCIFLUSH)
+
+    def write(self, data):
+        if self.ser:
+            self.ser.write(data)
+            return
+        while data:
+            n = os.write(self.fd, data)
+            data = data[n:]
+
+    def read(self, timeout):
+        if self.ser:
+            self.ser.timeout = timeout
+            return self.ser.read(max(1, self.ser.in_waiting))
+        import select
+        r, _, _ = select.select([self.fd], [], [], timeout)
+        if not r:
+            return b''
+        return os.read(self.fd, 65536)
+
+    def close(self):
+        if self.ser:
+            self.ser.close()
+        else:
+            os.close(self.fd)
+
+
+class FrameReader(object):
+    """Pick loader frames out of the byte stream, text in between is kept.
+    Frames come back as (type, offset, payload, flags)."""
+
+    def __init__(self, port):
+        self.port = port
+        self.buf = b''
+        self.text = b''
+        self.last = time.time()
+
+    def _parse(self):
+        while True:
+            i = self.buf.find(SYNC)
+            if i < 0:
+                keep = 1 if self.buf.endswith(SYNC[:1]) else 0
+                self.text += self.buf[:len(self.buf) - keep]
+                self.buf = self.buf[len(self.buf) - keep:]
+                return None
+            self.text += self.buf[:i]
+            self.buf = self.buf[i:]
+            if len(self.buf) < HDR_LEN:
+                return None
+            offset, length = struct.unpack('<IH', self.buf[4:HDR_LEN])
+            end = HDR_LEN + length + CRC_LEN
+            if len(self.buf) < end:
+                return None
+            body = self.buf[2:end - CRC_LEN]
+            crc, = struct.unpack('<I', self.buf[end - CRC_LEN:end])
+            if crc != crc32c(body):
+                # not a frame after all, resync after this sync byte
+                self.text += self.buf[:1]
+                self.buf = self.buf[1:]
+                continue
+            self.buf = self.buf[end:]
+            return (body[0:1], offset, body[HDR_LEN - 2:], body[1:2])
+
+    def _skip(self):
+        # a corrupted length waits for bytes which never come, look for
+        # frames behind its sync
+        while self.buf.startswith(SYNC):
+            self.text += self.buf[:1]
+            self.buf = self.buf[1:]
+            f = self._parse()
+            if f:
+                return f
+        return None
+
+    def frame(self, timeout):
+        deadline = time.time() + timeout
+        while True:
+            f = self._parse()
+            if not f and time.time() - self.last > BYTE_TIMEOUT:
+                f = self._skip()
+            if f:
+                return f
+            left = deadline - time.time()
+            if left <= 0:
+                return None
+            data = self.port.read(min(left, BYTE_TIMEOUT))
+            if data:
+                self.buf += data
+                self.last = time.time()
+
+    def wait_text(self, pattern, timeout):
+        deadline = time.time() + timeout
+        while pattern not in self.text:
+            left = deadline - time.time()
+            if left <= 0:
+                return False
+            self.buf += self.port.read(left)
+            self._parse()
+        self.text = b''
+        return True
+
+
+def type_command(port, cmd):
+    for c in cmd + '\r':
+        port.write(c.encode())
+        time.sleep(CMD_CHAR_DELAY)
+
+
+def _switch(port, rx, baud):
+    old = port.baud
+    type_command(port, 'baud %d' % baud)
+    if not rx.wait_text(('## Switch to %d baud' % baud).encode(), 2):
+        return False
+
+    port.set_baud(baud)
+    time.sleep(0.02)
+    port.flush_input()
+    rx.buf = rx.text = b''
+    for _ in range(3):
+        port.write(PROBE)
+        if rx.wait_text(PROBE_ANSWER, 0.2):
+            port.write(CONFIRM)
+            if rx.wait_text(('## Baud rate %d' % baud).encode(), 0.5):
+                return True
+            break
+
+    port.set_baud(old)
+    port.flush_input()
+    rx.wait_text(b'## Baud switch failed', 2)
+    return False
+
+
+def negotiate(port, rx, fastest):
+    """Move to the highest rate both sides reach, returns the rate in use"""
+    for baud in BAUD_RATES:
+        if baud > fastest or baud <= port.baud or not port.can_baud(baud):
+            continue
+        if _switch(port, rx, baud):
+            break
+    return port.baud
+
+
+def _handshake(port, rx, frame, timeout, retries):
+    ftype, offset = frame[2:3], struct.unpack('<I', frame[4:8])[0]
+    for _ in range(retries):
+        port.write(frame)
+        deadline = time.time() + timeout
+        while True:
+            f = rx.frame(max(0, deadline - time.time()))
+            if not f:
+                break
+            if f[0] in (ACK, NAK) and f[1] == offset:
+                return f
+    raise LoadxError('no answer to %s frame' % ftype.decode())
+
+
+def send(port, data, frame=FRAME_DEFAULT, window=WINDOW_DEFAULT, baud=None,
+         log=None, min_rto=0.3):
+    rx = FrameReader(port)
+    total = len(data)
+
+    f = _handshake(port, rx, pack_frame(START, total), 0.5, START_RETRIES)
+    if f[0] == NAK:
+        raise LoadxError('loader refused %d bytes' % total)
+    peer_frame, peer_window = struct.unpack('<HH', f[2][:4])
+    frame = min(frame, peer_frame)
+    window = min(window, peer_window)
+
+    # Retransmit timeout: a full window on the wire plus turnaround
+    line = 10.0 / baud if baud else 0
+    rto = min_rto + 2 * window * (frame + HDR_LEN + CRC_LEN) * line
+
+    offsets = list(range(0, total, frame))
+    pending = {}  # offset -> [send seq, send time, tries]
+    next_i = 0
+    seq = 0
+    done = 0
+    resent = 0
+
+    def put(off, tries):
+        p = data[off:off + frame]
+        port.write(pack_frame(DATA, off, p))
+        pending[off] = [seq, time.time(), tries]
+
+    while done < len(offsets):
+        while next_i < len(offsets) and len(pending) < window:
+            put(offsets[next_i], 1)
+            seq += 1
+            next_i += 1
+
+        f = rx.frame(0.05)
+        if f and f[0] == NAK:
+            raise LoadxError('loader refused frame at 0x%x' % f[1])
+        if f and f[0] == ACK and f[1] in pending:
+            acked = pending.pop(f[1])[0]
+            done += 1
+            # in order link: whatever was sent before it is lost
+            lost = [o for o, s in pending.items() if s[0] < acked]
+        else:
+            now = time.time()
+            lost = [o for o, s in pending.items() if now - s[1] > rto]
+        for off in sorted(lost, key=lambda o: pending[o][0]):
+            tries = pending[off][2] + 1
+            if tries > FRAME_RETRIES:
+                raise LoadxError('frame at 0x%x not acknowledged' % off)
+            put(off, tries)
+            seq += 1
+            resent += 1
+        if log:
+            log(done, len(offsets))
+
+    f = _handshake(port, rx, pack_frame(END, total,
+                                        struct.pack('<I', crc32c(data))),
+                   max(rto, 1.0), END_RETRIES)
+    if f[0] == NAK:
+        raise LoadxError('image CRC mismatch on the loader')
+    return resent
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Send a file to loader RAM')
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('--fast', type=int, default=0, metavar='MAX',
+                        help='negotiate a rate up to MAX before sending')
+    parser.add_argument('-f', '--frame', type=int, default=FRAME_DEFAULT)
+    parser.add_argument('-w', '--window', type=int, default=WINDOW_DEFAULT)
+    parser.add_argument('--flash', action='store_true',
+                        help='program flash at <address> with flashrx')
+    parser.add_argument('--no-cmd', action='store_true',
+                        help='loadx is already waiting, do not type it')
+    parser.add_argument('port')
+    parser.add_argument('address',
+                        help='RAM address, flash offset with --flash')
+    parser.add_argument('file')
+    args = parser.parse_args()
+
+    data = open(args.file, 'rb').read()
+    port = Port(args.port, args.baud)
+
+    if not args.no_cmd:
+        rx = FrameReader(port)
+        if args.fast:
+            print('link at %d baud' % negotiate(port, rx, args.fast))
+        cmd = 'flashrx' if args.flash else 'loadx'
+        type_command(port, '%s %x' % (cmd, int(args.address, 16)))
+        if not rx.wait_text(READY_FLASH if args.flash else READY, 3):
+            print('loader did not start ' + cmd)
+            sys.exit(1)
+
+    def log(done, count):
+        sys.stdout.write('\r%d/%d frames' % (done, count))
+        sys.stdout.flush()
+
+    start = time.time()
+    try:
+        resent = send(port, data, args.frame, args.window, port.baud, log,
+                      FLASH_RTO if args.flash else 0.3)
+    except LoadxError as e:
+        port.write(pack_frame(CANCEL, 0))
+        print('\nloadx: %s' % e)
+        sys.exit(1)
+    finally:
+        port.close()
+    spent = time.time() - start
+
+    rate = len(data) / spent
+    print('\n%d bytes in %.2f s, %d KB/s, %.0f%% of line rate, %d resent' %
+          (len(data), spent, rate / 1024, rate * 1000 / port.baud, resent))
+
+
+if __name__ == '__main__':
+    main()
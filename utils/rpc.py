@@ -0,0 +1,375 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Client of the loader machine mode, see src/include/rpc.h: requests and
+# answers are loadx frames with CRC-32C, so scripts never parse the prompt.
+#
+#   import rpc
+#   ldr = rpc.Loader(loadx.Port('/dev/ttyUSB0', 115200))
+#   ldr.flash_erase(0x10000, len(data))
+#   ldr.flash_write(0x10000, data)
+#   assert ldr.flash_sha256(0x10000, len(data)) == hashlib.sha256(data).digest()
+#   ldr.quit()
+#
+# flsync programs only the 4 KB sectors whose hash on the loader differs
+# from the file, so re-flashing an image with a small change takes seconds.
+# flsparse does the same for the extents of a sparse image and skips the
+# extents whose SHA256 already matches and the gaps between them.
+#
+# Usage:
+#   rpc.py [-b baud] <port> info
+#   rpc.py [-b baud] <port> flread <floffset> <length> <file>
+#   rpc.py [-b baud] <port> flwrite <floffset> <file>
+#   rpc.py [-b baud] <port> flsync <floffset> <file>
+#   rpc.py [-b baud] <port> flsparse <image.simg>
+#   rpc.py [-b baud] <port> flerase <floffset> <length>
+#   rpc.py [-b baud] <port> flsha <floffset> <length>
+#   rpc.py [-b baud] <port> audit [expected.txt]
+#   rpc.py [-b baud] <port> md <ramaddr> <length>
+#   rpc.py [-b baud] <port> reset
+#
+# The loader only listens during the first 20 ms of stage 1, in builds with
+# BOOT_CLI. With --catch the magic is sent over and over for that many
+# seconds, reset the board meanwhile and its boot stops in machine mode. md
+# only reaches the stage 2 load window at 0x80500000.
+
+import sys
+import time
+import struct
+import hashlib
+import binascii
+import argparse
+import loadx
+import flashmap
+
+MAGIC = b'\x16\x16\x10\x02'
+
+INFO = b'i'
+FLASH_READ = b'r'
+FLASH_WRITE = b'w'
+FLASH_ERASE = b'e'
+FLASH_SHA256 = b'h'
+FLASH_HASHES = b'H'
+FLASH_UPDATE = b'u'
+MEM_READ = b'R'
+MEM_WRITE = b'W'
+RESET = b'x'
+QUIT = b'q'
+
+ERRORS = {1: 'unknown request', 2: 'bad arguments', 3: 'out of range',
+          4: 'verify failed', 5: 'flash read failed'}
+
+SECTOR = 4096
+SECTOR_HASH_LEN = 16
+ERASED = b'\xff' * SECTOR
+RETRIES = 5
+TIMEOUT = 1.0
+# Magic repeat time with --catch, well inside the stage 1 key window
+CATCH_INTERVAL = 0.005
+# Worst case 64 KB block erase and 4 KB sector erase plus programming, and
+# flash hashing speed in bytes/s
+ERASE_BLOCK_TIME = 2.0
+UPDATE_TIME = 0.5
+HASH_RATE = 1000000
+
+
+PARTITIONS = flashmap.PARTITIONS
+
+
+class RpcError(Exception):
+    pass
+
+
+class Loader(object):
+    """Loader in machine mode, enter() is called on creation"""
+
+    def __init__(self, port, retries=RETRIES, timeout=TIMEOUT, catch=0):
+        self.port = port
+        self.rx = loadx.FrameReader(port)
+        self.retries = retries
+        if catch:
+            self.catch(catch)
+        else:
+            self.enter(timeout)
+
+    def _wait(self, op, offset, timeout):
+        deadline = time.time() + timeout
+        while True:
+            f = self.rx.frame(max(0, deadline - time.time()))
+            if not f:
+                return None
+            if (f[0] in (loadx.ACK, loadx.NAK) and f[3] == op and
+                    f[1] == offset):
+                return f
+
+    def enter(self, timeout=TIMEOUT):
+        for _ in range(self.retries):
+            self.port.write(MAGIC)
+            f = self._wait(INFO, 0, timeout)
+            if f:
+                self._info(f[2])
+                return
+        raise RpcError('loader does not answer the machine mode magic')
+
+    def catch(self, timeout):
+        """Stop the boot of a board reset within timeout seconds"""
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            self.port.write(MAGIC)
+            f = self._wait(INFO, 0, CATCH_INTERVAL)
+            if f:
+                self._info(f[2])
+                return
+        raise RpcError('no loader boot caught in %g s' % timeout)
+
+    def _info(self, payload):
+        self.version, self.data_max, self.baud = struct.unpack(
+            '<HHI', payload[:8])
+
+    def request(self, op, offset, payload=b'', timeout=TIMEOUT):
+        frame = loadx.pack_frame(op, offset, payload)
+        for _ in range(self.retries):
+            self.port.write(frame)
+            f = self._wait(op, offset, timeout + self._line_time(
+                len(frame) + self.data_max))
+            if not f:
+                continue
+            if f[0] == loadx.NAK:
+                code, = struct.unpack('<I', f[2][:4])
+                raise RpcError('%s at 0x%x: %s' % (
+                    op.decode(), offset, ERRORS.get(code, str(code))))
+            return f[2]
+        raise RpcError('no answer to %s at 0x%x' % (op.decode(), offset))
+
+    def _line_time(self, nbytes):
+        return nbytes * 10.0 / (self.port.baud or 115200)
+
+    def info(self):
+        self._info(self.request(INFO, 0))
+        return {'version': self.version, 'data_max': self.data_max,
+                'baud': self.baud}
+
+    def _read(self, op, addr, length):
+        out = b''
+        while len(out) < length:
+            n = min(self.data_max, length - len(out))
+            out += self.request(op, addr + len(out), struct.pack('<I', n))
+        return out
+
+    def _write(self, op, addr, data):
+        for i in range(0, len(data), self.data_max):
+            self.request(op, addr + i, data[i:i + self.data_max])
+
+    def flash_read(self, floffset, length):
+        return self._read(FLASH_READ, floffset, length)
+
+    def flash_write(self, floffset, data):
+        """Program erased flash"""
+        self._write(FLASH_WRITE, floffset, data)
+
+    def flash_erase(self, floffset, length):
+        length = (length + SECTOR - 1) // SECTOR * SECTOR
+        blocks = (length + 65535) // 65536 + 1
+        self.request(FLASH_ERASE, floffset, struct.pack('<I', length),
+                     TIMEOUT + blocks * ERASE_BLOCK_TIME)
+
+    def flash_sha256(self, floffset, length):
+        return self.request(FLASH_SHA256, floffset,
+                            struct.pack('<I', length),
+                            TIMEOUT + float(length) / HASH_RATE)
+
+    def flash_hashes(self, floffset, length):
+        """Truncated SHA256 of each 4 KB sector, length in whole sectors"""
+        if self.version < 2:
+            raise RpcError('loader has no sector hashes')
+        per = self.data_max // SECTOR_HASH_LEN * SECTOR
+        out = []
+        for off in range(floffset, floffset + length, per):
+            n = min(per, floffset + length - off)
+            h = self.request(FLASH_HASHES, off, struct.pack('<I', n),
+                             TIMEOUT + float(n) / HASH_RATE)
+            out += [h[i:i + SECTOR_HASH_LEN]
+                    for i in range(0, len(h), SECTOR_HASH_LEN)]
+        return out
+
+    def flash_update(self, floffset, sector):
+        """Erase, program and verify one 4 KB sector"""
+        self.request(FLASH_UPDATE, floffset, sector,
+                     TIMEOUT + UPDATE_TIME + self._line_time(len(sector)))
+
+    def flash_sync(self, floffset, data, log=None, hashes=None):
+        """Program the sectors which differ from data, padded with 0xff to
+        a whole sector. hashes are those of flashmap.sector_hashes(data)
+        when already known. Returns (sectors programmed, sectors)."""
+        data += b'\xff' * (-len(data) % SECTOR)
+        if hashes is None:
+            hashes = flashmap.sector_hashes(data)
+        remote = self.flash_hashes(floffset, len(data))
+        changed = [i for i, h in enumerate(remote) if hashes[i] != h]
+        for n, i in enumerate(changed):
+            sector = data[i * SECTOR:(i + 1) * SECTOR]
+            # an erased sector needs no data on the line
+            if sector == ERASED:
+                self.flash_erase(floffset + i * SECTOR, SECTOR)
+            else:
+                self.flash_update(floffset + i * SECTOR, sector)
+            if log:
+                log(n + 1, len(changed))
+        return len(changed), len(remote)
+
+    def flash_sparse(self, extents, log=None):
+        """Program the extents of a sparse image, see flashmap.py. An extent
+        whose SHA256 on the loader matches costs one request, the others go
+        through flash_sync(). Returns (sectors programmed, sectors)."""
+        done = count = 0
+        for name, off, data, digest, hashes in extents:
+            count += len(hashes)
+            if self.flash_sha256(off, len(data)) == digest:
+                if log:
+                    log(name, 0, len(hashes))
+                continue
+            n, _ = self.flash_sync(off, data, hashes=hashes)
+            done += n
+            if self.flash_sha256(off, len(data)) != digest:
+                raise RpcError('flash content does not match %s' % name)
+            if log:
+                log(name, n, len(hashes))
+        return done, count
+
+    def mem_read(self, addr, length):
+        return self._read(MEM_READ, addr, length)
+
+    def mem_write(self, addr, data):
+        self._write(MEM_WRITE, addr, data)
+
+    def reset(self):
+        self.request(RESET, 0)
+
+    def quit(self):
+        """Back to the text CLI"""
+        self.request(QUIT, 0)
+
+
+def load_digests(path):
+    """name -> hex SHA256 from a saved audit or "flsha all" capture"""
+    digests = {}
+    for line in open(path):
+        f = line.strip().split(',' if ',' in line else None)
+        if len(f) >= 5 and f[0] == 'flsha':
+            digests[f[1]] = f[4]
+        elif len(f) >= 4:
+            digests[f[0]] = f[3]
+    return digests
+
+
+def audit(ldr, expected):
+    """Hash every partition on the loader, returns the mismatch count"""
+    bad = 0
+    for name, off, length in PARTITIONS:
+        digest = binascii.hexlify(ldr.flash_sha256(off, length)).decode()
+        state = ''
+        if name in expected:
+            ok = expected[name] == digest
+            state = ' ok' if ok else ' MISMATCH'
+            bad += not ok
+        print('%-10s 0x%06x 0x%06x %s%s' % (name, off, length, digest,
+                                             state))
+    return bad
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Loader machine mode')
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('port')
+    parser.add_argument('--fast', type=int, default=0, metavar='MAX',
+                        help='negotiate a rate up to MAX first')
+    parser.add_argument('--catch', type=float, default=0, metavar='SECONDS',
+                        help='stop the boot of a board reset meanwhile')
+    parser.add_argument('cmd', choices=['info', 'flread', 'flwrite',
+                                        'flsync', 'flsparse', 'flerase',
+                                        'flsha',
+                                        'audit', 'md', 'reset'])
+    parser.add_argument('args', nargs='*')
+    args = parser.parse_args()
+    a = args.args
+
+    port = loadx.Port(args.port, args.baud)
+    try:
+        ldr = None
+        if args.catch:
+            ldr = Loader(port, catch=args.catch)
+        if args.fast:
+            if ldr:
+                # The rate is negotiated at the prompt
+                ldr.quit()
+            loadx.negotiate(port, loadx.FrameReader(port), args.fast)
+            ldr = None
+        if not ldr:
+            ldr = Loader(port)
+        if args.cmd == 'info':
+            info = ldr.info()
+            print('version %(version)d, %(data_max)d bytes per request, '
+                  '%(baud)d baud' % info)
+        elif args.cmd == 'flread':
+            data = ldr.flash_read(int(a[0], 16), int(a[1], 16))
+            open(a[2], 'wb').write(data)
+        elif args.cmd == 'flwrite':
+            data = open(a[1], 'rb').read()
+            off = int(a[0], 16)
+            ldr.flash_erase(off, len(data))
+            ldr.flash_write(off, data)
+            if ldr.flash_sha256(off, len(data)) != \
+                    hashlib.sha256(data).digest():
+                raise RpcError('flash content does not match %s' % a[1])
+        elif args.cmd == 'flsync':
+            data = open(a[1], 'rb').read()
+            off = int(a[0], 16)
+            start = time.time()
+
+            def log(done, count):
+                sys.stdout.write('\r%d/%d sectors' % (done, count))
+                sys.stdout.flush()
+
+            done, count = ldr.flash_sync(off, data, log)
+            data += b'\xff' * (-len(data) % SECTOR)
+            if ldr.flash_sha256(off, len(data)) != \
+                    hashlib.sha256(data).digest():
+                raise RpcError('flash content does not match %s' % a[1])
+            print('\n%d of %d sectors programmed in %.2f s' %
+                  (done, count, time.time() - start))
+        elif args.cmd == 'flsparse':
+            extents = flashmap.read_sparse(a[0])
+            start = time.time()
+
+            def log(name, done, count):
+                print('%-10s %4d of %4d sectors programmed' %
+                      (name, done, count))
+
+            done, count = ldr.flash_sparse(extents, log)
+            print('%d of %d sectors programmed in %.2f s' %
+                  (done, count, time.time() - start))
+        elif args.cmd == 'flerase':
+            ldr.flash_erase(int(a[0], 16), int(a[1], 16))
+        elif args.cmd == 'flsha':
+            digest = ldr.flash_sha256(int(a[0], 16), int(a[1], 16))
+            print(binascii.hexlify(digest).decode())
+        elif args.cmd == 'audit':
+            if audit(ldr, load_digests(a[0]) if a else {}):
+                ldr.quit()
+                raise RpcError('flash content differs from %s' % a[0])
+        elif args.cmd == 'md':
+            data = ldr.mem_read(int(a[0], 16), int(a[1], 16))
+            print(binascii.hexlify(data).decode())
+        elif args.cmd == 'reset':
+            ldr.reset()
+            return
+        ldr.quit()
+    except (RpcError, IndexError, ValueError, IOError) as e:
+        print('rpc: %s' % e)
+        sys.exit(1)
+    finally:
+        port.close()
+
+
+if __name__ == '__main__':
+    main()
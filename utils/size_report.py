@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Size report of the loader stages: loaded sections, the .text.hot region
+# against the I-cache, and the loader.img slot each stage takes against its
+# 64K budget. The exit status is 1 when a stage does not fit.
+#
+# Usage: size_report.py [--signed] <loader_stage1> <loader_stage2>
+
+import sys
+import struct
+import argparse
+
+SLOT_SIZE = 64 * 1024
+ICACHE_SIZE = 32 * 1024
+# flag, length and digest, see imgfmt.py
+IMAGE_OVERHEAD = 1 + 4 + 32
+SIGN_LEN = 32 + 64
+SHF_ALLOC = 2
+SHT_NOBITS = 8
+
+
+def sections(path):
+    """(name, type, addr, size) of the allocated sections, by address"""
+    data = open(path, 'rb').read()
+    if data[:4] != b'\x7fELF' or data[5] != 1:
+        raise ValueError('%s: not a little endian ELF' % path)
+    if data[4] == 2:
+        shoff, = struct.unpack_from('<Q', data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x3a)
+        fmt = '<IIQQQQ'
+    else:
+        shoff, = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2e)
+        fmt = '<IIIIII'
+
+    raw = [struct.unpack_from(fmt, data, shoff + i * shentsize)
+           for i in range(shnum)]
+    strtab = raw[shstrndx]
+    names = data[strtab[4]:strtab[4] + strtab[5]]
+    out = []
+    for name, stype, flags, addr, off, size in raw:
+        if not flags & SHF_ALLOC or not size:
+            continue
+        name = names[name:names.index(b'\0', name)].decode()
+        out.append((name, stype, addr, size))
+    return sorted(out, key=lambda s: s[2])
+
+
+def image_size(bin_size, signed):
+    """loader.img bytes of a stage, padded as imgfmt.genimgfile() does"""
+    pad = (bin_size + IMAGE_OVERHEAD) % 64
+    if pad:
+        bin_size += 64 - pad
+    return bin_size + IMAGE_OVERHEAD + (SIGN_LEN if signed else 0)
+
+
+def report(path, signed):
+    secs = sections(path)
+    loaded = [s for s in secs if s[1] != SHT_NOBITS]
+    # objcopy -O binary spans the loaded sections, holes included
+    start = min(s[2] for s in loaded)
+    bin_size = max(s[2] + s[3] for s in loaded) - start
+    img = image_size(bin_size, signed)
+    hot = sum(s[3] for s in secs if s[0] == '.text.hot')
+    text = sum(s[3] for s in secs if s[0].startswith('.text'))
+
+    print('%s:' % path)
+    for name, stype, addr, size in secs:
+        print('  %-16s 0x%08x %7d%s' % (name, addr, size,
+                                        ' (no bits)' if stype == SHT_NOBITS
+                                        else ''))
+    print('  hot path        %7d bytes, %d%% of code, %d%% of I-cache' %
+          (hot, hot * 100 // max(text, 1), hot * 100 // ICACHE_SIZE))
+    print('  image           %7d of %d bytes, %d left' %
+          (img, SLOT_SIZE, SLOT_SIZE - img))
+    if hot > ICACHE_SIZE:
+        print('  WARNING: hot path larger than the I-cache')
+    if img > SLOT_SIZE:
+        print('  ERROR: does not fit the 64K slot')
+        return False
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Loader stage size report')
+    parser.add_argument('--signed', action='store_true',
+                        help='count the Ed25519 key and signature trailer')
+    parser.add_argument('elf', nargs='+')
+    args = parser.parse_args()
+
+    ok = True
+    for path in args.elf:
+        ok = report(path, args.signed) and ok
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == '__main__':
+    main()
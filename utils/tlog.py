@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Decode the tokenized log of the loader, see src/include/tlog.h. The format
+# strings come from the "tlog_fmt" section of the loader ELF, "%s" arguments
+# are looked up in its loaded sections.
+#
+# The log is read either from a serial port, where the "tlog" command is
+# typed, or from a file holding a capture of the command output.
+#
+# Usage:
+#   tlog.py [-b baud] [--freq hz] <elf> <port|capture>
+
+import sys
+import os
+import re
+import stat
+import struct
+import time
+import argparse
+import loadx
+
+MAGIC = 0x544C
+MAX_ARGS = 8
+HEADER = re.compile(br'## Token log core (\d+): (\d+) of (\d+) words\r?\n')
+CONV = re.compile(r'%([-+ 0#]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z)?([cdiopsuxX%])')
+
+
+class Elf(object):
+    """Just enough ELF to find sections by name and read loaded memory"""
+
+    def __init__(self, path):
+        data = open(path, 'rb').read()
+        if data[:4] != b'\x7fELF' or data[5] != 1:
+            raise ValueError('%s: not a little endian ELF' % path)
+        if data[4] == 2:
+            shoff, = struct.unpack_from('<Q', data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data,
+                                                            0x3a)
+            fmt = '<IIQQQQIIQQ'
+        else:
+            shoff, = struct.unpack_from('<I', data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data,
+                                                            0x2e)
+            fmt = '<IIIIIIIIII'
+
+        raw = [struct.unpack_from(fmt, data, shoff + i * shentsize)
+               for i in range(shnum)]
+        strtab = raw[shstrndx]
+        names = data[strtab[4]:strtab[4] + strtab[5]]
+        self.sections = {}
+        self.loaded = []
+        for name, stype, flags, addr, off, size in (s[:6] for s in raw):
+            name = names[name:names.index(b'\0', name)].decode()
+            # SHT_NOBITS has no content in the file
+            body = data[off:off + size] if stype != 8 else b''
+            self.sections[name] = body
+            if flags & 2 and body:  # SHF_ALLOC
+                self.loaded.append((addr, body))
+
+    def string(self, addr):
+        for base, body in self.loaded:
+            if base <= addr < base + len(body):
+                end = body.find(b'\0', addr - base)
+                return body[addr - base:end].decode('utf-8', 'replace')
+        return None
+
+
+def format_record(fmt, args, elf):
+    out = []
+    pos = 0
+    args = list(args)
+    for m in CONV.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        v = args.pop(0) if args else 0
+        if length not in ('l', 'll', 'z') and conv != 'p':
+            v &= 0xffffffff
+            if conv in 'di' and v & 0x80000000:
+                v -= 1 << 32
+        elif conv in 'di' and v & (1 << 63):
+            v -= 1 << 64
+        spec = '%' + flags + width + ('.' + prec if prec else '')
+        if conv == 's':
+            s = elf.string(v)
+            out.append((spec + 's') % (s if s is not None else '<0x%x>' % v))
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(v & 0xff))
+        elif conv == 'p':
+            out.append('0x%x' % v)
+        elif conv == 'u':
+            out.append((spec + 'd') % v)
+        else:
+            out.append((spec + conv) % v)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def parse_dump(buf):
+    """Return [(core, total, words)] for each complete ring in buf"""
+    rings = []
+    pos = 0
+    while True:
+        m = HEADER.search(buf, pos)
+        if not m:
+            return rings
+        core, count, total = (int(x) for x in m.groups())
+        end = m.end() + count * 8 + 4
+        if len(buf) < end:
+            return rings
+        body = buf[m.end():end - 4]
+        crc, = struct.unpack('<I', buf[end - 4:end])
+        if crc != loadx.crc32c(body):
+            raise ValueError('core %d: log CRC mismatch' % core)
+        rings.append((core, total, struct.unpack('<%dQ' % count, body)))
+        pos = end
+
+
+def records(core, total, words, fmts):
+    """Yield (cycle, core, format, args), skipping a torn first record"""
+    i = 0
+    resync = total > len(words)
+    while i + 2 <= len(words):
+        w = words[i]
+        nargs, fid = (w >> 32) & 0xffff, w & 0xffffffff
+        valid = (w >> 48 == MAGIC and nargs <= MAX_ARGS and
+                 fid < len(fmts) and (fid == 0 or fmts[fid - 1] == 0) and
+                 i + 2 + nargs <= len(words))
+        if not valid:
+            if not resync:
+                raise ValueError('core %d: bad record at word %d' % (core, i))
+            i += 1
+            continue
+        resync = False
+        end = fmts.index(b'\0', fid)
+        fmt = fmts[fid:end].decode('utf-8', 'replace')
+        yield (words[i + 1], core, fmt, words[i + 2:i + 2 + nargs])
+        i += 2 + nargs
+
+
+def read_port(path, baud):
+    port = loadx.Port(path, baud)
+    try:
+        port.flush_input()
+        loadx.type_command(port, 'tlog')
+        buf = b''
+        deadline = time.time() + 5
+        while len(parse_dump(buf)) < 2 and time.time() < deadline:
+            buf += port.read(0.2)
+    finally:
+        port.close()
+    return buf
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode the loader tlog')
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('--freq', type=int, default=0,
+                        help='cycle counter rate, print seconds not cycles')
+    parser.add_argument('elf')
+    parser.add_argument('source', help='serial port or captured output')
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    fmts = elf.sections.get('tlog_fmt')
+    if fmts is None:
+        print('%s: no tlog_fmt section, build with -D TLOG=ON' % args.elf)
+        sys.exit(1)
+
+    if stat.S_ISREG(os.stat(args.source).st_mode):
+        buf = open(args.source, 'rb').read()
+    else:
+        buf = read_port(args.source, args.baud)
+
+    try:
+        rings = parse_dump(buf)
+        recs = []
+        for core, total, words in rings:
+            recs.extend(records(core, total, words, fmts))
+    except ValueError as e:
+        print('tlog: %s' % e)
+        sys.exit(1)
+    if not rings:
+        print('tlog: no log found')
+        sys.exit(1)
+
+    for cycle, core, fmt, fargs in sorted(recs, key=lambda r: r[0]):
+        stamp = ('%12.6f' % (float(cycle) / args.freq) if args.freq else
+                 '%14d' % cycle)
+        text = format_record(fmt, fargs, elf)
+        print('%s %d %s' % (stamp, core, text.rstrip('\r\n')))
+
+
+if __name__ == '__main__':
+    main()